@@ -14,6 +14,8 @@ namespace ClassGame {
         int gameWinner = -1;
         int aiStatus = 2;
         unsigned int sessions = 0;
+        float clockSeconds = 0.0f;      // Connect4 AI1 game clock, 0 = fixed depth table
+        float incrementSeconds = 0.0f;
         //
         // game starting point
         // this is called by the main render loop in main.cpp
@@ -39,6 +41,50 @@ namespace ClassGame {
             sessions = std::max(0U, sessions);
         }
 
+        // per-ply counters of the last move of each Connect4 AI
+        void drawSearchStats(const Connect4& connect4){
+            if (!ImGui::CollapsingHeader("Search Stats")) return;
+            if (!SearchStats::ENABLED) {
+                ImGui::Text("Built without CONNECT4_SEARCH_STATS");
+                return;
+            }
+
+            for (int ai = 1; ai <= 2; ++ai) {
+                const SearchStats& stats = connect4.lastSearchStats(ai);
+                const SearchStats::Counters total = stats.total();
+                if (total.nodes == 0) continue;
+
+                ImGui::Text("AI%d: %llu nodes, %llu leaf evals, %llu cutoffs (%.0f%% first move), %llu terminal, cache %llu/%llu",
+                    ai, (unsigned long long)total.nodes, (unsigned long long)total.leafEvals, (unsigned long long)total.betaCutoffs,
+                    100.0 * SearchStats::firstMoveRate(total), (unsigned long long)total.terminalHits,
+                    (unsigned long long)total.cacheHits, (unsigned long long)total.cacheProbes);
+
+                ImGui::PushID(ai);
+                if (ImGui::BeginTable("plies", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+                    ImGui::TableSetupColumn("Ply");
+                    ImGui::TableSetupColumn("Nodes");
+                    ImGui::TableSetupColumn("Leaf");
+                    ImGui::TableSetupColumn("Cutoffs");
+                    ImGui::TableSetupColumn("First %");
+                    ImGui::TableSetupColumn("Terminal");
+                    ImGui::TableHeadersRow();
+
+                    for (int ply = 1; ply <= stats.maxPly; ++ply) {
+                        const SearchStats::Counters& c = stats.ply[ply];
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn(); ImGui::Text("%d", ply);
+                        ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)c.nodes);
+                        ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)c.leafEvals);
+                        ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)c.betaCutoffs);
+                        ImGui::TableNextColumn(); ImGui::Text("%.0f", 100.0 * SearchStats::firstMoveRate(c));
+                        ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)c.terminalHits);
+                    }
+                    ImGui::EndTable();
+                }
+                ImGui::PopID();
+            }
+        }
+
         //
         // game render loop
         // this is called by the main render loop in main.cpp
@@ -84,7 +130,9 @@ namespace ClassGame {
                     }
                     ImGui::SameLine();
                     if (ImGui::Button("Start Connect4")) {
-                        game = new Connect4(aiStatus);
+                        Connect4* connect4 = new Connect4(aiStatus);
+                        connect4->setClock(clockSeconds * 1000.0, incrementSeconds * 1000.0);
+                        game = connect4;
                         game->setUpBoard();
                     }
                     
@@ -97,11 +145,56 @@ namespace ClassGame {
                         sessions = 0;
                     }
 
+                    ImGui::SetNextItemWidth(120);
+                    ImGui::InputFloat("Clock (s)", &clockSeconds);
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(120);
+                    ImGui::InputFloat("Increment (s)", &incrementSeconds);
+                    clockSeconds = std::max(0.0f, clockSeconds);
+                    incrementSeconds = std::max(0.0f, incrementSeconds);
+
 
                 } else {
                     ImGui::Text("Current Player Number: %d", game->getCurrentPlayer()->playerNumber());
                     ImGui::Text("Current Board State: %s", game->stateString().c_str());
 
+                    if (Connect4* connect4 = dynamic_cast<Connect4*>(game)) {
+                        bool showAnalysis = connect4->analysisEnabled();
+                        if (ImGui::Checkbox("Show Analysis", &showAnalysis)) {
+                            connect4->setAnalysisEnabled(showAnalysis);
+                        }
+                        ImGui::SameLine();
+                        bool parallel = connect4->parallelSearch();
+                        if (ImGui::Checkbox("Parallel Search", &parallel)) {
+                            connect4->setParallelSearch(parallel);
+                        }
+                        ImGui::SameLine();
+                        bool trace = connect4->traceEnabled();
+                        if (ImGui::Checkbox("Trace Search", &trace)) {
+                            connect4->setTraceEnabled(trace);
+                        }
+                        if (trace) {
+                            ImGui::SameLine();
+                            if (ImGui::Button("Dump Trace")) {
+                                connect4->dumpTrace();
+                            }
+                        }
+                        if (gameOver) {
+                            ImGui::SameLine();
+                            if (ImGui::Button("Review Game")) {
+                                connect4->reviewGame();
+                            }
+                        }
+                        drawSearchStats(*connect4);
+                    }
+
+                    if (Othello* othello = dynamic_cast<Othello*>(game)) {
+                        bool animate = othello->animateFlips();
+                        if (ImGui::Checkbox("Animate Flips", &animate)) {
+                            othello->setAnimateFlips(animate);
+                        }
+                    }
+
                     if (ImGui::Button("Reset Game")) {
                         game->stopGame();
                         game->setUpBoard();
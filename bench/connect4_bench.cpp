@@ -0,0 +1,399 @@
+// Connect4 engine benchmarks: per-kernel microbenchmarks plus fixed depth searches over a checked-in suite
+//
+//   connect4_bench [--suite file] [--baseline file] [--write-baseline file] [--tolerance pct] [--micro-only] [--search-only] [--variants]
+//
+// results are compared against the baseline json (bench/connect4_baseline.json by default),
+// anything slower than the tolerance is flagged and makes the run exit with 1
+// build with CMAKE_BUILD_TYPE=Release and ENABLE_SEARCH_STATS=OFF, the baseline was taken that way
+// --variants also searches the empty 8x7, 9x7 and 10x8 boards, printed only, they are not in the baseline
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../classes/Connect4Engine.h"
+#include "../classes/PerfCounters.h"
+
+#ifndef CONNECT4_BENCH_DIR
+#define CONNECT4_BENCH_DIR "bench"
+#endif
+
+namespace{
+
+constexpr int MICRO_BOARDS = 4096;
+constexpr int MICRO_ROUNDS = 2000;
+constexpr double MIN_COMPARE_MS = 5.0;     // shorter searches are mostly timer noise, shown but never flagged
+constexpr int VARIANT_DEPTH = 8;
+
+struct Options{
+    std::string suite = CONNECT4_BENCH_DIR "/connect4_positions.txt";
+    std::string baseline = CONNECT4_BENCH_DIR "/connect4_baseline.json";
+    std::string writeBaseline;
+    double tolerance = 15.0;
+    bool micro = true;
+    bool search = true;
+    bool variants = false;
+};
+
+struct SuitePosition{
+    std::string name;
+    uint64_t red;
+    uint64_t yellow;
+    Connect4Engine::Color toMove;
+    int depth;
+};
+
+struct SearchResult{
+    int depth;
+    uint64_t nodes;
+    double ms;
+};
+
+struct Results{
+    std::map<std::string, double> micro;            // ns per call
+    std::map<std::string, SearchResult> search;
+};
+
+// keeps the optimizer from deleting the measured loops
+volatile uint64_t sink;
+
+double msSince(const std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+std::vector<Connect4Engine::Board> randomBoards(const int count){
+    std::mt19937 rng(7);
+    std::vector<Connect4Engine::Board> boards;
+    boards.reserve(count);
+
+    while(static_cast<int>(boards.size()) < count){
+        Connect4Engine::Board board{{0, 0}};
+        const int plies = rng() % 43;
+        for(int ply = 0; ply < plies; ++ply){
+            const int idx = Connect4Engine::landingCell(board.pieces[0] | board.pieces[1], rng() % 7);
+            if(idx < 0) continue;
+            board.pieces[ply & 1] |= Connect4Engine::cellMask(idx);
+        }
+        boards.push_back(board);
+    }
+
+    return boards;
+}
+
+template <class Kernel>
+double timeKernel(const std::vector<Connect4Engine::Board>& boards, Kernel kernel){
+    uint64_t acc = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for(int round = 0; round < MICRO_ROUNDS; ++round)
+        for(const auto& board : boards)
+            acc += kernel(board);
+
+    const auto end = std::chrono::steady_clock::now();
+    sink = acc;
+    return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(MICRO_ROUNDS) * boards.size());
+}
+
+void runMicro(Results& results){
+    const auto boards = randomBoards(MICRO_BOARDS);
+    Connect4Engine engine;
+
+    results.micro["comboWon"] = timeKernel(boards, [](const Connect4Engine::Board& b){
+        return static_cast<uint64_t>(Connect4Engine::comboWon(b.pieces[0])) + Connect4Engine::comboWon(b.pieces[1]);
+    });
+
+    results.micro["moveIsLegal"] = timeKernel(boards, [](const Connect4Engine::Board& b){
+        const uint64_t occupied = b.pieces[0] | b.pieces[1];
+        uint64_t legal = 0;
+        for(int i = 0; i < 42; ++i) legal += Connect4Engine::moveIsLegal(occupied, i);
+        return legal;
+    }) / 42.0;
+
+    // the in-place bit set/clear the search does on every move
+    results.micro["makeMove"] = timeKernel(boards, [&engine](const Connect4Engine::Board& b){
+        engine.setBoard(b.pieces[0], b.pieces[1]);
+        const int idx = static_cast<int>(b.pieces[0] % 42);
+        engine.makeMove(Connect4Engine::RED, idx);
+        engine.unmakeMove(Connect4Engine::RED, idx);
+        return engine.board().pieces[Connect4Engine::RED];
+    });
+
+    results.micro["evalBoardState"] = timeKernel(boards, [&engine](const Connect4Engine::Board& b){
+        return static_cast<uint64_t>(engine.evalBoardState(b, Connect4Engine::RED));
+    });
+
+    results.micro["checkForWinner"] = timeKernel(boards, [](const Connect4Engine::Board& b){
+        return static_cast<uint64_t>(Connect4Engine::winner(b) + 1);
+    });
+
+    std::printf("%-16s %10s\n", "kernel", "ns/call");
+    for(const auto& [name, ns] : results.micro)
+        std::printf("%-16s %10.2f\n", name.c_str(), ns);
+    std::printf("\n");
+}
+
+
+bool loadSuite(const std::string& path, std::vector<SuitePosition>& suite){
+    std::ifstream in(path);
+    if(!in) return false;
+
+    std::string line;
+    while(std::getline(in, line)){
+        if(line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        SuitePosition pos;
+        int toMove;
+        fields >> pos.name >> std::hex >> pos.red >> pos.yellow >> std::dec >> toMove >> pos.depth;
+        if(!fields) continue;
+
+        pos.toMove = static_cast<Connect4Engine::Color>(toMove != 0);
+        suite.push_back(pos);
+    }
+
+    return !suite.empty();
+}
+
+// iterative deepening up to the position's depth, prints the time at which every depth finished
+void runSearch(const std::vector<SuitePosition>& suite, Results& results){
+    Connect4Engine engine;
+    PerfCounters perf;
+    std::vector<std::pair<PerfCounters::Sample, uint64_t>> samples;
+    uint64_t totalNodes = 0;
+    double totalMs = 0;
+
+    std::printf("%-6s %5s %12s %10s %10s  time to depth (ms)\n", "pos", "depth", "nodes", "ms", "knodes/s");
+    for(const auto& pos : suite){
+        engine.setBoard(pos.red, pos.yellow);
+        uint64_t nodes = 0;
+        std::string timeToDepth;
+
+        const auto start = std::chrono::steady_clock::now();
+        perf.start();
+        for(int d = 0; d <= pos.depth; ++d){
+            engine.searchRoot(pos.toMove, d);
+            nodes += engine.nodes();
+            engine.setBoard(pos.red, pos.yellow);
+
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), " %.1f", msSince(start));
+            timeToDepth += buf;
+        }
+        samples.push_back({perf.stop(), nodes});
+        const double ms = msSince(start);
+
+        results.search[pos.name] = {pos.depth, nodes, ms};
+        totalNodes += nodes;
+        totalMs += ms;
+
+        std::printf("%-6s %5d %12llu %10.1f %10.0f %s\n", pos.name.c_str(), pos.depth,
+            static_cast<unsigned long long>(nodes), ms, ms > 0 ? nodes / ms : 0.0, timeToDepth.c_str());
+    }
+
+    std::printf("%-6s %5s %12llu %10.1f %10.0f\n\n", "total", "", static_cast<unsigned long long>(totalNodes),
+        totalMs, totalMs > 0 ? totalNodes / totalMs : 0.0);
+
+    if(!perf.available()){
+        std::printf("hardware counters unavailable (%s)\n\n", perf.error().c_str());
+        return;
+    }
+
+    // missing counters print as 0
+    std::printf("%-6s %6s %12s %12s %12s %12s\n", "pos", "IPC", "cycles/node", "brmiss/node", "L1Dmiss/node", "LLCmiss/node");
+    for(size_t i = 0; i < suite.size(); ++i){
+        const auto& [sample, nodes] = samples[i];
+        std::printf("%-6s %6.2f %12.1f %12.2f %12.2f %12.3f\n", suite[i].name.c_str(), sample.ipc(),
+            sample.perNode(PerfCounters::CYCLES, nodes), sample.perNode(PerfCounters::BRANCH_MISSES, nodes),
+            sample.perNode(PerfCounters::L1D_MISSES, nodes), sample.perNode(PerfCounters::LLC_MISSES, nodes));
+    }
+    std::printf("\n");
+}
+
+
+// empty board search of another board size, same search code as the 7x6 game
+template <int W, int H, int N>
+void runVariant(const int depth){
+    BasicConnect4Engine<W, H, N> engine;
+    engine.setBoard(0, 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = engine.searchRoot(BasicConnect4Engine<W, H, N>::RED, depth);
+    const double ms = msSince(start);
+
+    std::printf("%2dx%-3d %5d %12llu %10.1f %10.0f   best column %d\n", W, H, depth, static_cast<unsigned long long>(engine.nodes()),
+        ms, ms > 0 ? engine.nodes() / ms : 0.0, result.bestMoveIdx % W);
+}
+
+void runVariants(){
+    std::printf("%-6s %5s %12s %10s %10s\n", "board", "depth", "nodes", "ms", "knodes/s");
+    runVariant<7, 6, 4>(VARIANT_DEPTH);
+    runVariant<8, 7, 4>(VARIANT_DEPTH);
+    runVariant<9, 7, 4>(VARIANT_DEPTH);
+    runVariant<10, 8, 4>(VARIANT_DEPTH);
+    std::printf("\n");
+}
+
+
+// the baseline is written by writeBaseline() below, one entry per line, so no general json parser is needed
+double jsonNumber(const std::string& line, const std::string& key){
+    const std::string quoted = "\"" + key + "\":";
+    const size_t pos = line.find(quoted);
+    if(pos == std::string::npos) return -1;
+    return std::strtod(line.c_str() + pos + quoted.size(), nullptr);
+}
+
+std::string jsonFirstKey(const std::string& line){
+    const size_t open = line.find('"');
+    if(open == std::string::npos) return "";
+    const size_t close = line.find('"', open + 1);
+    if(close == std::string::npos) return "";
+    return line.substr(open + 1, close - open - 1);
+}
+
+bool loadBaseline(const std::string& path, Results& baseline){
+    std::ifstream in(path);
+    if(!in) return false;
+
+    std::string line, section;
+    while(std::getline(in, line)){
+        const std::string key = jsonFirstKey(line);
+        if(key.empty()) continue;
+
+        if(line.find('{') != std::string::npos && line.find("\"depth\"") == std::string::npos){
+            section = key;
+            continue;
+        }
+
+        if(section == "micro_ns_per_call")
+            baseline.micro[key] = jsonNumber(line, key);
+        else if(section == "search")
+            baseline.search[key] = {static_cast<int>(jsonNumber(line, "depth")),
+                                    static_cast<uint64_t>(jsonNumber(line, "nodes")),
+                                    jsonNumber(line, "ms")};
+    }
+
+    return true;
+}
+
+bool writeBaseline(const std::string& path, const Results& results){
+    std::ofstream out(path);
+    if(!out) return false;
+
+    out << "{\n  \"micro_ns_per_call\": {\n";
+    size_t i = 0;
+    for(const auto& [name, ns] : results.micro)
+        out << "    \"" << name << "\": " << ns << (++i < results.micro.size() ? ",\n" : "\n");
+
+    out << "  },\n  \"search\": {\n";
+    i = 0;
+    for(const auto& [name, r] : results.search)
+        out << "    \"" << name << "\": {\"depth\": " << r.depth << ", \"nodes\": " << r.nodes << ", \"ms\": " << r.ms << "}"
+            << (++i < results.search.size() ? ",\n" : "\n");
+
+    out << "  }\n}\n";
+    return true;
+}
+
+const char* verdict(const double now, const double before, const double tolerance){
+    if(now > before * (1 + tolerance / 100)) return "SLOWER";
+    if(now < before * (1 - tolerance / 100)) return "faster";
+    return "";
+}
+
+// returns the number of regressions
+int compare(const Results& results, const Results& baseline, const double tolerance){
+    int slower = 0;
+    std::printf("%-16s %12s %12s %8s\n", "vs baseline", "now", "baseline", "change");
+
+    for(const auto& [name, ns] : results.micro){
+        auto it = baseline.micro.find(name);
+        if(it == baseline.micro.end() || it->second <= 0) continue;
+
+        const char* v = verdict(ns, it->second, tolerance);
+        slower += v[0] == 'S';
+        std::printf("%-16s %10.2fns %10.2fns %+7.1f%% %s\n", name.c_str(), ns, it->second, 100 * (ns / it->second - 1), v);
+    }
+
+    for(const auto& [name, r] : results.search){
+        auto it = baseline.search.find(name);
+        if(it == baseline.search.end() || it->second.ms <= 0) continue;
+
+        const char* v = it->second.ms < MIN_COMPARE_MS ? "" : verdict(r.ms, it->second.ms, tolerance);
+        slower += v[0] == 'S';
+        std::printf("%-16s %10.1fms %10.1fms %+7.1f%% %s", name.c_str(), r.ms, it->second.ms, 100 * (r.ms / it->second.ms - 1), v);
+
+        // a different tree is not a regression on its own, but the time comparison is no longer like for like
+        if(r.depth != it->second.depth || r.nodes != it->second.nodes)
+            std::printf(" (nodes %llu, baseline %llu)", static_cast<unsigned long long>(r.nodes), static_cast<unsigned long long>(it->second.nodes));
+        std::printf("\n");
+    }
+
+    return slower;
+}
+
+bool parseOptions(int argc, char** argv, Options& opt){
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--suite") && hasValue) opt.suite = argv[++i];
+        else if(!std::strcmp(argv[i], "--baseline") && hasValue) opt.baseline = argv[++i];
+        else if(!std::strcmp(argv[i], "--write-baseline") && hasValue) opt.writeBaseline = argv[++i];
+        else if(!std::strcmp(argv[i], "--tolerance") && hasValue) opt.tolerance = std::atof(argv[++i]);
+        else if(!std::strcmp(argv[i], "--micro-only")) opt.search = false;
+        else if(!std::strcmp(argv[i], "--search-only")) opt.micro = false;
+        else if(!std::strcmp(argv[i], "--variants")) opt.variants = true;
+        else{
+            std::fprintf(stderr, "usage: %s [--suite file] [--baseline file] [--write-baseline file] [--tolerance pct] [--micro-only] [--search-only] [--variants]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    Options opt;
+    if(!parseOptions(argc, argv, opt)) return 2;
+
+    if(SearchStats::ENABLED)
+        std::printf("built with CONNECT4_SEARCH_STATS, search timings include the counters\n\n");
+
+    Results results;
+    if(opt.micro) runMicro(results);
+
+    if(opt.search){
+        std::vector<SuitePosition> suite;
+        if(!loadSuite(opt.suite, suite)){
+            std::fprintf(stderr, "could not read position suite %s\n", opt.suite.c_str());
+            return 2;
+        }
+        runSearch(suite, results);
+    }
+    if(opt.variants) runVariants();
+
+    if(!opt.writeBaseline.empty()){
+        if(!writeBaseline(opt.writeBaseline, results)){
+            std::fprintf(stderr, "could not write %s\n", opt.writeBaseline.c_str());
+            return 2;
+        }
+        std::printf("baseline written to %s\n", opt.writeBaseline.c_str());
+        return 0;
+    }
+
+    Results baseline;
+    if(!loadBaseline(opt.baseline, baseline)){
+        std::printf("no baseline at %s, run with --write-baseline to create one\n", opt.baseline.c_str());
+        return 0;
+    }
+
+    return compare(results, baseline, opt.tolerance) > 0 ? 1 : 0;
+}
@@ -85,8 +85,54 @@ void Bit::moveTo(const ImVec2 &point)
 	_moving = true;
 }
 
+void Bit::flipTo(Player *owner, ImTextureID texture, bool animate)
+{
+	_owner = owner;
+	// a second flip before the first one ends starts from the finished first one
+	if (_flipFrame > 0)
+	{
+		finishFlip();
+	}
+	if (!animate)
+	{
+		setTexture(texture);
+		return;
+	}
+	_flipTexture = texture;
+	_flipWidth = getSize().x;
+	_flipLeft = getPosition().x;
+	_flipFrame = kFlipFrames;
+}
+
+void Bit::finishFlip()
+{
+	setTexture(_flipTexture);
+	setSize(_flipWidth, getSize().y);
+	setPosition(_flipLeft, getPosition().y);
+	_flipFrame = 0;
+}
+
 void Bit::update()
 {
+	if (_flipFrame > 0)
+	{
+		// the width follows |cos| of the turn, the face changes while the disc is edge-on
+		const float half = kFlipFrames / 2.0f;
+		if (--_flipFrame == 0)
+		{
+			finishFlip();
+		}
+		else
+		{
+			if (_flipFrame <= half)
+			{
+				setTexture(_flipTexture);
+			}
+			const float width = _flipWidth * std::fabs(_flipFrame - half) / half;
+			setSize(width, getSize().y);
+			setPosition(_flipLeft + (_flipWidth - width) / 2, getPosition().y);
+		}
+	}
 	if (!_moving)
 	{
 		return;
@@ -10,6 +10,8 @@ class BitHolder;
 //
 #define kPickedUpScale 1.2f
 #define kPickedUpOpacity 255
+// frames a flip takes, the first half squeezes the old face edge-on and the second opens the new one
+#define kFlipFrames 16
 
 enum bitz
 {
@@ -29,6 +31,7 @@ public:
 		_gameTag = 0;
 		_entityType = EntityBit;
 		_moving = false;
+		_flipFrame = 0;
 	};
 
 	~Bit();
@@ -52,7 +55,9 @@ public:
 	void moveTo(const ImVec2 &point);
 	void update();
 	void setOpacity(float opacity){};
-	bool getMoving() { return _moving; };
+	bool getMoving() { return _moving || _flipFrame > 0; };
+	// turn the bit over in place: new owner and face, optionally animated by update()
+	void flipTo(Player *owner, ImTextureID texture, bool animate);
 
 private:
 	int _restingZ;
@@ -63,4 +68,9 @@ private:
 	ImVec2 _destinationPosition;
 	ImVec2 _destinationStep;
 	bool _moving;
+	void finishFlip();
+	int _flipFrame;
+	ImTextureID _flipTexture;
+	float _flipWidth;
+	float _flipLeft;
 };
@@ -38,9 +38,22 @@ Connect4::Connect4(int aiPlayer){
     _board.pieces[YELLOW] = 0;
     
     ai2GoesFirst = aiPlayer == 3? random01(): false;
+
+    // the network is optional, AI1 falls back to evalBoardState without a weight file
+    _engine.loadNNUE(NNUE_WEIGHTS_PATH);
+    _exportTrainingData = aiPlayer == 3;
+    _showAnalysis = false;
+    _clockTotalMs = 0;
+    _clockIncrementMs = 0;
+    _ai2RootDepth = 0;
+    _traceEnabled = false;
+    _parallelSearch = false;
     
 }
 Connect4::~Connect4(){
+    _analysis.stop();
+    _trainingWrites.wait();
+    if(_trainingWriteFailed) log(Error, "GEN TrainingDataWriteFailed");
     delete _grid;
 }
 
@@ -48,6 +61,9 @@ Connect4::~Connect4(){
 void Connect4::setUpBoard() {
 
     log(Debug, "GEN firstAI: " + numToStr(static_cast<int>(ai2GoesFirst)));
+    log(Debug, "GEN NNUE: " + numToStr(static_cast<int>(_engine.usingNNUE())));
+    log(Debug, "GEN PerfCounters: " + numToStr(static_cast<int>(_perf.available())));
+    if(!_perf.error().empty()) log(Debug, "GEN PerfCountersMissing: " + _perf.error());
     setNumberOfPlayers(2);
     if(aiPlayer == 1 || aiPlayer == 2)
         setAIPlayer(aiPlayer-1);
@@ -59,25 +75,17 @@ void Connect4::setUpBoard() {
     
     _gameOptions.rowX = 7;
     _gameOptions.rowY = 6;
+    _clock.newGame(_clockTotalMs, _clockIncrementMs);
     _grid->initializeSquares(80, "boardsquare.png");
 
     
     startGame();
+    restartAnalysis();
 }
 
 Player* Connect4::checkForWinner(){
-    for(int i = 0; i < 69; ++i)
-        if((WINNING_PATTERNS[i] & _board.pieces[RED]) == WINNING_PATTERNS[i]){
-            return getPlayerAt(RED);
-        }
-
-    for(int i = 0; i < 69; ++i)
-        if((WINNING_PATTERNS[i] & _board.pieces[YELLOW]) == WINNING_PATTERNS[i]){
-            return getPlayerAt(YELLOW);
-        }
-
-    return nullptr;
-    
+    const int color = Connect4Engine::winner({_board.pieces});
+    return color < 0 ? nullptr : getPlayerAt(color);
 }
 
 bool Connect4::checkForDraw(){
@@ -112,6 +120,8 @@ bool Connect4::actionForEmptyHolder(BitHolder &holder){
         bit->setPosition(holder.getPosition());
         holder.setBit(bit);
         setBitInPlace(_board.pieces[getCurrentPlayer()->playerNumber()], cordsGridToBoard(getHolderCords(holder)), true);
+        _gamePositions.push_back({_board.pieces[RED], _board.pieces[YELLOW]});
+        restartAnalysis();
         endTurn();
         return true;
     }
@@ -120,8 +130,21 @@ bool Connect4::actionForEmptyHolder(BitHolder &holder){
 }
 
 void Connect4::stopGame(){
+    _analysis.stop();
     Player* winner = checkForWinner();
 
+    if(_exportTrainingData && !_gamePositions.empty()){
+        // the next session starts while the file is written, one write at a time so games don't interleave
+        _trainingWrites.wait();
+        if(_trainingWriteFailed.exchange(false)) log(Error, "GEN TrainingDataWriteFailed");
+        _trainingWrites.run([this, positions = _gamePositions, result = winner ? winner->playerNumber() : -1]{
+            if(!Connect4NNUE::appendTrainingGame(TRAINING_DATA_PATH, positions, result)) _trainingWriteFailed = true;
+        });
+    }
+    if(!_gamePositions.empty())
+        log(Info, "GEN Game: " + gameRecord(winner ? winner->playerNumber() : -1));
+    _gamePositions.clear();
+
     if(winner == nullptr){
         log(Debug, "GEN Draw");
     }else{
@@ -166,33 +189,39 @@ void Connect4::updateAI(){
 
     if(me != getCurrentPlayer()->playerNumber()) return;
 
-    int bestMoveIdx = -1;
-
-    int bestScore = -MATE*100;
-    int res = -MATE/10;
-
     int d = DEPTH_AT_TURN[(this->_turns.size()-1)/2];
-
+    int bestMoveIdx = -1;
 
 
     log(Debug, "AI1 Turn: " + numToStr(this->_turns.size()));
-    log(Debug, "AI1 Depth: " + numToStr(d));
     timer.setPt("AI1 Thinking Start");
-    for(int i = 0; i < 42; ++i){
-        if(!moveIsLegal((_board.pieces[RED] | _board.pieces[YELLOW]), i)) continue;
-
-        setBitInPlace(_board.pieces[me], i, true);
-        res = -negamax(static_cast<Color>(!me), -MATE, MATE, d);
-        setBitInPlace(_board.pieces[me], i, false);
-
-        if(res > bestScore){
-            bestScore = res;
-            bestMoveIdx = i;
-        }
-
+    _perf.start();
+    _engine.setBoard(_board.pieces[RED], _board.pieces[YELLOW]);
+    if(_traceEnabled){
+        _trace.clear();
+        _engine.setTrace(&_trace);
     }
+    if(_clock.enabled()){
+        bestMoveIdx = searchTimed(static_cast<Color>(me), d);
+    }else{
+        bestMoveIdx = searchAI1(static_cast<Color>(me), d).bestMoveIdx;
+    }
+    const PerfCounters::Sample perf = _perf.stop();
     timer.setPt("AI1 Thinking End");
+    _engine.setTrace(nullptr);
+    log(Debug, "AI1 Depth: " + numToStr(d));
     log(Info, "AI1 ThinkTime: "+fltToStr(timer.milliPassed("AI1 Thinking Start", "AI1 Thinking End")));
+    _searchStats[0] = _engine.stats();
+    logSearchStats("AI1", _searchStats[0]);
+    logPerfSample("AI1", perf, _engine.nodes(), ai1OnPool());
+    if(_clock.enabled()){
+        _clock.endMove(timer.milliPassed("AI1 Thinking Start", "AI1 Thinking End"));
+        log(Info, "AI1 TimeAlloc: " + fltToStr(_clock.allocatedMs()));
+        log(Info, "AI1 TimeLimit: " + fltToStr(_clock.softLimitMs()));
+        log(Info, "AI1 TimeUsed: " + fltToStr(timer.milliPassed("AI1 Thinking Start", "AI1 Thinking End")));
+        log(Info, "AI1 TimeExtended: " + numToStr(static_cast<int>(_clock.extended())));
+        log(Info, "AI1 ClockLeft: " + fltToStr(_clock.remainingMs()));
+    }
 
     if(bestMoveIdx == -1 && !boardIsFull()) {
         log(Error, "AI1 NoLegalMoves");
@@ -205,115 +234,9 @@ void Connect4::updateAI(){
     //log(Debug, "Action made at " + numToStr(bestMoveIdx) + "("+numToStr(bestMoveCords.first)+","+numToStr(bestMoveCords.second)+")");
 }
 
-int Connect4::negamax(const Color player, int a, const int b, const int d){   
-
-    switch(comboWon(_board.pieces[player]) *1 + comboWon(_board.pieces[!player]) *2 + boardIsFull()*3){
-        case 1: return MATE/(d+1);
-        case 2: return -MATE*(d+1);
-        case 3: return 0;
-        case 4: return MATE/(d+1);
-        case 5: return -MATE*(d+1);
-    }
-
-    /* equivalent to
-    if(comboWon(_board.pieces[player])){ 
-        return MATE/(d+1);
-    }
-    if(comboWon(_board.pieces[!player])){ 
-        return -MATE*(d+1);
-    }
-    if(boardIsFull()){
-        return 0;
-    }
-    */
-    if(d <= 0){
-        return evalBoardState(_board, player);
-    }
-
-    int bestScore = -MATE;
-    int res = -MATE/10;
-
-    for(int i = 0; i < 42; ++i){
-        int bestMove = SORTED_CELL_VALUES[i];
-
-        if(!moveIsLegal(_board.pieces[RED] | _board.pieces[YELLOW], bestMove)) continue;
-        setBitInPlace(_board.pieces[player], bestMove, true);
-        res = -negamax(static_cast<Color>(!player), -b, -a, d-1);
-        setBitInPlace(_board.pieces[player], bestMove, false);
-
-        bestScore = std::max(bestScore, res);
-        a = std::max(a, res);
-
-        if(a >= b) return bestScore;
-
-    }
-
-    return bestScore;
-
-
-}
-
-
-int Connect4::assessWinPattern(const Board& board, const Color color, const int patternIdx) const{
-    if((WINNING_PATTERNS[patternIdx] & board.pieces[!color]) != 0)
-        return 0;
-
-    
-    int piecesMatched = std::popcount(board.pieces[color] & WINNING_PATTERNS[patternIdx]);
-
-    return piecesMatched == 4? MATE : 1 << piecesMatched;
-}
-
-
-int Connect4::evalBoardState(const Board& board, const Color color) const{
-    int score = 0;
-    int oppScore = 0;
-
-    for(int i = 0; i < 69; ++i){
-        score += assessWinPattern(board, color, i);
-        oppScore += assessWinPattern(board, static_cast<Color>(!color), i);
-    }
-
-    return score - (oppScore/1.2);
-
-}
-
-
 #include "Connect4Bot2.h"
 
 
-bool Connect4::boardIsFull() const{
-    return ((_board.pieces[RED] | _board.pieces[YELLOW]) == UTIL_PATTERNS[FULL]);
-}
-
-
-bool Connect4::comboWon(const uint64_t piecies) const{
-
-
-    return 
-    
-    // Horizontal (stride 1)
-    (piecies & (piecies << 1) & (piecies << 2) & (piecies << 3) & UTIL_PATTERNS[HORIZONTAL_START]) ||
-
-    // Vertical (stride 7)
-    (piecies & (piecies << 7) & (piecies << 14) & (piecies << 21) & UTIL_PATTERNS[VERTICAL_START]) ||
-
-
-    // Diagonal LR '\' (stride 8)
-    (piecies & (piecies << 8) & (piecies << 16) & (piecies << 24) & UTIL_PATTERNS[DIAGONAL_LR_START]) ||
-    
-    // Diagonal RL '/' (stride 6)
-    (piecies & (piecies << 6) & (piecies << 12) & (piecies << 18) & UTIL_PATTERNS[DIAGONAL_RL_START]);
-    
-}
-
-
-bool Connect4::moveIsLegal(const uint64_t board, const int i) const{
-
-    return (getBit(board, i) == 0 && ( (i>=35) || ((getBit(board, i+7) == 1))));
-
-}
-
 bool Connect4::forcedToPlay(const Color& col, const int idx) const{
     return (42 - this->_turns.size())/2;
 }
@@ -388,3 +311,231 @@ std::array<int, 42> Connect4::makeHeatMap(const uint64_t *arr, const int len){
 
     return res;
 }
+
+
+
+// "<red> <yellow> <columns 1-7 in play order> <red|yellow|draw>", e.g. "AI2 AI1 4453 red"
+// read back by tools/connect4_analyze
+std::string Connect4::gameRecord(const int winner) const{
+    auto name = [this](const int player){
+        if(aiPlayer == 3) return std::string((player == RED) == ai2GoesFirst ? "AI2" : "AI1");
+        return std::string(aiPlayer == player + 1 ? "AI1" : "HUM");
+    };
+
+    std::string moves;
+    uint64_t previous = 0;
+    for(const std::array<uint64_t, 2>& pos : _gamePositions){
+        const uint64_t occupied = pos[RED] | pos[YELLOW];
+        const int cell = 63 - std::countr_zero(occupied ^ previous);
+        moves.push_back(static_cast<char>('1' + cell % 7));
+        previous = occupied;
+    }
+
+    const char* result = winner < 0 ? "draw" : (winner == RED ? "red" : "yellow");
+    return name(RED) + " " + name(YELLOW) + " " + moves + " " + result;
+}
+
+
+bool Connect4::dumpTrace(const std::string& path){
+    if(_trace.size() == 0){
+        log(Warn, "GEN TraceEmpty");
+        return false;
+    }
+    if(!_trace.dump(path)){
+        log(Error, "GEN TraceWriteFailed: " + path);
+        return false;
+    }
+    log(Info, "GEN TraceRecords: " + numToStr(_trace.size()));
+    if(_trace.wrapped()) log(Warn, "GEN TraceWrapped: oldest nodes were overwritten");
+    return true;
+}
+
+
+void Connect4::logSearchStats(const std::string& ai, const SearchStats& stats) const{
+    if constexpr (!SearchStats::ENABLED) return;
+
+    const SearchStats::Counters total = stats.total();
+    log(Info, ai + " Nodes: " + numToStr(total.nodes));
+    log(Info, ai + " LeafEvals: " + numToStr(total.leafEvals));
+    log(Info, ai + " BetaCutoffs: " + numToStr(total.betaCutoffs));
+    log(Info, ai + " FirstMoveCutoffs: " + numToStr(total.firstMoveCutoffs));
+    log(Info, ai + " TerminalHits: " + numToStr(total.terminalHits));
+    log(Info, ai + " CacheProbes: " + numToStr(total.cacheProbes));
+    log(Info, ai + " CacheHits: " + numToStr(total.cacheHits));
+
+    for(int ply = 1; ply <= stats.maxPly; ++ply){
+        const SearchStats::Counters& c = stats.ply[ply];
+        log(Debug, ai + " Ply" + numToStr(ply) + ": nodes " + numToStr(c.nodes) + " leaf " + numToStr(c.leafEvals) +
+            " cut " + numToStr(c.betaCutoffs) + " first " + numToStr(c.firstMoveCutoffs) + " term " + numToStr(c.terminalHits));
+    }
+}
+
+
+void Connect4::logPerfSample(const std::string& ai, const PerfCounters::Sample& sample, const uint64_t nodes, const bool pooled) const{
+    if(!sample.any()) return;
+
+    for(int i = 0; i < PerfCounters::EVENT_COUNT; ++i)
+        if(sample.valid[i]) log(Info, ai + " " + PerfCounters::EVENT_NAMES[i] + ": " + numToStr(sample.values[i]));
+
+    // the workers' cycles are not in the sample but their nodes are in the count, ratios would be meaningless
+    if(pooled){
+        log(Debug, ai + " PerfCounters: calling thread only, search ran on the thread pool");
+        return;
+    }
+
+    if(sample.valid[PerfCounters::CYCLES] && sample.valid[PerfCounters::INSTRUCTIONS])
+        log(Info, ai + " IPC: " + fltToStr(sample.ipc()));
+
+    // AI2 only knows its node count with CONNECT4_SEARCH_STATS
+    if(nodes == 0) return;
+    for(int i = PerfCounters::CYCLES; i < PerfCounters::EVENT_COUNT; ++i)
+        if(sample.valid[i] && i != PerfCounters::INSTRUCTIONS)
+            log(Info, ai + " " + PerfCounters::EVENT_NAMES[i] + "PerNode: " + fltToStr(sample.perNode(static_cast<PerfCounters::Event>(i), nodes)));
+}
+
+
+Connect4Engine::RootResult Connect4::searchAI1(const Color me, const int d){
+    if(ai1OnPool())
+        return _engine.searchRoot(static_cast<Connect4Engine::Color>(me), d, ThreadPool::shared());
+    return _engine.searchRoot(static_cast<Connect4Engine::Color>(me), d);
+}
+
+int Connect4::searchTimed(const Color me, int& depthReached){
+    const uint64_t occupied = _board.pieces[RED] | _board.pieces[YELLOW];
+    const int empties = 42 - std::popcount(occupied);
+
+    int legalMoves = 0;
+    int fallback = -1;
+    for(int col = 0; col < 7; ++col){
+        int idx = Connect4Engine::landingCell(occupied, col);
+        if(idx < 0) continue;
+        ++legalMoves;
+        if(fallback < 0) fallback = idx;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    _clock.startMove((42 - empties) / 2, legalMoves, (empties + 1) / 2);
+    _engine.setDeadline(start + std::chrono::microseconds(static_cast<long long>(_clock.hardLimitMs() * 1000)));
+
+    int bestMoveIdx = fallback;
+    depthReached = 0;
+
+    for(int d = 0; d < empties; ++d){
+        Connect4Engine::RootResult res = searchAI1(me, d);
+        if(_engine.stopped()) break;    // hard limit hit mid iteration, keep the last complete one
+
+        bestMoveIdx = res.bestMoveIdx;
+        depthReached = d;
+
+        // a forced result won't change with more depth
+        if(res.bestScore >= MATE/50 || res.bestScore <= -MATE/50) break;
+
+        const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if(!_clock.iterationDone(elapsed, res.bestScore, res.bestMoveIdx)) break;
+    }
+
+    _engine.clearDeadline();
+    return bestMoveIdx;
+}
+
+void Connect4::setClock(const double totalMs, const double incrementMs){
+    _clockTotalMs = totalMs;
+    _clockIncrementMs = incrementMs;
+}
+
+
+void Connect4::reviewGame(const int pvCount, const int depth){
+    Connect4Engine engine = _engine;
+    std::array<uint64_t, 2> before = {0, 0};
+
+    for(size_t ply = 0; ply < _gamePositions.size(); ++ply){
+        const std::array<uint64_t, 2>& after = _gamePositions[ply];
+        const Color toMove = static_cast<Color>(ply % 2);
+        const int played = std::countl_zero((after[RED] | after[YELLOW]) ^ (before[RED] | before[YELLOW]));
+
+        engine.setBoard(before[RED], before[YELLOW]);
+        std::vector<Connect4Engine::RootMove> lines = engine.multiPV(static_cast<Connect4Engine::Color>(toMove), depth, pvCount);
+
+        log(Info, "REV Ply: " + numToStr(ply + 1));
+        log(Info, "REV Played: " + numToStr(played % 7 + 1));
+        for(size_t i = 0; i < lines.size(); ++i){
+            std::string pv;
+            for(int j = 0; j < lines[i].pv.length; ++j)
+                pv += " " + numToStr(lines[i].pv.moves[j] % 7 + 1);
+            log(Info, "REV PV" + numToStr(i + 1) + ": " + numToStr(lines[i].moveIdx % 7 + 1) + " " + numToStr(lines[i].score) + " pv" + pv);
+        }
+
+        before = after;
+    }
+}
+
+
+void Connect4::drawFrame(){
+    Game::drawFrame();
+    if(_showAnalysis) drawAnalysisOverlay();
+}
+
+void Connect4::setAnalysisEnabled(bool enabled){
+    if(enabled == _showAnalysis) return;
+    _showAnalysis = enabled;
+    if(_showAnalysis) restartAnalysis();
+    else _analysis.stop();
+}
+
+void Connect4::restartAnalysis(){
+    if(!_showAnalysis) return;
+
+    if(comboWon(_board.pieces[RED]) || comboWon(_board.pieces[YELLOW]) || boardIsFull()){
+        _analysis.stop();
+        return;
+    }
+
+    // the analysis thread gets its own copy, the board is never shared with it
+    Connect4Engine snapshot = _engine;
+    snapshot.setBoard(_board.pieces[RED], _board.pieces[YELLOW]);
+
+    const Color toMove = static_cast<Color>(std::popcount(_board.pieces[RED] | _board.pieces[YELLOW]) % 2);
+    _analysis.start(snapshot, static_cast<Connect4Engine::Color>(toMove), ANALYSIS_MAX_DEPTH);
+}
+
+void Connect4::drawAnalysisOverlay(){
+    Connect4Analysis::Snapshot snap = _analysis.snapshot();
+
+    const uint64_t occupied = _board.pieces[RED] | _board.pieces[YELLOW];
+    const std::array<int, 42> filled = makeHeatMap(&occupied, 1);
+
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    const ImVec2 origin(ImGui::GetWindowPos().x - ImGui::GetScrollX(), ImGui::GetWindowPos().y - ImGui::GetScrollY());
+
+    for(int col = 0; col < 7; ++col){
+        if(snap.depths[col] < 0) continue;
+
+        // label the cell the next stone in this column would land in
+        int row = 5;
+        while(row >= 0 && filled[cordsGridToBoard({col, row})]) --row;
+        if(row < 0) continue;
+
+        ChessSquare* square = _grid->getSquare(col, row);
+        const ImVec2 topLeft(origin.x + square->getPosition().x, origin.y + square->getPosition().y);
+        const ImVec2 bottomRight(topLeft.x + 80, topLeft.y + 80);
+
+        const int score = snap.scores[col];
+        std::string label;
+        ImU32 color;
+        if(score >= MATE/50){
+            label = "WIN";
+            color = IM_COL32(40, 200, 40, 110);
+        }else if(score <= -MATE/50){
+            label = "LOSS";
+            color = IM_COL32(220, 40, 40, 110);
+        }else{
+            label = numToStr(score);
+            const int shade = std::clamp(score, -255, 255);
+            color = shade >= 0 ? IM_COL32(40, 200, 40, 30 + shade/3) : IM_COL32(220, 40, 40, 30 - shade/3);
+        }
+        label += "\nd" + numToStr(snap.depths[col]);
+
+        drawList->AddRectFilled(topLeft, bottomRight, color);
+        drawList->AddText(ImVec2(topLeft.x + 6, topLeft.y + 6), IM_COL32(255, 255, 255, 255), label.c_str());
+    }
+}
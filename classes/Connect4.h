@@ -5,70 +5,14 @@
 #include <bit>
 #include <bitset>
 #include "../imgui/logger/logger.h"
+#include "Connect4Engine.h"
+#include "Connect4Analysis.h"
+#include "TimeManager.h"
+#include "PerfCounters.h"
+#include "ThreadPool.h"
 
 
 
-inline constexpr std::array<uint64_t, 69> calcWinningPatterns(){ 
-        std::array<uint64_t, 69> winningPatterns{};
-        //horizontal _
-        winningPatterns[0] = (0b1111000000000000000000000000000000000000000000000000000000000000);
-
-        for(int i = 1; i < 4*6;++i)
-            winningPatterns[i] = winningPatterns[i-1] >> (i%4 == 0? 4 :1);
-        //vertical |
-        winningPatterns[24] = (0b100000010000001000000100000000000000000000<<22);
-        
-        for(int i = 25; i < 24+3*7; ++i)
-            winningPatterns[i] = winningPatterns[i-1] >> 1;
-        
-        //diagonal /
-        winningPatterns[45] = (0b100000001000000010000000100000000000000000<<22);
-
-        for(int i = 46; i < 57; ++i)
-            winningPatterns[i] = winningPatterns[i-1] >> ((i == 49 || i == 53 )? 4 : 1);
-
-        winningPatterns[57] = (0b0001000001000001000001000000000000000000000000000000000000000000);
-
-        //diagonal \ 
-        for(int i = 58; i < 69; ++i)
-            winningPatterns[i] = winningPatterns[i-1] >> ((i == 61 || i == 65)?4 : 1);
-        
-
-        return winningPatterns;
-
-        //horizontal = 0-23
-        //vertical = 24-44
-        //diagonal / = 45-56
-        //diagonal \ = 57-68
-        
-}
-
-
-inline constexpr std::array<uint64_t, 19> makeUtilPatterns(){
-    std::array<uint64_t, 19> utilPatterns{};
-
-    utilPatterns[0] = 0ULL;
-    utilPatterns[1] = 0b1111111111111111111111111111111111111111110000000000000000000000;
-    utilPatterns[2] = 0b1000000100000010000001000000100000010000000000000000000000000000;
-
-    for(int i = 3; i < 9; ++i)
-        utilPatterns[i] = utilPatterns[i-1] >> 1;
-
-    
-    utilPatterns[9] = 0b1111111000000000000000000000000000000000000000000000000000000000;
-
-    for(int i = 10; i < 15; ++i)
-        utilPatterns[i] = utilPatterns[i-1] >> 7;
-
-
-    utilPatterns[15] = utilPatterns[2] | utilPatterns[3] | utilPatterns[4] | utilPatterns[5];
-    utilPatterns[16] = utilPatterns[9] | utilPatterns[10] | utilPatterns[11];
-    utilPatterns[17] = utilPatterns[15] & utilPatterns[16];
-    utilPatterns[18] = (utilPatterns[5] | utilPatterns[6] | utilPatterns[7] | utilPatterns[8]) & utilPatterns[16];
-
-    return utilPatterns;
- }
-
 inline uint64_t setBit(uint64_t x, const unsigned int pos, const bool value) {
     if (pos >= 64) {
         log(Error, "Bit position out of range");
@@ -161,15 +105,45 @@ public:
     void        updateAI() override;
     bool        gameHasAI() override  { return aiPlayer != -1; } // Set to true when AI is implemented
     Grid*       getGrid() override final { return _grid; }
+    void        drawFrame() override;
+
+    // background per-column analysis drawn over the grid
+    void        setAnalysisEnabled(bool enabled);
+    bool        analysisEnabled() const { return _showAnalysis; }
+
+    // whole-game clock for AI1, totalMs = 0 goes back to DEPTH_AT_TURN
+    // takes effect from the next setUpBoard()
+    void        setClock(const double totalMs, const double incrementMs);
+
+    // logs the top pvCount moves (multi-PV) for every position of the current game
+    void        reviewGame(const int pvCount = REVIEW_PV_COUNT, const int depth = REVIEW_DEPTH);
+
+    // records AI1's search tree (down to TRACE_MAX_PLY) for every move, dumpTrace() writes the last one
+    void        setTraceEnabled(bool enabled) { _traceEnabled = enabled; }
+    bool        traceEnabled() const { return _traceEnabled; }
+
+    // AI1 searches its root moves on ThreadPool::shared(), same moves, less wall time. tracing keeps the serial search
+    void        setParallelSearch(bool enabled) { _parallelSearch = enabled; }
+    bool        parallelSearch() const { return _parallelSearch; }
+    bool        dumpTrace(const std::string& path = TRACE_PATH);
+
+    // counters of the last move each AI made (ai = 1 or 2), zero unless built with CONNECT4_SEARCH_STATS
+    const SearchStats& lastSearchStats(const int ai) const { return _searchStats[ai == 2]; }
+
+    static constexpr int REVIEW_PV_COUNT = 3;
+    static constexpr int REVIEW_DEPTH = 8;
+    static constexpr const char* TRACE_PATH = "connect4_trace.bin";
+    static constexpr int TRACE_MAX_PLY = 4;
+    static constexpr size_t TRACE_CAPACITY = 1 << 18;
 private:
 
-    static constexpr std::array<uint64_t, 69> WINNING_PATTERNS = calcWinningPatterns();
-    static constexpr std::array<uint64_t, 19> UTIL_PATTERNS = makeUtilPatterns();
-    static constexpr std::array<uint8_t, 42> SORTED_CELL_VALUES = {24, 17, 23, 25, 16, 18, 31, 10, 22, 26, 30, 32, 9, 11, 15, 19, 38, 3, 29, 33, 8, 12, 21, 27, 37, 39, 2, 4, 14, 20, 28, 34, 36, 40, 1, 5, 7, 13, 35, 41, 0, 6};
-    //                                         idx pairs:    1-2 3-4 5-6 7-8 9-10 11-12 13-14 15-16 17-18 19-20 21-22 23-24 25-26 27-28 29-30 31-32 33-34 35-36 37-38 39-40 41-42
-    //                                     max calc left:    41  39  37  35   33   31    29    27    25    23    21    19    17    15    13    11     9     7     5     3     1   
-    static constexpr std::array<uint8_t, 42> DEPTH_AT_TURN = {9,  9,  8,  9,  10,  11,   13,   14,   17,   30,   20,   20,   20,   20,   20,   10,   10,   10,   10,   10,  10};
-    static constexpr int32_t MATE = 99999;
+    static constexpr std::array<uint64_t, 69> WINNING_PATTERNS = Connect4Engine::WINNING_PATTERNS;
+    static constexpr std::array<uint8_t, 42> SORTED_CELL_VALUES = Connect4Engine::SORTED_CELL_VALUES;
+    static constexpr std::array<uint8_t, 42> DEPTH_AT_TURN = Connect4Engine::DEPTH_AT_TURN;
+    static constexpr int32_t MATE = Connect4Engine::MATE;
+    static constexpr int ANALYSIS_MAX_DEPTH = 20;
+    static constexpr const char* NNUE_WEIGHTS_PATH = "resources/connect4.nnue";
+    static constexpr const char* TRAINING_DATA_PATH = "connect4_selfplay.txt";
 
     Bit*                PieceForPlayer(int player);
 
@@ -179,18 +153,25 @@ private:
 
 
 
-    bool        comboWon(const uint64_t piecies) const;
-    bool        boardIsFull() const;
-    bool        moveIsLegal(const uint64_t board, const int i) const;
+    bool        comboWon(const uint64_t piecies) const { return Connect4Engine::comboWon(piecies); }
+    bool        boardIsFull() const { return Connect4Engine::boardIsFull({_board.pieces}); }
+    bool        moveIsLegal(const uint64_t board, const int i) const { return Connect4Engine::moveIsLegal(board, i); }
     bool        forcedToPlay(const Color& col, int idx) const;
 
 
 
-    int         assessWinPattern(const Board& board, const Color color, const int patternIdx) const;
-    int         evalBoardState(const Board& board, const Color color) const;
+    // iterative deepening under the game clock, returns the chosen cell or -1
+    int         searchTimed(const Color me, int& depthReached);
+    Connect4Engine::RootResult searchAI1(const Color me, const int d);
+    bool        ai1OnPool() const { return _parallelSearch && !_traceEnabled; }
 
+    std::string gameRecord(const int winner) const;
+    void        logSearchStats(const std::string& ai, const SearchStats& stats) const;
+    // pooled: the search ran on ThreadPool workers, the sample only counted the calling thread's share of it
+    void        logPerfSample(const std::string& ai, const PerfCounters::Sample& sample, const uint64_t nodes, const bool pooled = false) const;
 
-    int         negamax(const Color player, int a = -MATE, const int b = MATE, const int d = 8);
+    void        restartAnalysis();
+    void        drawAnalysisOverlay();
 
     bool        currPlayer(){return _turns.size() % 2 == 0;}
     
@@ -212,6 +193,23 @@ private:
     Grid*       _grid;
     Board _board;
 
+    Connect4Engine _engine;     // AI1 search, synced from _board before every move
+    Connect4Analysis _analysis;
+    bool _showAnalysis;
+    TimeManager _clock;
+    double _clockTotalMs;
+    double _clockIncrementMs;
+    bool _exportTrainingData;
+    std::vector<std::array<uint64_t, 2>> _gamePositions;   // board after every move of the current game
+    std::array<SearchStats, 2> _searchStats;    // AI1, AI2
+    int _ai2RootDepth;
+    SearchTrace _trace{TRACE_CAPACITY, TRACE_MAX_PLY};
+    bool _traceEnabled;
+    bool _parallelSearch;
+    std::atomic<bool> _trainingWriteFailed{false};
+    TaskGroup _trainingWrites;  // appends finished self-play games to TRAINING_DATA_PATH off the game loop
+    PerfCounters _perf;         // brackets updateAI/updateAI2, empty samples where counters are not permitted
+
      /*
     00 01 02 03 04 05 06 
     07 08 09 10 11 12 13 
@@ -0,0 +1,70 @@
+#include "Connect4Analysis.h"
+
+
+
+Connect4Analysis::Connect4Analysis(){
+    _stop = false;
+    _snapshot.scores.fill(Connect4Engine::NO_SCORE);
+    _snapshot.depths.fill(-1);
+    _snapshot.running = false;
+}
+
+Connect4Analysis::~Connect4Analysis(){
+    stop();
+}
+
+
+void Connect4Analysis::start(const Connect4Engine& engine, const Connect4Engine::Color toMove, const int maxDepth){
+    stop();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _snapshot.scores.fill(Connect4Engine::NO_SCORE);
+        _snapshot.depths.fill(-1);
+        _snapshot.running = true;
+    }
+
+    _stop = false;
+    _thread = std::thread(&Connect4Analysis::run, this, engine, toMove, maxDepth);
+}
+
+void Connect4Analysis::stop(){
+    // the search polls the flag every few hundred nodes, so this join returns almost immediately
+    _stop = true;
+    if(_thread.joinable()) _thread.join();
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _snapshot.running = false;
+}
+
+Connect4Analysis::Snapshot Connect4Analysis::snapshot() const{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _snapshot;
+}
+
+
+void Connect4Analysis::run(Connect4Engine engine, const Connect4Engine::Color toMove, const int maxDepth){
+    engine.setStopFlag(&_stop);
+    engine.setTrace(nullptr);
+
+    for(int d = 0; d <= maxDepth; ++d){
+        for(int col = 0; col < 7; ++col){
+            const uint64_t occupied = engine.board().pieces[Connect4Engine::RED] | engine.board().pieces[Connect4Engine::YELLOW];
+            const int idx = Connect4Engine::landingCell(occupied, col);
+            if(idx < 0) continue;
+
+            engine.makeMove(toMove, idx);
+            int score = -engine.negamax(static_cast<Connect4Engine::Color>(!toMove), -Connect4Engine::MATE, Connect4Engine::MATE, d);
+            engine.unmakeMove(toMove, idx);
+
+            if(engine.stopped() || _stop) return;
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _snapshot.scores[col] = score;
+            _snapshot.depths[col] = d;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _snapshot.running = false;
+}
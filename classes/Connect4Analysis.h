@@ -0,0 +1,37 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "Connect4Engine.h"
+
+// background per-column analysis of a position
+// searches depth 0, 1, 2, ... on its own copy of the engine and publishes every
+// column as soon as it is scored, so the GUI can poll snapshot() each frame
+class Connect4Analysis{
+
+public:
+
+    struct Snapshot{
+        std::array<int, 7>  scores;     // Connect4Engine::NO_SCORE until searched / for full columns
+        std::array<int, 7>  depths;     // depth each score comes from, -1 if none yet
+        bool                running;
+    };
+
+    Connect4Analysis();
+    ~Connect4Analysis();
+
+    // stops any previous analysis, then analyses engine's current board with toMove to play
+    void        start(const Connect4Engine& engine, const Connect4Engine::Color toMove, const int maxDepth);
+    void        stop();
+    Snapshot    snapshot() const;
+
+private:
+
+    void        run(Connect4Engine engine, const Connect4Engine::Color toMove, const int maxDepth);
+
+    std::thread         _thread;
+    std::atomic<bool>   _stop;
+    mutable std::mutex  _mutex;
+    Snapshot            _snapshot;
+};
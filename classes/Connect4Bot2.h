@@ -15,12 +15,15 @@ void Connect4::updateAI2(){
     int res = -MATE/10;
 
     int d = DEPTH_AT_TURN[(this->_turns.size()-1)/2];
+    _ai2RootDepth = d;
+    SEARCH_STAT(_searchStats[1].clear();)
 
 
 
     log(Debug, "AI2 Turn: " + numToStr(this->_turns.size()));
     log(Debug, "AI2 Depth: " + numToStr(d));
     timer.setPt("AI2 Thinking Start");
+    _perf.start();
     for(int i = 0; i < 42; ++i){
         if(!moveIsLegal((_board.pieces[RED] | _board.pieces[YELLOW]), i)) continue;
 
@@ -34,8 +37,11 @@ void Connect4::updateAI2(){
         }
 
     }
+    const PerfCounters::Sample perf = _perf.stop();
     timer.setPt("AI2 Thinking End");
     log(Info, "AI2 ThinkTime: "+fltToStr(timer.milliPassed("AI2 Thinking Start", "AI2 Thinking End")));
+    logSearchStats("AI2", _searchStats[1]);
+    logPerfSample("AI2", perf, _searchStats[1].total().nodes);
 
     if(bestMoveIdx == -1 && !boardIsFull()) {
         log(Error, "AI2 NoLegalMoves");
@@ -50,7 +56,17 @@ void Connect4::updateAI2(){
 
 int Connect4::negamax2(const Color player, int a, const int b, const int d){   
 
-    switch(comboWon(_board.pieces[player]) *1 + comboWon(_board.pieces[!player]) *2 + boardIsFull()*3){
+    SEARCH_STAT(
+        const int ply = _ai2RootDepth - d + 1;
+        SearchStats::Counters& stats = _searchStats[1].ply[ply];
+        ++stats.nodes;
+        _searchStats[1].maxPly = std::max(_searchStats[1].maxPly, ply);
+    )
+
+    const int outcome = comboWon(_board.pieces[player]) *1 + comboWon(_board.pieces[!player]) *2 + boardIsFull()*3;
+    SEARCH_STAT(if(outcome) ++stats.terminalHits;)
+
+    switch(outcome){
         case 1: return MATE/(d+1);
         case 2: return -MATE*(d+1);
         case 3: return 0;
@@ -71,11 +87,13 @@ int Connect4::negamax2(const Color player, int a, const int b, const int d){
     */
    
     if(d <= 0){
+        SEARCH_STAT(++stats.leafEvals;)
         return evalBoardState2(_board, player);
     }
 
     int bestScore = -MATE;
     int res = -MATE/10;
+    SEARCH_STAT(int searched = 0;)
 
     for(int i = 0; i < 42; ++i){
         int bestMove = SORTED_CELL_VALUES[i];
@@ -84,11 +102,18 @@ int Connect4::negamax2(const Color player, int a, const int b, const int d){
         setBitInPlace(_board.pieces[player], bestMove, true);
         res = -negamax2(static_cast<Color>(!player), -b, -a, d-1);
         setBitInPlace(_board.pieces[player], bestMove, false);
+        SEARCH_STAT(++searched;)
 
         bestScore = std::max(bestScore, res);
         a = std::max(a, res);
 
-        if(a >= b) return bestScore;
+        if(a >= b){
+            SEARCH_STAT(
+                ++stats.betaCutoffs;
+                if(searched == 1) ++stats.firstMoveCutoffs;
+            )
+            return bestScore;
+        }
 
     }
 
@@ -0,0 +1,4 @@
+#include "Connect4Engine.h"
+
+// the game's engine is compiled once here, other sizes instantiate from Connect4Engine.tpp where they are used
+template class BasicConnect4Engine<7, 6, 4>;
@@ -0,0 +1,300 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Connect4NNUE.h"
+#include "SearchStats.h"
+#include "SearchTrace.h"
+#include "ThreadPool.h"
+
+
+
+// one bit per cell, row-major from the top left with cell 0 in the most significant bit
+// boards over 64 cells (10x8) need unsigned __int128, so GCC or Clang
+#ifdef __SIZEOF_INT128__
+template <int CELLS>
+using Connect4Bits = std::conditional_t<(CELLS <= 64), uint64_t, unsigned __int128>;
+#else
+template <int CELLS>
+using Connect4Bits = uint64_t;
+#endif
+
+
+template <class BitBoard>
+inline constexpr BitBoard connect4Cell(const int idx){
+    return static_cast<BitBoard>(1) << (sizeof(BitBoard) * 8 - 1 - idx);
+}
+
+template <int W, int H, int N>
+inline constexpr int connect4PatternCount(){
+    return H*(W-N+1) + W*(H-N+1) + 2*(W-N+1)*(H-N+1);
+}
+
+
+// every line of N cells: horizontal _, vertical |, diagonal '\', diagonal '/'
+// each direction ordered row-major by its top (left) cell, for 7x6 that is 0-23, 24-44, 45-56, 57-68
+template <int W, int H, int N, class BitBoard>
+inline constexpr std::array<BitBoard, connect4PatternCount<W, H, N>()> calcWinningPatterns(){
+    std::array<BitBoard, connect4PatternCount<W, H, N>()> winningPatterns{};
+    constexpr int DX[4] = {1, 0, 1, -1};
+    constexpr int DY[4] = {0, 1, 1, 1};
+
+    int i = 0;
+    for(int dir = 0; dir < 4; ++dir)
+        for(int y = 0; y < H; ++y)
+            for(int x = 0; x < W; ++x){
+                const int endX = x + DX[dir]*(N-1);
+                const int endY = y + DY[dir]*(N-1);
+                if(endX < 0 || endX >= W || endY >= H) continue;
+
+                BitBoard pattern = 0;
+                for(int k = 0; k < N; ++k)
+                    pattern |= connect4Cell<BitBoard>((y + DY[dir]*k)*W + x + DX[dir]*k);
+                winningPatterns[i++] = pattern;
+            }
+
+    return winningPatterns;
+}
+
+
+// all cells whose (x, y) pass pred
+template <int W, int H, class BitBoard, class Pred>
+inline constexpr BitBoard connect4CellMask(Pred pred){
+    BitBoard mask = 0;
+    for(int y = 0; y < H; ++y)
+        for(int x = 0; x < W; ++x)
+            if(pred(x, y)) mask |= connect4Cell<BitBoard>(y*W + x);
+    return mask;
+}
+
+
+// move order for sizes without a hand tuned one: cells on the most winning lines first, ties towards the centre column
+template <int W, int H, int N, class BitBoard>
+inline constexpr std::array<uint8_t, W*H> calcCellOrder(){
+    constexpr auto patterns = calcWinningPatterns<W, H, N, BitBoard>();
+
+    std::array<int, W*H> lines{};
+    for(int cell = 0; cell < W*H; ++cell)
+        for(const BitBoard& p : patterns)
+            if(p & connect4Cell<BitBoard>(cell)) ++lines[cell];
+
+    auto before = [&lines](const int a, const int b){
+        if(lines[a] != lines[b]) return lines[a] > lines[b];
+        const int da = 2*(a % W) - (W-1), db = 2*(b % W) - (W-1);
+        if(da*da != db*db) return da*da < db*db;
+        return a < b;
+    };
+
+    std::array<uint8_t, W*H> order{};
+    for(int cell = 0; cell < W*H; ++cell){
+        int pos = cell;
+        while(pos > 0 && before(cell, order[pos-1])){
+            order[pos] = order[pos-1];
+            --pos;
+        }
+        order[pos] = static_cast<uint8_t>(cell);
+    }
+    return order;
+}
+
+// centre column first, then outwards with the left one first: 3, 2, 4, 1, 5, 0, 6 for 7 columns
+template <int W>
+inline constexpr std::array<uint8_t, W> calcColumnOrder(){
+    std::array<uint8_t, W> order{};
+    int i = 0;
+    for(int dist = 0; i < W; ++dist){
+        const int left = (W-1)/2 - dist;
+        const int right = W/2 + dist;
+        if(left >= 0) order[i++] = static_cast<uint8_t>(left);
+        if(right != left && right < W) order[i++] = static_cast<uint8_t>(right);
+    }
+    return order;
+}
+
+
+
+// headless bitboard search used by the Connect4 AI, no Grid/ImGui dependencies
+// so it can be copied onto background threads and into tools
+// W columns, H rows, N in a row wins. the game itself is Connect4Engine (7x6, 4), the only size with
+// the hand tuned move order, the NNUE and search traces. it is compiled once in Connect4Engine.cpp
+template <int W, int H, int N>
+class BasicConnect4Engine{
+
+public:
+
+    static constexpr int WIDTH = W;
+    static constexpr int HEIGHT = H;
+    static constexpr int CONNECT = N;
+    static constexpr int CELLS = W*H;
+    static constexpr bool STANDARD = W == 7 && H == 6 && N == 4;
+
+    using BitBoard = Connect4Bits<CELLS>;
+
+    static_assert(N >= 2 && N <= W && N <= H, "connect length does not fit the board");
+    static_assert(CELLS <= static_cast<int>(sizeof(BitBoard) * 8), "board does not fit the bitboard type of this compiler");
+    static_assert(CELLS < SearchStats::MAX_PLY, "SearchStats::MAX_PLY does not cover every ply of the board");
+
+    enum Color: bool{
+        RED = 0,
+        YELLOW = 1
+    };
+
+    struct Board{
+        std::array<BitBoard, 2> pieces;
+    };
+
+    struct RootResult{
+        int bestMoveIdx;
+        int bestScore;
+    };
+
+    // principal variation as cell indices, moves[0] is played first
+    struct PVLine{
+        std::array<int8_t, CELLS> moves;
+        int length = 0;
+    };
+
+    struct RootMove{
+        int moveIdx;
+        int score;
+        PVLine pv;
+    };
+
+    static constexpr int PATTERN_COUNT = connect4PatternCount<W, H, N>();
+    static constexpr std::array<BitBoard, PATTERN_COUNT> WINNING_PATTERNS = calcWinningPatterns<W, H, N, BitBoard>();
+
+    static constexpr BitBoard FULL_MASK = connect4CellMask<W, H, BitBoard>([](int, int){ return true; });
+    // cells a line can start from going right, down, down-right and down-left
+    static constexpr BitBoard HORIZONTAL_START = connect4CellMask<W, H, BitBoard>([](int x, int){ return x <= W-N; });
+    static constexpr BitBoard VERTICAL_START = connect4CellMask<W, H, BitBoard>([](int, int y){ return y <= H-N; });
+    static constexpr BitBoard DIAGONAL_LR_START = connect4CellMask<W, H, BitBoard>([](int x, int y){ return x <= W-N && y <= H-N; });
+    static constexpr BitBoard DIAGONAL_RL_START = connect4CellMask<W, H, BitBoard>([](int x, int y){ return x >= N-1 && y <= H-N; });
+
+    static constexpr std::array<uint8_t, CELLS> SORTED_CELL_VALUES = []{
+        if constexpr (STANDARD)
+            return std::array<uint8_t, CELLS>{24, 17, 23, 25, 16, 18, 31, 10, 22, 26, 30, 32, 9, 11, 15, 19, 38, 3, 29, 33, 8, 12, 21, 27, 37, 39, 2, 4, 14, 20, 28, 34, 36, 40, 1, 5, 7, 13, 35, 41, 0, 6};
+        else
+            return calcCellOrder<W, H, N, BitBoard>();
+    }();
+
+    static constexpr int32_t MATE = 99999;
+    static constexpr int32_t NO_SCORE = -MATE*100;
+    // wider than any mate score (losses go down to -MATE*(d+1)), used where scores must be exact
+    static constexpr int32_t INF_SCORE = MATE*100;
+    static constexpr std::array<uint8_t, W> COLUMN_ORDER = calcColumnOrder<W>();
+    // AI1's search depth on the 7x6 board by move pair (ply/2), tools that judge its moves search at least this deep
+    //                                         idx pairs:    1-2 3-4 5-6 7-8 9-10 11-12 13-14 15-16 17-18 19-20 21-22 23-24 25-26 27-28 29-30 31-32 33-34 35-36 37-38 39-40 41-42
+    //                                     max calc left:    41  39  37  35   33   31    29    27    25    23    21    19    17    15    13    11     9     7     5     3     1   
+    static constexpr std::array<uint8_t, 42> DEPTH_AT_TURN = {9,  9,  8,  9,  10,  11,   13,   14,   17,   30,   20,   20,   20,   20,   20,   10,   10,   10,   10,   10,  10};
+    static constexpr uint64_t LIMIT_POLL_NODES = 1024;
+
+
+    BasicConnect4Engine();
+
+    void            setBoard(const BitBoard red, const BitBoard yellow);
+    const Board&    board() const { return _board; }
+
+    // the network only knows 7x6, loading always fails on other sizes
+    bool            loadNNUE(const std::string& path, std::string* error = nullptr);
+    bool            usingNNUE() const { return _useNNUE; }
+
+    // search unwinds once *stop is set, the deadline passes or the node limit is hit (checked every LIMIT_POLL_NODES nodes),
+    // results are garbage afterwards. setBoard() clears a previous abort
+    void            setStopFlag(const std::atomic<bool>* stop) { _stop = stop; }
+    void            setDeadline(const std::chrono::steady_clock::time_point deadline) { _deadline = deadline; _hasDeadline = true; }
+    void            clearDeadline() { _hasDeadline = false; }
+    // nodes since setBoard(), 0 = no limit
+    void            setNodeLimit(const uint64_t nodes) { _nodeLimit = nodes; }
+    bool            stopped() const { return _aborted; }
+    uint64_t        nodes() const { return _nodes; }
+    // per-ply counters since the last setBoard(), all zero unless built with CONNECT4_SEARCH_STATS
+    const SearchStats& stats() const { return _stats; }
+    // records every node down to trace->maxPly() while set, nullptr turns tracing off
+    // the engine does not own the trace, don't leave it set on a copy that runs on another thread
+    void            setTrace(SearchTrace* trace);
+
+    // full window search of every legal move of me, bestMoveIdx is -1 if there is none
+    RootResult      searchRoot(const Color me, const int d);
+    // same result and node count, the root moves searched in parallel on engine copies
+    // never traced, a node limit applies to every root move on its own
+    RootResult      searchRoot(const Color me, const int d, ThreadPool& pool);
+    // top k root moves of me with exact scores and principal variations, best first
+    std::vector<RootMove> multiPV(const Color me, const int d, const int k);
+
+    // pv is filled with the best line whenever the score lands inside (a, b)
+    int             negamax(const Color player, int a = -MATE, const int b = MATE, const int d = 8, PVLine* pv = nullptr);
+    int             evalBoardState(const Board& board, const Color color) const;
+
+    void            makeMove(const Color player, const int idx);
+    void            unmakeMove(const Color player, const int idx);
+
+    static bool     comboWon(const BitBoard piecies);
+    static bool     boardIsFull(const Board& board);
+    // color holding a complete winning pattern (RED first), -1 if nobody won
+    static int      winner(const Board& board);
+    static bool     moveIsLegal(const BitBoard board, const int i);
+    // lowest empty cell of a column, -1 if the column is full
+    static int      landingCell(const BitBoard board, const int column);
+
+    static constexpr BitBoard cellMask(const int idx) { return connect4Cell<BitBoard>(idx); }
+    // std::popcount has no __int128 overload
+    static constexpr int      popcount(const BitBoard x){
+        if constexpr (sizeof(BitBoard) == sizeof(uint64_t)) return std::popcount(static_cast<uint64_t>(x));
+        else return std::popcount(static_cast<uint64_t>(x >> 64)) + std::popcount(static_cast<uint64_t>(x));
+    }
+
+private:
+
+    // SearchTrace records hold 64 bit boards, wider boards are never traced
+    static constexpr bool TRACEABLE = sizeof(BitBoard) == sizeof(uint64_t);
+
+    int             assessWinPattern(const Board& board, const Color color, const int patternIdx) const;
+    void            pollLimits();
+    void            traceSearch(const Color me, const int d);
+    void            traceNode(const Color player, const int alpha, const int beta, const int score, const uint64_t startNodes,
+                              const int cutoffIdx, const int searched, const uint8_t flags);
+
+    // bit of every cell that starts N in a row along the cell stride s: p & p<<s & p<<2s ...
+    template <int STRIDE>
+    static constexpr BitBoard runs(const BitBoard p){
+        BitBoard r = p;
+        for(int k = 1; k < N; ++k) r &= p << (STRIDE*k);
+        return r;
+    }
+
+    Board _board;
+    Connect4NNUE _nnue;
+    bool _useNNUE;
+
+    const std::atomic<bool>* _stop;
+    std::chrono::steady_clock::time_point _deadline;
+    bool _hasDeadline;
+    uint64_t _nodeLimit;
+    bool _aborted;
+    uint64_t _nodes;
+    SearchStats _stats;
+    int _ply;               // moves made since setBoard()
+    SearchTrace* _trace;
+
+     /*
+    7x6:
+    00 01 02 03 04 05 06
+    07 08 09 10 11 12 13
+    14 15 16 17 18 19 20
+    21 22 23 24 25 26 27
+    28 29 30 31 32 33 34
+    35 36 37 38 39 40 41
+    */
+};
+
+
+using Connect4Engine = BasicConnect4Engine<7, 6, 4>;
+
+#include "Connect4Engine.tpp"
+
+extern template class BasicConnect4Engine<7, 6, 4>;
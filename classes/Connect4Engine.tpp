@@ -0,0 +1,375 @@
+#pragma once
+#include <algorithm>
+
+
+
+template <int W, int H, int N>
+BasicConnect4Engine<W, H, N>::BasicConnect4Engine(){
+    _board.pieces[RED] = 0;
+    _board.pieces[YELLOW] = 0;
+    _useNNUE = false;
+    _stop = nullptr;
+    _hasDeadline = false;
+    _nodeLimit = 0;
+    _aborted = false;
+    _nodes = 0;
+    _ply = 0;
+    _trace = nullptr;
+}
+
+
+template <int W, int H, int N>
+void BasicConnect4Engine<W, H, N>::setBoard(const BitBoard red, const BitBoard yellow){
+    _board.pieces[RED] = red;
+    _board.pieces[YELLOW] = yellow;
+    if constexpr (STANDARD)
+        if(_useNNUE) _nnue.refresh(red, yellow);
+    _aborted = false;
+    _nodes = 0;
+    _ply = 0;
+    SEARCH_STAT(_stats.clear();)
+}
+
+template <int W, int H, int N>
+bool BasicConnect4Engine<W, H, N>::loadNNUE(const std::string& path, std::string* error){
+    if constexpr (STANDARD){
+        _useNNUE = _nnue.loadWeights(path, error);
+        if(_useNNUE) _nnue.refresh(_board.pieces[RED], _board.pieces[YELLOW]);
+    }else{
+        if(error) *error = "the network is trained on 7x6 only";
+        _useNNUE = false;
+    }
+    return _useNNUE;
+}
+
+template <int W, int H, int N>
+void BasicConnect4Engine<W, H, N>::setTrace(SearchTrace* trace){
+    static_assert(TRACEABLE, "search traces hold 64 bit boards");
+    _trace = trace;
+}
+
+
+template <int W, int H, int N>
+typename BasicConnect4Engine<W, H, N>::RootResult BasicConnect4Engine<W, H, N>::searchRoot(const Color me, const int d){
+    RootResult result{-1, NO_SCORE};
+    int res = -MATE/10;
+    traceSearch(me, d);
+
+    for(int i = 0; i < CELLS; ++i){
+        if(!moveIsLegal((_board.pieces[RED] | _board.pieces[YELLOW]), i)) continue;
+
+        makeMove(me, i);
+        res = -negamax(static_cast<Color>(!me), -MATE, MATE, d);
+        unmakeMove(me, i);
+
+        if(res > result.bestScore){
+            result.bestScore = res;
+            result.bestMoveIdx = i;
+        }
+
+    }
+
+    return result;
+}
+
+template <int W, int H, int N>
+typename BasicConnect4Engine<W, H, N>::RootResult BasicConnect4Engine<W, H, N>::searchRoot(const Color me, const int d, ThreadPool& pool){
+    std::vector<int> moves;
+    for(int i = 0; i < CELLS; ++i)
+        if(moveIsLegal((_board.pieces[RED] | _board.pieces[YELLOW]), i)) moves.push_back(i);
+
+    // one copy per root move, the network weights are shared so a copy is cheap
+    std::vector<BasicConnect4Engine> copies(moves.size(), *this);
+    std::vector<int> scores(moves.size(), NO_SCORE);
+
+    pool.parallelFor(moves.size(), [&](const size_t k){
+        BasicConnect4Engine& engine = copies[k];
+        engine._trace = nullptr;
+        SEARCH_STAT(engine._stats.clear();)
+
+        engine.makeMove(me, moves[k]);
+        scores[k] = -engine.negamax(static_cast<Color>(!me), -MATE, MATE, d);
+        engine.unmakeMove(me, moves[k]);
+    });
+
+    // same pick as the serial search: the first strictly better move in cell order
+    RootResult result{-1, NO_SCORE};
+    const uint64_t startNodes = _nodes;
+    for(size_t k = 0; k < moves.size(); ++k){
+        _nodes += copies[k]._nodes - startNodes;
+        _aborted = _aborted || copies[k]._aborted;
+        SEARCH_STAT(_stats.add(copies[k]._stats);)
+
+        if(scores[k] > result.bestScore){
+            result.bestScore = scores[k];
+            result.bestMoveIdx = moves[k];
+        }
+    }
+
+    return result;
+}
+
+template <int W, int H, int N>
+std::vector<typename BasicConnect4Engine<W, H, N>::RootMove> BasicConnect4Engine<W, H, N>::multiPV(const Color me, const int d, const int k){
+    std::vector<RootMove> top;
+    if(k <= 0) return top;
+    top.reserve(k + 1);
+    traceSearch(me, d);
+
+    for(int col : COLUMN_ORDER){
+        const int idx = landingCell(_board.pieces[RED] | _board.pieces[YELLOW], col);
+        if(idx < 0) continue;
+
+        RootMove move{idx, NO_SCORE, {}};
+        makeMove(me, idx);
+
+        if(static_cast<int>(top.size()) < k){
+            // not k moves yet, every move is in: full window
+            move.score = -negamax(static_cast<Color>(!me), -INF_SCORE, INF_SCORE, d, &move.pv);
+        }else{
+            // null window against the current k-th best, re-search only moves that beat it
+            const int kth = top.back().score;
+            int score = -negamax(static_cast<Color>(!me), -kth - 1, -kth, d);
+            if(score > kth)
+                move.score = -negamax(static_cast<Color>(!me), -INF_SCORE, -kth, d, &move.pv);
+        }
+
+        unmakeMove(me, idx);
+        if(stopped()) break;
+        if(move.score == NO_SCORE) continue;
+
+        // pv does not include the root move yet
+        std::copy_backward(move.pv.moves.begin(), move.pv.moves.begin() + move.pv.length, move.pv.moves.begin() + move.pv.length + 1);
+        move.pv.moves[0] = static_cast<int8_t>(idx);
+        move.pv.length += 1;
+
+        auto pos = std::upper_bound(top.begin(), top.end(), move.score, [](int score, const RootMove& m){ return score > m.score; });
+        top.insert(pos, move);
+        if(static_cast<int>(top.size()) > k) top.pop_back();
+    }
+
+    return top;
+}
+
+
+template <int W, int H, int N>
+int BasicConnect4Engine<W, H, N>::negamax(const Color player, int a, const int b, const int d, PVLine* pv){
+
+    if(pv) pv->length = 0;
+    if((++_nodes % LIMIT_POLL_NODES) == 0) pollLimits();
+    if(_aborted) return 0;
+
+    const int alpha = a;
+    const uint64_t startNodes = _nodes;
+    int searched = 0;
+
+    // every exit goes through here so the tracer sees the final score
+    auto leave = [&](const int score, const int cutoffIdx, const uint8_t flags){
+        if(_trace && _ply <= _trace->maxPly()) traceNode(player, alpha, b, score, startNodes, cutoffIdx, searched, flags);
+        return score;
+    };
+
+    SEARCH_STAT(
+        SearchStats::Counters& stats = _stats.ply[_ply];
+        ++stats.nodes;
+        _stats.maxPly = std::max(_stats.maxPly, _ply);
+    )
+
+    const int outcome = comboWon(_board.pieces[player]) *1 + comboWon(_board.pieces[!player]) *2 + boardIsFull(_board)*3;
+    SEARCH_STAT(if(outcome) ++stats.terminalHits;)
+
+    switch(outcome){
+        case 1: return leave(MATE/(d+1), -1, SearchTrace::TERMINAL);
+        case 2: return leave(-MATE*(d+1), -1, SearchTrace::TERMINAL);
+        case 3: return leave(0, -1, SearchTrace::TERMINAL);
+        case 4: return leave(MATE/(d+1), -1, SearchTrace::TERMINAL);
+        case 5: return leave(-MATE*(d+1), -1, SearchTrace::TERMINAL);
+    }
+
+    /* equivalent to
+    if(comboWon(_board.pieces[player])){
+        return MATE/(d+1);
+    }
+    if(comboWon(_board.pieces[!player])){
+        return -MATE*(d+1);
+    }
+    if(boardIsFull()){
+        return 0;
+    }
+    */
+    if(d <= 0){
+        SEARCH_STAT(++stats.leafEvals;)
+        int eval;
+        if constexpr (STANDARD) eval = _useNNUE? _nnue.evaluate(player) : evalBoardState(_board, player);
+        else eval = evalBoardState(_board, player);
+        return leave(eval, -1, SearchTrace::LEAF);
+    }
+
+    int bestScore = -MATE;
+    int res = -MATE/10;
+    PVLine childPV;
+
+    for(int i = 0; i < CELLS; ++i){
+        int bestMove = SORTED_CELL_VALUES[i];
+
+        if(!moveIsLegal(_board.pieces[RED] | _board.pieces[YELLOW], bestMove)) continue;
+        makeMove(player, bestMove);
+        res = -negamax(static_cast<Color>(!player), -b, -a, d-1, pv ? &childPV : nullptr);
+        unmakeMove(player, bestMove);
+        ++searched;
+
+        if(pv && res > a){
+            pv->moves[0] = static_cast<int8_t>(bestMove);
+            std::copy(childPV.moves.begin(), childPV.moves.begin() + childPV.length, pv->moves.begin() + 1);
+            pv->length = childPV.length + 1;
+        }
+
+        bestScore = std::max(bestScore, res);
+        a = std::max(a, res);
+
+        if(a >= b){
+            SEARCH_STAT(
+                ++stats.betaCutoffs;
+                if(searched == 1) ++stats.firstMoveCutoffs;
+            )
+            return leave(bestScore, searched - 1, 0);
+        }
+
+    }
+
+    return leave(bestScore, -1, 0);
+
+
+}
+
+
+template <int W, int H, int N>
+int BasicConnect4Engine<W, H, N>::assessWinPattern(const Board& board, const Color color, const int patternIdx) const{
+    if((WINNING_PATTERNS[patternIdx] & board.pieces[!color]) != 0)
+        return 0;
+
+
+    int piecesMatched = popcount(board.pieces[color] & WINNING_PATTERNS[patternIdx]);
+
+    return piecesMatched == N? MATE : 1 << piecesMatched;
+}
+
+
+template <int W, int H, int N>
+int BasicConnect4Engine<W, H, N>::evalBoardState(const Board& board, const Color color) const{
+    int score = 0;
+    int oppScore = 0;
+
+    for(int i = 0; i < PATTERN_COUNT; ++i){
+        score += assessWinPattern(board, color, i);
+        oppScore += assessWinPattern(board, static_cast<Color>(!color), i);
+    }
+
+    return score - (oppScore/1.2);
+
+}
+
+
+template <int W, int H, int N>
+void BasicConnect4Engine<W, H, N>::traceSearch(const Color me, const int d){
+    if constexpr (TRACEABLE)
+        if(_trace) _trace->beginSearch(_board.pieces, me == YELLOW, d);
+}
+
+template <int W, int H, int N>
+void BasicConnect4Engine<W, H, N>::traceNode(const Color player, const int alpha, const int beta, const int score, const uint64_t startNodes,
+                                             const int cutoffIdx, const int searched, const uint8_t flags){
+    if constexpr (TRACEABLE){
+        SearchTrace::Record r;
+        r.pieces = _board.pieces;
+        r.alpha = alpha;
+        r.beta = beta;
+        r.score = score;
+        r.subtreeNodes = static_cast<uint32_t>(std::min<uint64_t>(_nodes - startNodes + 1, UINT32_MAX));
+        r.ply = static_cast<uint8_t>(_ply);
+        r.cutoffIdx = static_cast<int8_t>(cutoffIdx);
+        r.searched = static_cast<uint8_t>(searched);
+        r.flags = flags | (player == YELLOW ? SearchTrace::PLAYER_YELLOW : 0);
+        _trace->record(r);
+    }
+}
+
+
+template <int W, int H, int N>
+void BasicConnect4Engine<W, H, N>::pollLimits(){
+    if(_stop && _stop->load(std::memory_order_relaxed)) _aborted = true;
+    if(_hasDeadline && std::chrono::steady_clock::now() >= _deadline) _aborted = true;
+    if(_nodeLimit && _nodes >= _nodeLimit) _aborted = true;
+}
+
+
+template <int W, int H, int N>
+void BasicConnect4Engine<W, H, N>::makeMove(const Color player, const int idx){
+    _board.pieces[player] |= cellMask(idx);
+    if constexpr (STANDARD)
+        if(_useNNUE) _nnue.addPiece(player, idx);
+    ++_ply;
+}
+
+template <int W, int H, int N>
+void BasicConnect4Engine<W, H, N>::unmakeMove(const Color player, const int idx){
+    _board.pieces[player] &= ~cellMask(idx);
+    if constexpr (STANDARD)
+        if(_useNNUE) _nnue.removePiece(player, idx);
+    --_ply;
+}
+
+
+template <int W, int H, int N>
+bool BasicConnect4Engine<W, H, N>::boardIsFull(const Board& board){
+    return ((board.pieces[RED] | board.pieces[YELLOW]) == FULL_MASK);
+}
+
+
+template <int W, int H, int N>
+int BasicConnect4Engine<W, H, N>::winner(const Board& board){
+    for(int i = 0; i < PATTERN_COUNT; ++i)
+        if((WINNING_PATTERNS[i] & board.pieces[RED]) == WINNING_PATTERNS[i])
+            return RED;
+
+    for(int i = 0; i < PATTERN_COUNT; ++i)
+        if((WINNING_PATTERNS[i] & board.pieces[YELLOW]) == WINNING_PATTERNS[i])
+            return YELLOW;
+
+    return -1;
+}
+
+
+template <int W, int H, int N>
+bool BasicConnect4Engine<W, H, N>::comboWon(const BitBoard piecies){
+
+    return
+
+    // Horizontal (stride 1)
+    (runs<1>(piecies) & HORIZONTAL_START) ||
+
+    // Vertical (stride W)
+    (runs<W>(piecies) & VERTICAL_START) ||
+
+    // Diagonal LR '\' (stride W+1)
+    (runs<W+1>(piecies) & DIAGONAL_LR_START) ||
+
+    // Diagonal RL '/' (stride W-1)
+    (runs<W-1>(piecies) & DIAGONAL_RL_START);
+
+}
+
+
+template <int W, int H, int N>
+bool BasicConnect4Engine<W, H, N>::moveIsLegal(const BitBoard board, const int i){
+
+    return ((board & cellMask(i)) == 0 && ( (i>=W*(H-1)) || ((board & cellMask(i+W)) != 0)));
+
+}
+
+template <int W, int H, int N>
+int BasicConnect4Engine<W, H, N>::landingCell(const BitBoard board, const int column){
+    for(int idx = W*(H-1) + column; idx >= 0; idx -= W)
+        if((board & cellMask(idx)) == 0) return idx;
+    return -1;
+}
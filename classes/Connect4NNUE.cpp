@@ -0,0 +1,295 @@
+#include "Connect4NNUE.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CONNECT4_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define NNUE_TARGET(isa)
+#else
+#define NNUE_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+
+
+bool Connect4NNUE::loadWeights(const std::string& path, std::string* error){
+    auto fail = [&](const std::string& msg){
+        if(error) *error = msg;
+        _loaded = false;
+        _weights.reset();
+        return false;
+    };
+
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open()) return fail("could not open " + path);
+
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::shared_ptr<Weights> weights = std::make_shared<Weights>();
+    Weights& w = *weights;
+
+    size_t offset = 0;
+    auto read = [&](void* dst, const size_t bytes){
+        if(offset + bytes > data.size()) return false;
+        std::memcpy(dst, data.data() + offset, bytes);
+        offset += bytes;
+        return true;
+    };
+
+    char magic[4];
+    uint32_t version = 0;
+    if(!read(magic, sizeof(magic)) || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0)
+        return fail("bad magic in " + path);
+    if(!read(&version, sizeof(version)) || version != FILE_VERSION)
+        return fail("unsupported version in " + path);
+
+    bool ok =
+        read(w.ftBias.data(),     sizeof(w.ftBias))    &&
+        read(w.ftWeights.data(),  sizeof(w.ftWeights)) &&
+        read(w.l1Bias.data(),     sizeof(w.l1Bias))    &&
+        read(w.l1Weights.data(),  sizeof(w.l1Weights)) &&
+        read(w.l2Bias.data(),     sizeof(w.l2Bias))    &&
+        read(w.l2Weights.data(),  sizeof(w.l2Weights)) &&
+        read(&w.outBias,          sizeof(w.outBias))   &&
+        read(w.outWeights.data(), sizeof(w.outWeights));
+
+    if(!ok) return fail("truncated weight file " + path);
+    if(offset != data.size()) return fail("trailing bytes in " + path);
+
+    _weights = std::move(weights);
+    _loaded = true;
+    refresh(0, 0);
+    return true;
+}
+
+
+void Connect4NNUE::refresh(const uint64_t red, const uint64_t yellow){
+    if(!_loaded) return;
+
+    _acc[0] = _weights->ftBias;
+    _acc[1] = _weights->ftBias;
+
+    // 0 = MSB, same as getBit()
+    for(int cell = 0; cell < CELLS; ++cell){
+        if((red >> (63 - cell)) & 1ULL)    addPiece(0, cell);
+        if((yellow >> (63 - cell)) & 1ULL) addPiece(1, cell);
+    }
+}
+
+void Connect4NNUE::addPiece(const int color, const int cell){
+    const int16_t* ft = _weights->ftWeights.data();
+    addRow(_acc[0].data(), ft + feature(0, color, cell)*ACC_SIZE);
+    addRow(_acc[1].data(), ft + feature(1, color, cell)*ACC_SIZE);
+}
+
+void Connect4NNUE::removePiece(const int color, const int cell){
+    const int16_t* ft = _weights->ftWeights.data();
+    subRow(_acc[0].data(), ft + feature(0, color, cell)*ACC_SIZE);
+    subRow(_acc[1].data(), ft + feature(1, color, cell)*ACC_SIZE);
+}
+
+
+int Connect4NNUE::evaluate(const int color) const{
+    const Weights& w = *_weights;
+
+    alignas(32) std::array<uint8_t, 2*ACC_SIZE> in;
+    alignas(32) std::array<uint8_t, L1_SIZE> h1;
+    alignas(32) std::array<uint8_t, L2_SIZE> h2;
+
+    // side to move first, then opponent
+    clampToU8(in.data(),            _acc[color].data(),  ACC_SIZE);
+    clampToU8(in.data() + ACC_SIZE, _acc[!color].data(), ACC_SIZE);
+
+    for(int i = 0; i < L1_SIZE; ++i){
+        int sum = w.l1Bias[i] + dotU8I8(in.data(), w.l1Weights.data() + i*2*ACC_SIZE, 2*ACC_SIZE);
+        h1[i] = static_cast<uint8_t>(std::clamp(sum >> WEIGHT_SHIFT, 0, ACT_MAX));
+    }
+
+    for(int i = 0; i < L2_SIZE; ++i){
+        int sum = w.l2Bias[i] + dotU8I8(h1.data(), w.l2Weights.data() + i*L1_SIZE, L1_SIZE);
+        h2[i] = static_cast<uint8_t>(std::clamp(sum >> WEIGHT_SHIFT, 0, ACT_MAX));
+    }
+
+    int out = w.outBias + dotU8I8(h2.data(), w.outWeights.data(), L2_SIZE);
+    return out / OUTPUT_DIV;
+}
+
+
+
+namespace{
+
+void addRowScalar(int16_t* acc, const int16_t* row, const int len){
+    for(int i = 0; i < len; ++i)
+        acc[i] = static_cast<int16_t>(acc[i] + row[i]);
+}
+
+void subRowScalar(int16_t* acc, const int16_t* row, const int len){
+    for(int i = 0; i < len; ++i)
+        acc[i] = static_cast<int16_t>(acc[i] - row[i]);
+}
+
+void clampToU8Scalar(uint8_t* out, const int16_t* in, const int len, const int top){
+    for(int i = 0; i < len; ++i)
+        out[i] = static_cast<uint8_t>(std::clamp<int>(in[i], 0, top));
+}
+
+int dotU8I8Scalar(const uint8_t* in, const int8_t* weights, const int len){
+    int sum = 0;
+    for(int i = 0; i < len; ++i)
+        sum += static_cast<int>(in[i]) * static_cast<int>(weights[i]);
+    return sum;
+}
+
+#ifdef CONNECT4_X64
+
+// lengths are multiples of 32, rows and accumulators 32 byte aligned
+NNUE_TARGET("avx2")
+void addRowAVX2(int16_t* acc, const int16_t* row, const int len){
+    for(int i = 0; i < len; i += 16){
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i r = _mm256_load_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_add_epi16(a, r));
+    }
+}
+
+NNUE_TARGET("avx2")
+void subRowAVX2(int16_t* acc, const int16_t* row, const int len){
+    for(int i = 0; i < len; i += 16){
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        __m256i r = _mm256_load_si256(reinterpret_cast<const __m256i*>(row + i));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(acc + i), _mm256_sub_epi16(a, r));
+    }
+}
+
+NNUE_TARGET("avx2")
+void clampToU8AVX2(uint8_t* out, const int16_t* in, const int len, const int top){
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i high = _mm256_set1_epi16(static_cast<int16_t>(top));
+    for(int i = 0; i < len; i += 32){
+        __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + i + 16));
+        a = _mm256_min_epi16(_mm256_max_epi16(a, zero), high);
+        b = _mm256_min_epi16(_mm256_max_epi16(b, zero), high);
+        // packus works per 128 bit lane, permute restores the original order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0b11011000);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+}
+
+NNUE_TARGET("avx2")
+int dotU8I8AVX2(const uint8_t* in, const int8_t* weights, const int len){
+    // activations are <= 127 so maddubs can not saturate
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for(int i = 0; i < len; i += 32){
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(a, b), ones));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0b01001110));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0b10110001));
+    return _mm_cvtsi128_si32(s);
+}
+
+bool cpuHasAVX2(){
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) return false;
+    __cpuidex(info, 7, 0);
+    const bool avx2 = (info[1] >> 5) & 1;
+    // AVX state has to be enabled by the OS as well
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] >> 27) & 1;
+    return avx2 && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+}
+
+void Connect4NNUE::addRow(int16_t* acc, const int16_t* row){
+#ifdef CONNECT4_X64
+    if(_kernel == Kernel::AVX2) return addRowAVX2(acc, row, ACC_SIZE);
+#endif
+    addRowScalar(acc, row, ACC_SIZE);
+}
+
+void Connect4NNUE::subRow(int16_t* acc, const int16_t* row){
+#ifdef CONNECT4_X64
+    if(_kernel == Kernel::AVX2) return subRowAVX2(acc, row, ACC_SIZE);
+#endif
+    subRowScalar(acc, row, ACC_SIZE);
+}
+
+void Connect4NNUE::clampToU8(uint8_t* out, const int16_t* in, const int len){
+#ifdef CONNECT4_X64
+    if(_kernel == Kernel::AVX2) return clampToU8AVX2(out, in, len, ACT_MAX);
+#endif
+    clampToU8Scalar(out, in, len, ACT_MAX);
+}
+
+int Connect4NNUE::dotU8I8(const uint8_t* in, const int8_t* weights, const int len){
+#ifdef CONNECT4_X64
+    if(_kernel == Kernel::AVX2) return dotU8I8AVX2(in, weights, len);
+#endif
+    return dotU8I8Scalar(in, weights, len);
+}
+
+
+bool Connect4NNUE::kernelSupported(const Kernel kernel){
+    if(kernel == Kernel::SCALAR) return true;
+#ifdef CONNECT4_X64
+    return cpuHasAVX2();
+#else
+    return false;
+#endif
+}
+
+const char* Connect4NNUE::kernelName(const Kernel kernel){
+    return kernel == Kernel::AVX2 ? "avx2" : "scalar";
+}
+
+bool Connect4NNUE::setKernel(const Kernel kernel){
+    if(!kernelSupported(kernel)) return false;
+    _kernel = kernel;
+    return true;
+}
+
+namespace{
+
+const bool NNUE_KERNEL_SELECTED = Connect4NNUE::setKernel(Connect4NNUE::Kernel::AVX2);
+
+}
+
+
+
+bool Connect4NNUE::appendTrainingGame(const std::string& path, const std::vector<std::array<uint64_t, 2>>& positions, const int winner){
+    std::ofstream file(path, std::ios::app);
+    if(!file.is_open()) return false;
+
+    char line[96];
+    for(const std::array<uint64_t, 2>& pos : positions){
+        const int ply = std::popcount(pos[0] | pos[1]);
+        const int sideToMove = ply % 2;
+        const int result = winner < 0 ? 0 : (winner == sideToMove ? 1 : -1);
+
+        std::snprintf(line, sizeof(line), "%016llx %016llx %d %d %d\n",
+                      static_cast<unsigned long long>(pos[0]), static_cast<unsigned long long>(pos[1]),
+                      sideToMove, ply, result);
+        file << line;
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// small quantized evaluator for the 7x6 board
+// 84 binary inputs (42 cells x {own, opponent}) per perspective
+//  -> 2 x 128 int16 accumulator (updated incrementally on make/unmake)
+//  -> 32 int8 -> 32 int8 -> 1
+// cells use the same 0..41 indexing as Connect4 (0 = top left, 41 = bottom right)
+class Connect4NNUE{
+
+public:
+
+    static constexpr int CELLS = 42;
+    static constexpr int INPUTS = 2*CELLS;
+    static constexpr int ACC_SIZE = 128;
+    static constexpr int L1_SIZE = 32;
+    static constexpr int L2_SIZE = 32;
+
+    static constexpr int ACT_MAX = 127;     // clipped relu range of every hidden activation
+    static constexpr int WEIGHT_SHIFT = 6;  // int8 weights are scaled by 2^6
+    static constexpr int OUTPUT_DIV = 16;   // raw output -> eval units
+
+    // flat little endian weight file, see loadWeights()
+    static constexpr char     FILE_MAGIC[4] = {'C', '4', 'N', 'N'};
+    static constexpr uint32_t FILE_VERSION = 1;
+
+    Connect4NNUE() = default;
+
+    bool        loadWeights(const std::string& path, std::string* error = nullptr);
+    bool        loaded() const { return _loaded; }
+
+    // rebuilds both accumulators from scratch
+    void        refresh(const uint64_t red, const uint64_t yellow);
+    // incremental first layer updates, color is Connect4::Color (0 = red, 1 = yellow)
+    void        addPiece(const int color, const int cell);
+    void        removePiece(const int color, const int cell);
+
+    // score from the point of view of color (the side to move)
+    int         evaluate(const int color) const;
+    // accumulator seen from perspective (0 = red, 1 = yellow), for tests
+    const std::array<int16_t, ACC_SIZE>& accumulator(const int perspective) const { return _acc[perspective]; }
+
+    // accumulator and dot product kernels, same results: plain loops, or AVX2 (built in with a target attribute,
+    // used when the CPU has it). picked once at startup for every instance
+    enum class Kernel: uint8_t{ SCALAR, AVX2 };
+    // compiled in and the CPU has the instructions (CPUID)
+    static bool        kernelSupported(const Kernel kernel);
+    static const char* kernelName(const Kernel kernel);
+    static Kernel      kernel() { return _kernel; }
+    // false and no change when the kernel is not supported, for benchmarks and tests
+    static bool        setKernel(const Kernel kernel);
+
+    // appends one finished self-play game as trainer input, one position per line:
+    // <red hex> <yellow hex> <side to move> <ply> <result for side to move: 1 win, 0 draw, -1 loss>
+    // winner is 0 (red), 1 (yellow) or -1 (draw)
+    static bool appendTrainingGame(const std::string& path, const std::vector<std::array<uint64_t, 2>>& positions, const int winner);
+
+private:
+
+    struct Weights{
+        alignas(32) std::array<int16_t, ACC_SIZE>                 ftBias;
+        alignas(32) std::array<int16_t, INPUTS*ACC_SIZE>          ftWeights;  // [input][acc]
+        alignas(32) std::array<int32_t, L1_SIZE>                  l1Bias;
+        alignas(32) std::array<int8_t,  L1_SIZE*2*ACC_SIZE>       l1Weights;  // [out][in]
+        alignas(32) std::array<int32_t, L2_SIZE>                  l2Bias;
+        alignas(32) std::array<int8_t,  L2_SIZE*L1_SIZE>          l2Weights;  // [out][in]
+        int32_t                                                   outBias;
+        alignas(32) std::array<int8_t,  L2_SIZE>                  outWeights;
+    };
+
+    // acc[p] is the accumulator seen from perspective p
+    alignas(32) std::array<std::array<int16_t, ACC_SIZE>, 2> _acc{};
+
+    // heap allocated (the feature table alone is 21KB) and shared between copies,
+    // so search threads can each take their own accumulator cheaply
+    std::shared_ptr<const Weights> _weights;
+    bool _loaded = false;
+
+    static int  feature(const int perspective, const int color, const int cell) { return cell + (perspective == color ? 0 : CELLS); }
+
+    static void addRow(int16_t* acc, const int16_t* row);
+    static void subRow(int16_t* acc, const int16_t* row);
+    static void clampToU8(uint8_t* out, const int16_t* in, const int len);
+    static int  dotU8I8(const uint8_t* in, const int8_t* weights, const int len);
+
+    // scalar until Connect4NNUE.cpp's startup selection runs
+    static inline Kernel _kernel = Kernel::SCALAR;
+};
@@ -1,16 +1,19 @@
 #include "Othello.h"
+#include <bit>
 #include <iostream>
-#define lambda auto
-// Define the 8 directions: N, NE, E, SE, S, SW, W, NW
-const int Othello::DIRECTIONS[8][2] = {
-    {0, -1}, {1, -1}, {1, 0}, {1, 1},
-    {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}
-};
 
 Othello::Othello() : Game() {
     _grid = new Grid(8, 8);
     _consecutivePasses = 0;
     _showingHints = false;
+    _hintSquares = 0;
+    _discTextures[OthelloBoard::BLACK] = _discTextures[OthelloBoard::WHITE] = 0;
+    _discTexturesLoaded = false;
+    _animateFlips = true;
+    _engine.loadPatterns(PATTERN_WEIGHTS_PATH);
+    _engine.loadBook(OPENING_BOOK_PATH);
+    _engine.setEndgamePool(&ThreadPool::shared());
+    refreshMoveCache();
 }
 
 Othello::~Othello() {
@@ -23,37 +26,39 @@ void Othello::setUpBoard() {
     _gameOptions.rowY = 8;
 
     _grid->initializeSquares(80, "boardsquare.png");
+    loadDiscTextures();
 
-    // Set up initial four pieces in the center
-    Player* blackPlayer = getPlayerAt(BLACK_PLAYER);
-    Player* whitePlayer = getPlayerAt(WHITE_PLAYER);
-
-    // Standard Othello starting position
-    lambda placePiece = [&](int x, int y, Player* player) {
-        Bit* piece = createPiece(player);
-        piece->setPosition(_grid->getSquare(x, y)->getPosition());
-        _grid->getSquare(x, y)->setBit(piece);
-    };
-
-    placePiece(3, 3, whitePlayer);  // White at (3,3)
-    placePiece(4, 4, whitePlayer);  // White at (4,4)
-    placePiece(4, 3, blackPlayer);  // Black at (4,3)
-    placePiece(3, 4, blackPlayer);  // Black at (3,4)
+    // Standard Othello starting position: white (3,3) and (4,4), black (4,3) and (3,4)
+    _position = OthelloBoard();
+    syncGrid(_position.occupied());
+    refreshMoveCache();
 
     if (gameHasAI()) {
         setAIPlayer(AI_PLAYER);
     }
     
     startGame();
+    updateHints(getCurrentPlayer());
 }
 
 Bit* Othello::createPiece(Player* player) {
+    const OthelloBoard::Color color = colorOf(player);
     Bit* bit = new Bit();
-    bit->LoadTextureFromFile(player == getPlayerAt(BLACK_PLAYER) ? "o.png" : "x.png");
+    bit->setTexture(_discTextures[color]);
+    bit->setSize(_discSize[color].x, _discSize[color].y);
     bit->setOwner(player);
     return bit;
 }
 
+void Othello::loadDiscTextures() {
+    // tried once, a missing image stays missing instead of being read again for every new or flipped disc
+    if (_discTexturesLoaded) return;
+    _discTexturesLoaded = true;
+
+    for (OthelloBoard::Color color : {OthelloBoard::BLACK, OthelloBoard::WHITE})
+        _discTextures[color] = Sprite::LoadTexture(color == OthelloBoard::BLACK ? "o.png" : "x.png", _discSize[color]);
+}
+
 bool Othello::actionForEmptyHolder(BitHolder &holder) {
     if (holder.bit()) return false;
 
@@ -62,15 +67,12 @@ bool Othello::actionForEmptyHolder(BitHolder &holder) {
     int y = square->getRow();
     Player* currentPlayer = getCurrentPlayer();
 
+    // Place the piece and flip all affected pieces, an illegal move changes nothing
     if (!isValidMove(x, y, currentPlayer)) return false;
+    const uint64_t flipped = _position.play(colorOf(currentPlayer), y * 8 + x);
 
-    // Place the piece
-    Bit* newPiece = createPiece(currentPlayer);
-    newPiece->setPosition(holder.getPosition());
-    holder.setBit(newPiece);
-
-    // Flip all affected pieces
-    flipPieces(x, y, currentPlayer);
+    syncGrid(flipped | OthelloBoard::squareMask(y * 8 + x), _animateFlips);
+    refreshMoveCache();
     _consecutivePasses = 0;
 
     // Check if next player has moves
@@ -79,12 +81,14 @@ bool Othello::actionForEmptyHolder(BitHolder &holder) {
         _consecutivePasses++;
         if (hasValidMove(currentPlayer)) {
             // Next player passes, current player continues
+            updateHints(currentPlayer);
             return true;
         } else {
             _consecutivePasses = 2; // Game ends
         }
     }
 
+    updateHints(nextPlayer);
     endTurn();
     return true;
 }
@@ -98,127 +102,69 @@ bool Othello::canBitMoveFromTo(Bit &bit, BitHolder &src, BitHolder &dst) {
 }
 
 bool Othello::isValidMove(int x, int y, Player* player) const {
-    if (!_grid->isValid(x, y) || _grid->getSquare(x, y)->bit()) return false;
-
-    // Check if placing a piece here would flip at least one opponent piece
-    for (int i = 0; i < 8; i++) {
-        if (checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player) > 0) {
-            return true;
-        }
-    }
-    return false;
+    if (!_grid->isValid(x, y)) return false;
+    return (_legalMoves[colorOf(player)] & OthelloBoard::squareMask(y * 8 + x)) != 0;
 }
 
-int Othello::checkDirection(int x, int y, int dx, int dy, Player* player) const {
-    int count = 0;
-    int nx = x + dx;
-    int ny = y + dy;
-
-    if (!_grid->isValid(nx, ny)) return 0;
-
-    Bit* firstPiece = _grid->getSquare(nx, ny)->bit();
-    if (!firstPiece || firstPiece->getOwner() == player) return 0;
-
-    // Count opponent pieces in this direction
-    while (_grid->isValid(nx, ny)) {
-        Bit* piece = _grid->getSquare(nx, ny)->bit();
-        if (!piece) return 0;
-        if (piece->getOwner() == player) return count;
-        count++;
-        nx += dx;
-        ny += dy;
-    }
-    return 0;
+bool Othello::hasValidMove(Player* player) const {
+    return _legalMoves[colorOf(player)] != 0;
 }
 
-void Othello::flipPieces(int x, int y, Player* player) {
-    for (int i = 0; i < 8; i++) {
-        int count = checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player);
-        if (count > 0) {
-            flipInDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player, count);
-        }
+std::vector<std::pair<int, int>> Othello::getValidMoves(Player* player) const {
+    std::vector<std::pair<int, int>> moves;
+    for (uint64_t legal = _legalMoves[colorOf(player)]; legal; legal &= legal - 1) {
+        const int sq = std::countr_zero(legal);
+        moves.push_back({sq % 8, sq / 8});
     }
+    return moves;
 }
 
-void Othello::flipInDirection(int x, int y, int dx, int dy, Player* player, int count) {
-    int nx = x + dx;
-    int ny = y + dy;
+void Othello::syncGrid(uint64_t changed, bool animate) {
+    for (; changed; changed &= changed - 1) {
+        const int sq = std::countr_zero(changed);
+        ChessSquare* square = _grid->getSquare(sq % 8, sq / 8);
 
-    for (int i = 0; i < count; i++) {
-        ChessSquare* square = _grid->getSquare(nx, ny);
-        if (square && square->bit()) {
+        const uint64_t mask = OthelloBoard::squareMask(sq);
+        if (!(_position.occupied() & mask)) {
             square->destroyBit();
-            Bit* newPiece = createPiece(player);
-            newPiece->setPosition(square->getPosition());
-            square->setBit(newPiece);
+            continue;
         }
-        nx += dx;
-        ny += dy;
-    }
-}
 
-bool Othello::hasValidMove(Player* player) const {
-    bool hasMove = false;
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (!hasMove && isValidMove(x, y, player)) {
-            hasMove = true;
+        const OthelloBoard::Color color = (_position.discs(OthelloBoard::WHITE) & mask) ? OthelloBoard::WHITE : OthelloBoard::BLACK;
+        Player* owner = getPlayerAt(color == OthelloBoard::WHITE ? WHITE_PLAYER : BLACK_PLAYER);
+        if (Bit* bit = square->bit()) {
+            // a disc that changed colour is turned over, no new Bit and no texture load
+            if (bit->getOwner() != owner) bit->flipTo(owner, _discTextures[color], animate);
+            continue;
         }
-    });
-    return hasMove;
+
+        Bit* piece = createPiece(owner);
+        piece->setPosition(square->getPosition());
+        square->setBit(piece);
+    }
 }
 
-std::vector<std::pair<int, int>> Othello::getValidMoves(Player* player) const {
-    std::vector<std::pair<int, int>> moves;
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (isValidMove(x, y, player)) {
-            moves.push_back({x, y});
-        }
-    });
-    return moves;
+void Othello::refreshMoveCache() {
+    for (OthelloBoard::Color color : {OthelloBoard::BLACK, OthelloBoard::WHITE}) {
+        _legalMoves[color] = _position.legal(color);
+        _discCount[color] = _position.count(color);
+    }
 }
 
 Player* Othello::checkForWinner() {
-    // Game ends when neither player can move
-    if (_consecutivePasses >= 2 ||
-        (!hasValidMove(getPlayerAt(BLACK_PLAYER)) && !hasValidMove(getPlayerAt(WHITE_PLAYER)))) {
-
+    // Game ends when neither player can move, a full board included
+    if (_consecutivePasses >= 2 || noMovesLeft()) {
         int blackCount, whiteCount;
         countPieces(blackCount, whiteCount);
 
         if (blackCount > whiteCount) return getPlayerAt(BLACK_PLAYER);
         if (whiteCount > blackCount) return getPlayerAt(WHITE_PLAYER);
     }
-
-    // Check if board is full
-    bool boardFull = true;
-    _grid->forEachSquare([&boardFull](ChessSquare* square, int x, int y) {
-        if (!square->bit()) boardFull = false;
-    });
-
-    if (boardFull) {
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-        if (blackCount > whiteCount) return getPlayerAt(BLACK_PLAYER);
-        if (whiteCount > blackCount) return getPlayerAt(WHITE_PLAYER);
-    }
-
     return nullptr;
 }
 
 bool Othello::checkForDraw() {
-    if (_consecutivePasses >= 2 ||
-        (!hasValidMove(getPlayerAt(BLACK_PLAYER)) && !hasValidMove(getPlayerAt(WHITE_PLAYER)))) {
-        int blackCount, whiteCount;
-        countPieces(blackCount, whiteCount);
-        return blackCount == whiteCount;
-    }
-
-    bool boardFull = true;
-    _grid->forEachSquare([&boardFull](ChessSquare* square, int x, int y) {
-        if (!square->bit()) boardFull = false;
-    });
-
-    if (boardFull) {
+    if (_consecutivePasses >= 2 || noMovesLeft()) {
         int blackCount, whiteCount;
         countPieces(blackCount, whiteCount);
         return blackCount == whiteCount;
@@ -227,25 +173,17 @@ bool Othello::checkForDraw() {
 }
 
 void Othello::countPieces(int &blackCount, int &whiteCount) const {
-    blackCount = 0;
-    whiteCount = 0;
-
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        Bit* piece = square->bit();
-        if (piece) {
-            if (piece->getOwner() == getPlayerAt(BLACK_PLAYER)) {
-                blackCount++;
-            } else {
-                whiteCount++;
-            }
-        }
-    });
+    blackCount = _discCount[OthelloBoard::BLACK];
+    whiteCount = _discCount[OthelloBoard::WHITE];
 }
 
 void Othello::stopGame() {
+    clearValidMoveIndicators();
     _grid->forEachSquare([](ChessSquare* square, int x, int y) {
         square->destroyBit();
     });
+    _position = OthelloBoard(0, 0);
+    refreshMoveCache();
     _consecutivePasses = 0;
 }
 
@@ -259,71 +197,34 @@ std::string Othello::initialStateString() {
 }
 
 std::string Othello::stateString() {
-    std::string state;
-    _grid->forEachSquare([&state, this](ChessSquare* square, int x, int y) {
-        Bit* bit = square->bit();
-        if (!bit) {
-            state += '0';
-        } else if (bit->getOwner() == getPlayerAt(BLACK_PLAYER)) {
-            state += '1';
-        } else {
-            state += '2';
-        }
-    });
-    return state;
+    return _position.stateString();
 }
 
 void Othello::setStateString(const std::string &s) {
-    if (s.length() != 64) return;
-
-    int index = 0;
-    _grid->forEachSquare([&](ChessSquare* square, int x, int y) {
-        if (index < s.length()) {
-            char pieceType = s[index++];
-            square->destroyBit();
-
-            if (pieceType == '1') {
-                Bit* piece = createPiece(getPlayerAt(BLACK_PLAYER));
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
-            } else if (pieceType == '2') {
-                Bit* piece = createPiece(getPlayerAt(WHITE_PLAYER));
-                piece->setPosition(square->getPosition());
-                square->setBit(piece);
-            }
-        }
-    });
+    if (!_position.setStateString(s)) return;
+    syncGrid(~uint64_t(0));
+    refreshMoveCache();
+    updateHints(getCurrentPlayer());
 }
 
 void Othello::updateAI() {
     if (!gameHasAI()) return;
 
     Player* aiPlayer = getCurrentPlayer();
-    std::vector<std::pair<int, int>> validMoves = getValidMoves(aiPlayer);
-
-    if (validMoves.empty()) {
+    if (!hasValidMove(aiPlayer)) {
         _consecutivePasses++;
+        updateHints(getPlayerAt(1 - aiPlayer->playerNumber()));
         endTurn();
         return;
     }
 
-    // Find move that flips the most pieces
-    int bestX = -1, bestY = -1, maxFlips = 0;
+    // Iterative deepening on the bitboard engine until the time budget runs out
+    _engine.setDeadline(std::chrono::steady_clock::now() + std::chrono::milliseconds(AI_TIME_MS));
+    const OthelloEngine::SearchResult result = _engine.search(_position, colorOf(aiPlayer), AI_MAX_DEPTH);
+    _engine.clearDeadline();
 
-    for (const auto& move : validMoves) {
-        int x = move.first, y = move.second, totalFlips = 0;
-        for (int i = 0; i < 8; i++) {
-            totalFlips += checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], aiPlayer);
-        }
-        if (totalFlips > maxFlips) {
-            maxFlips = totalFlips;
-            bestX = x;
-            bestY = y;
-        }
-    }
-
-    if (bestX >= 0 && bestY >= 0) {
-        actionForEmptyHolder(*_grid->getSquare(bestX, bestY));
+    if (result.bestMove >= 0) {
+        actionForEmptyHolder(*_grid->getSquare(result.bestMove % 8, result.bestMove / 8));
     }
 }
 
@@ -334,9 +235,25 @@ void Othello::getBoardPosition(BitHolder& holder, int &x, int &y) const {
 }
 
 void Othello::showValidMoves(Player* player) {
+    // only touch the squares whose hint actually changes
+    const uint64_t hints = _legalMoves[colorOf(player)];
+    for (uint64_t changed = hints ^ _hintSquares; changed; changed &= changed - 1) {
+        const int sq = std::countr_zero(changed);
+        _grid->getSquare(sq % 8, sq / 8)->setHighlighted((hints & OthelloBoard::squareMask(sq)) != 0);
+    }
+    _hintSquares = hints;
     _showingHints = true;
 }
 
 void Othello::clearValidMoveIndicators() {
+    for (; _hintSquares; _hintSquares &= _hintSquares - 1) {
+        const int sq = std::countr_zero(_hintSquares);
+        _grid->getSquare(sq % 8, sq / 8)->setHighlighted(false);
+    }
     _showingHints = false;
+}
+
+void Othello::updateHints(Player* toMove) {
+    if (toMove && !toMove->isAIPlayer() && !noMovesLeft()) showValidMoves(toMove);
+    else clearValidMoveIndicators();
 }
\ No newline at end of file
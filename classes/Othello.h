@@ -1,5 +1,7 @@
 #pragma once
 #include "Game.h"
+#include "OthelloBoard.h"
+#include "OthelloEngine.h"
 #include <vector>
 
 // NOTE: This implementation assumes black.png and white.png exist in resources.
@@ -28,33 +30,60 @@ public:
     bool        gameHasAI() override { return true; } // Set to true when AI is implemented
     Grid* getGrid() override { return _grid; }
 
+    // flipped discs turn over on screen instead of changing colour at once
+    void        setAnimateFlips(bool animate) { _animateFlips = animate; }
+    bool        animateFlips() const { return _animateFlips; }
+
 private:
     // Player constants
     static const int BLACK_PLAYER = 0;
     static const int WHITE_PLAYER = 1;
 
-    // Direction vectors for checking all 8 directions
-    static const int DIRECTIONS[8][2];
+    // AI search budget per move, the depth cap only matters once the game end is in reach
+    static constexpr int AI_TIME_MS = 500;
+    static constexpr int AI_MAX_DEPTH = 60;
+    // fitted by othello_fit, the engine keeps its handcrafted evaluation without it
+    static constexpr const char* PATTERN_WEIGHTS_PATH = "resources/othello.patterns";
+    // built by othello_book, the AI searches from the first move without it
+    static constexpr const char* OPENING_BOOK_PATH = "resources/othello.book";
 
     // Helper methods
     Bit*        createPiece(Player* player);
+    // each disc image is decoded and uploaded once, every piece of that colour shares the texture
+    void        loadDiscTextures();
     bool        isValidMove(int x, int y, Player* player) const;
-    int         checkDirection(int x, int y, int dx, int dy, Player* player) const;
-    void        flipPieces(int x, int y, Player* player);
-    void        flipInDirection(int x, int y, int dx, int dy, Player* player, int count);
     bool        hasValidMove(Player* player) const;
     void        countPieces(int &blackCount, int &whiteCount) const;
     std::vector<std::pair<int, int>> getValidMoves(Player* player) const;
     void        showValidMoves(Player* player);
     void        clearValidMoveIndicators();
+    // recomputes both sides' legal moves and disc counts, called whenever _position changes
+    void        refreshMoveCache();
+    // hints for a human to move, none while the AI thinks or once the game is over
+    void        updateHints(Player* toMove);
+    bool        noMovesLeft() const { return !(_legalMoves[OthelloBoard::BLACK] | _legalMoves[OthelloBoard::WHITE]); }
 
     // Board position helper
     void        getBoardPosition(BitHolder& holder, int &x, int &y) const;
+    // makes the squares in changed show what _position holds there, discs that changed colour are flipped in place
+    void        syncGrid(uint64_t changed, bool animate = false);
+    static OthelloBoard::Color colorOf(Player* player) { return static_cast<OthelloBoard::Color>(player->playerNumber()); }
 
-    // Board representation
+    // Board representation: _position is the game state, the grid only displays it
+    OthelloBoard _position;
+    OthelloEngine _engine;
     Grid*       _grid;
+    ImTextureID _discTextures[2];
+    ImVec2      _discSize[2];
+    bool        _discTexturesLoaded;
+    bool        _animateFlips;
+
+    // Per position cache, indexed by OthelloBoard::Color
+    uint64_t    _legalMoves[2];
+    int         _discCount[2];
 
     // Game state
     int         _consecutivePasses;
     bool        _showingHints;
+    uint64_t    _hintSquares;
 };
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "OthelloBoard.h"
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OTHELLO_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define OTHELLO_TARGET(isa)
+#else
+#define OTHELLO_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace{
+
+// the 4 lines through a square (row, column, a1-h8 and h1-a8 diagonal) and the square's place in each, counted
+// from the line's lowest square, which is also its bit in a PEXT of the line
+struct Lines{
+    std::array<uint64_t, 4> masks;
+    std::array<uint8_t, 4> positions;
+};
+
+constexpr std::array<Lines, 64> LINES = []{
+    std::array<Lines, 64> lines{};
+    for(int sq = 0; sq < 64; ++sq){
+        const int x = sq % 8, y = sq / 8;
+        for(int other = 0; other < 64; ++other){
+            const int ox = other % 8, oy = other / 8;
+            const bool on[4] = {oy == y, ox == x, ox - oy == x - y, ox + oy == x + y};
+            for(int l = 0; l < 4; ++l){
+                if(!on[l]) continue;
+                lines[sq].masks[l] |= uint64_t(1) << other;
+                if(other < sq) ++lines[sq].positions[l];
+            }
+        }
+    }
+    return lines;
+}();
+
+// [position][opponent discs on the 6 inner squares of the line]: the squares just past the opponent runs next to
+// the position, a disc of mine there outflanks the run
+constexpr std::array<std::array<uint8_t, 64>, 8> OUTFLANK = []{
+    std::array<std::array<uint8_t, 64>, 8> table{};
+    for(int pos = 0; pos < 8; ++pos){
+        for(int inner = 0; inner < 64; ++inner){
+            const int opp = inner << 1;
+            int up = pos + 1;
+            while(up < 7 && ((opp >> up) & 1)) ++up;
+            int down = pos - 1;
+            while(down > 0 && ((opp >> down) & 1)) --down;
+
+            int outflank = 0;
+            if(up > pos + 1) outflank |= 1 << up;
+            if(down < pos - 1) outflank |= 1 << down;
+            table[pos][inner] = static_cast<uint8_t>(outflank);
+        }
+    }
+    return table;
+}();
+
+// [position][outflanking discs]: the squares between them and the position
+constexpr std::array<std::array<uint8_t, 256>, 8> FLIPPED = []{
+    std::array<std::array<uint8_t, 256>, 8> table{};
+    for(int pos = 0; pos < 8; ++pos){
+        for(int outflank = 0; outflank < 256; ++outflank){
+            int flipped = 0;
+            for(int b = 0; b < 8; ++b){
+                if(!((outflank >> b) & 1)) continue;
+                for(int between = std::min(b, pos) + 1; between < std::max(b, pos); ++between) flipped |= 1 << between;
+            }
+            table[pos][outflank] = static_cast<uint8_t>(flipped);
+        }
+    }
+    return table;
+}();
+
+#ifdef OTHELLO_X64
+bool cpuHas(const OthelloBoard::FlipKernel kernel){
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) return false;
+    __cpuidex(info, 7, 0);
+    if(kernel == OthelloBoard::FlipKernel::BMI2) return (info[1] >> 8) & 1;
+    const bool avx2 = (info[1] >> 5) & 1;
+    // AVX state has to be enabled by the OS as well
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] >> 27) & 1;
+    return avx2 && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+    __builtin_cpu_init();
+    if(kernel == OthelloBoard::FlipKernel::BMI2) return __builtin_cpu_supports("bmi2");
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+}
+
+
+
+
+bool OthelloBoard::setStateString(const std::string& s){
+    if(s.length() != SQUARES) return false;
+
+    std::array<uint64_t, 2> discs{0, 0};
+    for(int sq = 0; sq < SQUARES; ++sq){
+        if(s[sq] == '1') discs[BLACK] |= squareMask(sq);
+        else if(s[sq] == '2') discs[WHITE] |= squareMask(sq);
+        else if(s[sq] != '0') return false;
+    }
+
+    _discs = discs;
+    return true;
+}
+
+std::string OthelloBoard::stateString() const{
+    std::string state(SQUARES, '0');
+    for(int sq = 0; sq < SQUARES; ++sq){
+        if(_discs[BLACK] & squareMask(sq)) state[sq] = '1';
+        else if(_discs[WHITE] & squareMask(sq)) state[sq] = '2';
+    }
+    return state;
+}
+
+uint64_t OthelloBoard::play(const Color c, const int sq){
+    if(occupied() & squareMask(sq)) return 0;
+
+    const uint64_t flipped = flips(_discs[c], _discs[!c], sq);
+    if(!flipped) return 0;
+
+    _discs[c] |= flipped | squareMask(sq);
+    _discs[!c] &= ~flipped;
+    return flipped;
+}
+
+
+#ifdef OTHELLO_X64
+
+OTHELLO_TARGET("avx2")
+uint64_t OthelloBoard::flipsAVX2(const uint64_t me, const uint64_t opp, const int sq){
+    // lanes are the directions 1, 8, 9 and 7, shifted left they go towards higher squares and right towards lower
+    const __m256i step = _mm256_set_epi64x(7, 9, 8, 1);
+    const __m256i step2 = _mm256_add_epi64(step, step);
+    const __m256i step4 = _mm256_add_epi64(step2, step2);
+    const __m256i pro = _mm256_and_si256(_mm256_set1_epi64x(static_cast<long long>(opp)),
+        _mm256_set_epi64x(static_cast<long long>(INNER_COLUMNS), static_cast<long long>(INNER_COLUMNS), -1,
+                          static_cast<long long>(INNER_COLUMNS)));
+    const __m256i mine = _mm256_set1_epi64x(static_cast<long long>(me));
+    const __m256i move = _mm256_set1_epi64x(static_cast<long long>(squareMask(sq)));
+    const __m256i zero = _mm256_setzero_si256();
+
+    // the same occluded fill as fill<S>() and flipsAlong<S>(), both signs of 4 directions at once
+    __m256i up = _mm256_or_si256(move, _mm256_and_si256(pro, _mm256_sllv_epi64(move, step)));
+    __m256i down = _mm256_or_si256(move, _mm256_and_si256(pro, _mm256_srlv_epi64(move, step)));
+    __m256i proUp = _mm256_and_si256(pro, _mm256_sllv_epi64(pro, step));
+    __m256i proDown = _mm256_and_si256(pro, _mm256_srlv_epi64(pro, step));
+    up = _mm256_or_si256(up, _mm256_and_si256(proUp, _mm256_sllv_epi64(up, step2)));
+    down = _mm256_or_si256(down, _mm256_and_si256(proDown, _mm256_srlv_epi64(down, step2)));
+    proUp = _mm256_and_si256(proUp, _mm256_sllv_epi64(proUp, step2));
+    proDown = _mm256_and_si256(proDown, _mm256_srlv_epi64(proDown, step2));
+    up = _mm256_or_si256(up, _mm256_and_si256(proUp, _mm256_sllv_epi64(up, step4)));
+    down = _mm256_or_si256(down, _mm256_and_si256(proDown, _mm256_srlv_epi64(down, step4)));
+
+    // a run counts when the square past it is mine
+    const __m256i closedUp = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_sllv_epi64(up, step), mine), zero);
+    const __m256i closedDown = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_srlv_epi64(down, step), mine), zero);
+    const __m256i flipped = _mm256_andnot_si256(move, _mm256_or_si256(_mm256_andnot_si256(closedUp, up),
+                                                                       _mm256_andnot_si256(closedDown, down)));
+
+    __m128i lanes = _mm_or_si128(_mm256_castsi256_si128(flipped), _mm256_extracti128_si256(flipped, 1));
+    lanes = _mm_or_si128(lanes, _mm_unpackhi_epi64(lanes, lanes));
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(lanes));
+}
+
+OTHELLO_TARGET("bmi2")
+uint64_t OthelloBoard::flipsBMI2(const uint64_t me, const uint64_t opp, const int sq){
+    const Lines& lines = LINES[sq];
+    uint64_t flipped = 0;
+    for(int l = 0; l < 4; ++l){
+        const uint64_t mask = lines.masks[l];
+        const int pos = lines.positions[l];
+        const uint32_t outflank = OUTFLANK[pos][(_pext_u64(opp, mask) >> 1) & 63] & static_cast<uint32_t>(_pext_u64(me, mask));
+        flipped |= _pdep_u64(FLIPPED[pos][outflank], mask);
+    }
+    return flipped;
+}
+
+#else
+
+// not built for this CPU, kernelSupported() keeps them from being called
+uint64_t OthelloBoard::flipsAVX2(const uint64_t me, const uint64_t opp, const int sq){ return flipsScalar(me, opp, sq); }
+uint64_t OthelloBoard::flipsBMI2(const uint64_t me, const uint64_t opp, const int sq){ return flipsScalar(me, opp, sq); }
+
+#endif
+
+bool OthelloBoard::kernelSupported(const FlipKernel kernel){
+    if(kernel == FlipKernel::SCALAR) return true;
+#ifdef OTHELLO_X64
+    return cpuHas(kernel);
+#else
+    return false;
+#endif
+}
+
+const char* OthelloBoard::kernelName(const FlipKernel kernel){
+    switch(kernel){
+        case FlipKernel::AVX2: return "avx2";
+        case FlipKernel::BMI2: return "bmi2";
+        default: return "scalar";
+    }
+}
+
+bool OthelloBoard::setFlipKernel(const FlipKernel kernel){
+    if(!kernelSupported(kernel)) return false;
+    _flipKernel = kernel;
+    _flips = kernel == FlipKernel::AVX2 ? &flipsAVX2 : (kernel == FlipKernel::BMI2 ? &flipsBMI2 : &flipsScalar);
+    return true;
+}
+
+namespace{
+
+// AVX2 measured fastest (othello_flips, othello_perft --kernel), PEXT is also microcoded on older AMD cores
+const bool FLIP_KERNEL_SELECTED = []{
+    for(OthelloBoard::FlipKernel kernel : {OthelloBoard::FlipKernel::AVX2, OthelloBoard::FlipKernel::BMI2})
+        if(OthelloBoard::setFlipKernel(kernel)) return true;
+    return false;
+}();
+
+}
@@ -0,0 +1,177 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <string>
+
+// Othello position as two 64 bit masks, bit sq = y*8 + x (a1 = top left = bit 0), the same order as
+// Othello::stateString(). move generation and flips are shift-and-mask fills over the 8 directions,
+// no per square walking
+class OthelloBoard{
+
+public:
+
+    // player numbers of the Othello game
+    enum Color: bool{
+        BLACK = 0,
+        WHITE = 1
+    };
+
+    static constexpr int SQUARES = 64;
+
+    // start position: white d4/e5, black e4/d5
+    static constexpr uint64_t START_WHITE = (uint64_t(1) << (3*8 + 3)) | (uint64_t(1) << (4*8 + 4));
+    static constexpr uint64_t START_BLACK = (uint64_t(1) << (3*8 + 4)) | (uint64_t(1) << (4*8 + 3));
+
+    OthelloBoard() : _discs{START_BLACK, START_WHITE} {}
+    OthelloBoard(const uint64_t black, const uint64_t white) : _discs{black, white} {}
+
+    // '0' empty, '1' black, '2' white, 64 characters row by row. false leaves the board unchanged
+    bool            setStateString(const std::string& s);
+    std::string     stateString() const;
+
+    uint64_t        discs(const Color c) const { return _discs[c]; }
+    uint64_t        occupied() const { return _discs[BLACK] | _discs[WHITE]; }
+    uint64_t        empties() const { return ~occupied(); }
+    int             count(const Color c) const { return std::popcount(_discs[c]); }
+    int             emptyCount() const { return std::popcount(empties()); }
+
+    uint64_t        legal(const Color c) const { return legalMoves(_discs[c], _discs[!c]); }
+    bool            isLegal(const Color c, const int sq) const { return (legal(c) >> sq) & 1; }
+    // neither side can move (a full board included)
+    bool            gameOver() const { return !legal(BLACK) && !legal(WHITE); }
+
+    // places a disc of c on sq and turns the flanked discs, returns them (0 = illegal move, board unchanged)
+    uint64_t        play(const Color c, const int sq);
+
+    static constexpr uint64_t squareMask(const int sq) { return uint64_t(1) << sq; }
+
+    static constexpr uint64_t COLUMN_A = 0x0101010101010101ULL;
+    static constexpr uint64_t COLUMN_H = 0x8080808080808080ULL;
+
+    // one step along a direction, positive S towards higher squares (E = 1, S = 8, SE = 9, SW = 7)
+    // sideways and diagonal steps wrap between rows, mask the source column first
+    template <int S>
+    static constexpr uint64_t shift(const uint64_t x){
+        if constexpr (S > 0) return x << S;
+        else return x >> -S;
+    }
+
+    // squares next to any square of x in the 8 directions
+    static constexpr uint64_t neighbours(const uint64_t x){
+        const uint64_t notA = x & ~COLUMN_A, notH = x & ~COLUMN_H;
+        return shift<8>(x) | shift<-8>(x) | shift<1>(notH) | shift<-1>(notA)
+             | shift<9>(notH) | shift<-9>(notA) | shift<7>(notA) | shift<-7>(notH);
+    }
+
+    // the 8 symmetries of the square: bit 2 transposes (x <-> y), then bit 0 mirrors x and bit 1 mirrors y
+    static constexpr int SYMMETRIES = 8;
+    static constexpr int transformSquare(const int sq, const int symmetry){
+        int x = sq % 8, y = sq / 8;
+        if(symmetry & 4){ const int t = x; x = y; y = t; }
+        if(symmetry & 1) x = 7 - x;
+        if(symmetry & 2) y = 7 - y;
+        return y * 8 + x;
+    }
+    // every bit moved by transformSquare()
+    static constexpr uint64_t transform(uint64_t x, const int symmetry){
+        if(symmetry & 4){
+            // swap across the a1-h8 diagonal in three block steps
+            uint64_t t = 0x0F0F0F0F00000000ULL & (x ^ (x << 28));
+            x ^= t ^ (t >> 28);
+            t = 0x3333000033330000ULL & (x ^ (x << 14));
+            x ^= t ^ (t >> 14);
+            t = 0x5500550055005500ULL & (x ^ (x << 7));
+            x ^= t ^ (t >> 7);
+        }
+        if(symmetry & 1){
+            // reverse the bits of every row
+            x = ((x >> 1) & 0x5555555555555555ULL) | ((x & 0x5555555555555555ULL) << 1);
+            x = ((x >> 2) & 0x3333333333333333ULL) | ((x & 0x3333333333333333ULL) << 2);
+            x = ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((x & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        }
+        if(symmetry & 2){
+            // reverse the order of the rows
+            x = ((x >> 8) & 0x00FF00FF00FF00FFULL) | ((x & 0x00FF00FF00FF00FFULL) << 8);
+            x = ((x >> 16) & 0x0000FFFF0000FFFFULL) | ((x & 0x0000FFFF0000FFFFULL) << 16);
+            x = (x >> 32) | (x << 32);
+        }
+        return x;
+    }
+
+    // empty squares where me flanks at least one disc of opp
+    static uint64_t legalMoves(const uint64_t me, const uint64_t opp);
+    // discs of opp turned by me playing on the empty square sq, 0 if the move is illegal. runs the fastest
+    // kernel the CPU supports, picked once at startup
+    static uint64_t flips(const uint64_t me, const uint64_t opp, const int sq) { return _flips(me, opp, sq); }
+
+    // flip kernels, all give the same result: the portable shift fills, AVX2 running the 8 directions as
+    // 2 x 4 lanes, and BMI2 gathering the 4 lines through the square with PEXT into outflank table lookups
+    enum class FlipKernel: uint8_t{ SCALAR, AVX2, BMI2 };
+    static uint64_t flipsScalar(const uint64_t me, const uint64_t opp, const int sq);
+    // only callable when kernelSupported() says so
+    static uint64_t flipsAVX2(const uint64_t me, const uint64_t opp, const int sq);
+    static uint64_t flipsBMI2(const uint64_t me, const uint64_t opp, const int sq);
+
+    // compiled in and the CPU has the instructions (CPUID)
+    static bool     kernelSupported(const FlipKernel kernel);
+    static const char* kernelName(const FlipKernel kernel);
+    static FlipKernel flipKernel() { return _flipKernel; }
+    // false and no change when the kernel is not supported, for benchmarks and tests
+    static bool     setFlipKernel(const FlipKernel kernel);
+
+private:
+
+    // columns b-g: a run going sideways or diagonally must not wrap from h into the next row's a
+    static constexpr uint64_t INNER_COLUMNS = ~(COLUMN_A | COLUMN_H);
+
+    // Kogge-Stone occluded fill: gen plus every square reached from it through an unbroken run of pro
+    template <int S>
+    static constexpr uint64_t fill(uint64_t gen, uint64_t pro){
+        gen |= pro & shift<S>(gen);
+        pro &= shift<S>(pro);
+        gen |= pro & shift<2*S>(gen);
+        pro &= shift<2*S>(pro);
+        gen |= pro & shift<4*S>(gen);
+        return gen;
+    }
+
+    template <int S>
+    static constexpr uint64_t movesAlong(const uint64_t me, const uint64_t pro){
+        // the opponent discs in line behind one of mine, a move goes one past them
+        return shift<S>(fill<S>(me, pro) & ~me);
+    }
+
+    template <int S>
+    static constexpr uint64_t flipsAlong(const uint64_t me, const uint64_t pro, const uint64_t move){
+        const uint64_t run = fill<S>(move, pro);
+        return (shift<S>(run) & me) ? run & ~move : 0;
+    }
+
+    std::array<uint64_t, 2> _discs;
+
+    using FlipFunction = uint64_t (*)(uint64_t, uint64_t, int);
+    // scalar until OthelloBoard.cpp's startup selection runs, so flips() is safe from any static initializer
+    static inline FlipFunction _flips = &flipsScalar;
+    static inline FlipKernel _flipKernel = FlipKernel::SCALAR;
+};
+
+
+
+inline uint64_t OthelloBoard::legalMoves(const uint64_t me, const uint64_t opp){
+    const uint64_t inner = opp & INNER_COLUMNS;
+    const uint64_t moves = movesAlong<1>(me, inner) | movesAlong<-1>(me, inner)
+                         | movesAlong<8>(me, opp) | movesAlong<-8>(me, opp)
+                         | movesAlong<9>(me, inner) | movesAlong<-9>(me, inner)
+                         | movesAlong<7>(me, inner) | movesAlong<-7>(me, inner);
+    return moves & ~(me | opp);
+}
+
+inline uint64_t OthelloBoard::flipsScalar(const uint64_t me, const uint64_t opp, const int sq){
+    const uint64_t move = squareMask(sq);
+    const uint64_t inner = opp & INNER_COLUMNS;
+    return flipsAlong<1>(me, inner, move) | flipsAlong<-1>(me, inner, move)
+         | flipsAlong<8>(me, opp, move) | flipsAlong<-8>(me, opp, move)
+         | flipsAlong<9>(me, inner, move) | flipsAlong<-9>(me, inner, move)
+         | flipsAlong<7>(me, inner, move) | flipsAlong<-7>(me, inner, move);
+}
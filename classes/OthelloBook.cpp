@@ -0,0 +1,209 @@
+#include "OthelloBook.h"
+#include "OthelloBoard.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(OthelloBook::Entry) == 24, "book entries are written as they are laid out in memory");
+
+// read only view of the whole file, the entries start HEADER_BYTES in (8 byte aligned, the view is page aligned)
+struct OthelloBook::Mapping{
+    const unsigned char* data = nullptr;
+    size_t bytes = 0;
+
+    const Entry* entries() const { return reinterpret_cast<const Entry*>(data + HEADER_BYTES); }
+    size_t count() const { return (bytes - HEADER_BYTES) / sizeof(Entry); }
+
+    // nullptr with the reason in error when the file can't be opened or mapped
+    static std::shared_ptr<Mapping> open(const std::string& path, std::string& error);
+    ~Mapping();
+};
+
+#ifdef _WIN32
+
+std::shared_ptr<OthelloBook::Mapping> OthelloBook::Mapping::open(const std::string& path, std::string& error){
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE){
+        error = "could not open " + path;
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(file, &size) || size.QuadPart < static_cast<LONGLONG>(HEADER_BYTES)){
+        CloseHandle(file);
+        error = "truncated book " + path;
+        return nullptr;
+    }
+
+    // the view keeps the file mapped after both handles are closed
+    HANDLE section = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void* view = section ? MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if(section) CloseHandle(section);
+    CloseHandle(file);
+    if(!view){
+        error = "could not map " + path;
+        return nullptr;
+    }
+
+    auto mapping = std::make_shared<Mapping>();
+    mapping->data = static_cast<const unsigned char*>(view);
+    mapping->bytes = static_cast<size_t>(size.QuadPart);
+    return mapping;
+}
+
+OthelloBook::Mapping::~Mapping(){
+    if(data) UnmapViewOfFile(data);
+}
+
+#else
+
+std::shared_ptr<OthelloBook::Mapping> OthelloBook::Mapping::open(const std::string& path, std::string& error){
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        error = "could not open " + path;
+        return nullptr;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(HEADER_BYTES)){
+        ::close(fd);
+        error = "truncated book " + path;
+        return nullptr;
+    }
+
+    // the mapping outlives the descriptor
+    void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(view == MAP_FAILED){
+        error = "could not map " + path;
+        return nullptr;
+    }
+
+    auto mapping = std::make_shared<Mapping>();
+    mapping->data = static_cast<const unsigned char*>(view);
+    mapping->bytes = static_cast<size_t>(st.st_size);
+    return mapping;
+}
+
+OthelloBook::Mapping::~Mapping(){
+    if(data) munmap(const_cast<unsigned char*>(data), bytes);
+}
+
+#endif
+
+
+
+void OthelloBook::canonical(uint64_t& me, uint64_t& opp){
+    uint64_t bestMe = me, bestOpp = opp;
+    for(int s = 1; s < OthelloBoard::SYMMETRIES; ++s){
+        const uint64_t m = OthelloBoard::transform(me, s), o = OthelloBoard::transform(opp, s);
+        if(m < bestMe || (m == bestMe && o < bestOpp)){
+            bestMe = m;
+            bestOpp = o;
+        }
+    }
+    me = bestMe;
+    opp = bestOpp;
+}
+
+bool OthelloBook::save(const std::string& path, std::vector<Entry> entries, std::string* error){
+    for(Entry& e : entries) canonical(e.me, e.opp);
+    std::sort(entries.begin(), entries.end(), entryLess);
+    const auto duplicate = std::adjacent_find(entries.begin(), entries.end(),
+        [](const Entry& a, const Entry& b){ return a.me == b.me && a.opp == b.opp; });
+    if(duplicate != entries.end()){
+        if(error) *error = "position " + OthelloBoard(duplicate->me, duplicate->opp).stateString() + " is in the book twice";
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    const uint32_t reserved = 0;
+    const uint32_t count = static_cast<uint32_t>(entries.size());
+    file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    file.write(reinterpret_cast<const char*>(&FILE_VERSION), sizeof(FILE_VERSION));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+    file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+
+    if(!file){
+        if(error) *error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool OthelloBook::load(const std::string& path, std::string* error){
+    _mapping.reset();
+    auto fail = [&](const std::string& msg){
+        if(error) *error = msg;
+        return false;
+    };
+
+    std::string reason;
+    std::shared_ptr<Mapping> mapping = Mapping::open(path, reason);
+    if(!mapping) return fail(reason);
+
+    uint32_t version, count;
+    std::memcpy(&version, mapping->data + 4, sizeof(version));
+    std::memcpy(&count, mapping->data + 8, sizeof(count));
+    if(std::memcmp(mapping->data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) return fail("bad magic in " + path);
+    if(version != FILE_VERSION) return fail("unsupported version in " + path);
+    if(mapping->bytes != HEADER_BYTES + static_cast<size_t>(count) * sizeof(Entry))
+        return fail("size of " + path + " does not match its entry count");
+
+    // binary search needs strictly increasing keys, one pass over a few MB at load
+    const Entry* entries = mapping->entries();
+    for(size_t i = 1; i < count; ++i)
+        if(!entryLess(entries[i - 1], entries[i])) return fail("entries of " + path + " are not sorted");
+
+    _mapping = std::move(mapping);
+    return true;
+}
+
+size_t OthelloBook::size() const{
+    return _mapping ? _mapping->count() : 0;
+}
+
+const OthelloBook::Entry* OthelloBook::find(uint64_t me, uint64_t opp) const{
+    if(!_mapping) return nullptr;
+    canonical(me, opp);
+
+    const Entry* begin = _mapping->entries();
+    const Entry* end = begin + _mapping->count();
+    const Entry key{me, opp, 0, 0};
+    const Entry* it = std::lower_bound(begin, end, key, entryLess);
+    return it != end && it->me == me && it->opp == opp ? it : nullptr;
+}
+
+int OthelloBook::bestMove(const uint64_t me, const uint64_t opp, int* score, int* depth) const{
+    int best = -1, bestScore = 0, bestDepth = 0;
+    for(uint64_t moves = OthelloBoard::legalMoves(me, opp); moves; moves &= moves - 1){
+        const int sq = std::countr_zero(moves);
+        const uint64_t flipped = OthelloBoard::flips(me, opp, sq);
+        const Entry* child = find(opp & ~flipped, me | flipped | OthelloBoard::squareMask(sq));
+        if(!child || (best >= 0 && -child->score <= bestScore)) continue;
+        best = sq;
+        bestScore = -child->score;
+        bestDepth = child->depth;
+    }
+
+    if(best >= 0){
+        if(score) *score = bestScore;
+        if(depth) *depth = bestDepth;
+    }
+    return best;
+}
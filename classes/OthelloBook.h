@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Othello opening book written by othello_book: every position of the opening tree in its canonical form (the
+// smallest of its 8 symmetric images) with the minimaxed search score for the side to move. the file is an array
+// of entries sorted by (me, opp), memory mapped read only and probed by binary search, nothing is parsed at load
+class OthelloBook{
+
+public:
+
+    struct Entry{
+        uint64_t me;
+        uint64_t opp;
+        int32_t score;      // OthelloEngine scores for the side to move
+        int32_t depth;      // plies the score looks ahead: leaf search depth plus the plies down to the leaf
+    };
+
+    // flat little endian file: magic, version, entry count, then the entries in (me, opp) order
+    static constexpr char     FILE_MAGIC[4] = {'O', 'T', 'B', 'K'};
+    static constexpr uint32_t FILE_VERSION = 1;
+    static constexpr size_t   HEADER_BYTES = 16;
+
+    // the image of (me, opp) under the symmetry that gives the smallest (me, opp) pair
+    static void     canonical(uint64_t& me, uint64_t& opp);
+    static bool     entryLess(const Entry& a, const Entry& b) { return a.me != b.me ? a.me < b.me : a.opp < b.opp; }
+
+    // entries are canonicalised and sorted here
+    static bool     save(const std::string& path, std::vector<Entry> entries, std::string* error = nullptr);
+    // false keeps the book empty
+    bool            load(const std::string& path, std::string* error = nullptr);
+    bool            loaded() const { return _mapping != nullptr; }
+    size_t          size() const;
+
+    // the entry of (me, opp) or any of its symmetric images, nullptr when the position is not in the book
+    const Entry*    find(uint64_t me, uint64_t opp) const;
+    // the legal move of me whose resulting position scores best in the book, -1 when none of them is in it.
+    // score and depth are those of the position after the move, from me's side
+    int             bestMove(const uint64_t me, const uint64_t opp, int* score = nullptr, int* depth = nullptr) const;
+
+private:
+
+    struct Mapping;
+
+    // shared between engine copies, unmapped with the last one
+    std::shared_ptr<const Mapping> _mapping;
+};
@@ -0,0 +1,464 @@
+#include "OthelloEndgame.h"
+#include "OthelloEngine.h"
+#include <algorithm>
+#include <bit>
+
+namespace{
+
+// 4x4 quadrants: a move into a quadrant with an odd number of empties usually gets the last move there
+constexpr std::array<uint64_t, 4> QUADRANTS = {
+    0x000000000F0F0F0FULL, 0x00000000F0F0F0F0ULL, 0x0F0F0F0F00000000ULL, 0xF0F0F0F000000000ULL
+};
+
+uint64_t oddRegions(const uint64_t empty){
+    uint64_t odd = 0;
+    for(uint64_t q : QUADRANTS)
+        if(std::popcount(empty & q) & 1) odd |= q;
+    return odd;
+}
+
+// squares around each square, a move needs an opponent disc among them
+constexpr std::array<uint64_t, 64> NEIGHBOURS = []{
+    std::array<uint64_t, 64> masks{};
+    for(int sq = 0; sq < 64; ++sq) masks[sq] = OthelloBoard::neighbours(OthelloBoard::squareMask(sq));
+    return masks;
+}();
+
+// from here on searchLast<N>() loops over the empty squares
+constexpr int LAST_EMPTIES = 4;
+// below this ordering by reply count costs more than it saves, parity and square class only
+constexpr int FASTEST_FIRST_EMPTIES = 7;
+// subtrees this deep are worth a table probe and a stability test
+constexpr int TABLE_MIN_EMPTIES = 6;
+constexpr int STABILITY_MIN_EMPTIES = 10;
+
+constexpr int REPLY_WEIGHT = 16;
+constexpr int PARITY_WEIGHT = 8;
+constexpr int CORNER_WEIGHT = 4;
+
+}
+
+
+
+struct OthelloEndgame::Parallel{
+    ThreadPool* pool;
+    int splitEmpties;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<OthelloEndgame>> helpers;   // every helper made so far
+    std::vector<OthelloEndgame*> idle;
+};
+
+OthelloEndgame::OthelloEndgame(const size_t tableEntries){
+    size_t size = 1;
+    while(size < tableEntries) size <<= 1;
+    _table = std::vector<TableSlot>(size);
+    _slots = _table.data();
+    _tableMask = size - 1;
+
+    _stop = nullptr;
+    _hasDeadline = false;
+    _nodeLimit = 0;
+    _aborted = false;
+    _nodes = 0;
+    _parallel = nullptr;
+    _split = nullptr;
+}
+
+OthelloEndgame::~OthelloEndgame() = default;
+
+void OthelloEndgame::clearTable(){
+    for(TableSlot& slot : _table){
+        slot.me.store(0, std::memory_order_relaxed);
+        slot.opp.store(0, std::memory_order_relaxed);
+        slot.data.store(0, std::memory_order_relaxed);
+    }
+}
+
+void OthelloEndgame::setThreadPool(ThreadPool* pool, const int splitEmpties){
+    _ownParallel.reset();
+    _parallel = nullptr;
+    if(!pool) return;
+
+    _ownParallel = std::make_unique<Parallel>();
+    _ownParallel->pool = pool;
+    _ownParallel->splitEmpties = std::max(splitEmpties, TABLE_MIN_EMPTIES);
+    _parallel = _ownParallel.get();
+}
+
+OthelloEndgame::TableSlot* OthelloEndgame::tableBucket(const uint64_t me, const uint64_t opp) const{
+    uint64_t h = me * 0x9E3779B97F4A7C15ULL ^ (opp + 0x632BE59BD9B4E019ULL) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 29;
+    return &_slots[h & _tableMask & ~size_t(1)];
+}
+
+bool OthelloEndgame::probe(const uint64_t me, const uint64_t opp, TableEntry& entry) const{
+    const TableSlot* bucket = tableBucket(me, opp);
+    for(int i = 0; i < 2; ++i){
+        const uint64_t data = bucket[i].data.load(std::memory_order_relaxed);
+        if((bucket[i].me.load(std::memory_order_relaxed) ^ data) != me || (bucket[i].opp.load(std::memory_order_relaxed) ^ data) != opp)
+            continue;
+        entry = {me, opp, static_cast<int8_t>(data), static_cast<int8_t>(data >> 8), static_cast<int8_t>(data >> 16),
+                 static_cast<int8_t>(data >> 24)};
+        return true;
+    }
+    return false;
+}
+
+void OthelloEndgame::store(const TableEntry& entry){
+    const uint64_t data = uint64_t(uint8_t(entry.lower)) | uint64_t(uint8_t(entry.upper)) << 8
+                        | uint64_t(uint8_t(entry.move)) << 16 | uint64_t(uint8_t(entry.empties)) << 24;
+    auto holds = [&](const TableSlot& slot){
+        const uint64_t d = slot.data.load(std::memory_order_relaxed);
+        return (slot.me.load(std::memory_order_relaxed) ^ d) == entry.me && (slot.opp.load(std::memory_order_relaxed) ^ d) == entry.opp;
+    };
+    auto write = [](TableSlot& slot, const uint64_t me, const uint64_t opp, const uint64_t d){
+        slot.data.store(d, std::memory_order_relaxed);
+        slot.me.store(me ^ d, std::memory_order_relaxed);
+        slot.opp.store(opp ^ d, std::memory_order_relaxed);
+    };
+
+    TableSlot* bucket = tableBucket(entry.me, entry.opp);
+    if(holds(bucket[0])) write(bucket[0], entry.me, entry.opp, data);
+    else if(holds(bucket[1])) write(bucket[1], entry.me, entry.opp, data);
+    else if(entry.empties >= static_cast<int8_t>(bucket[0].data.load(std::memory_order_relaxed) >> 24)){
+        // the words move down as they are, still xored with their data
+        bucket[1].data.store(bucket[0].data.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        bucket[1].me.store(bucket[0].me.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        bucket[1].opp.store(bucket[0].opp.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        write(bucket[0], entry.me, entry.opp, data);
+    }
+    else write(bucket[1], entry.me, entry.opp, data);
+}
+
+void OthelloEndgame::pollLimits(){
+    if(_stop && _stop->load(std::memory_order_relaxed)) _aborted = true;
+    if(_hasDeadline && std::chrono::steady_clock::now() >= _deadline) _aborted = true;
+    if(_nodeLimit && _nodes >= _nodeLimit) _aborted = true;
+    for(const SplitPoint* sp = _split; sp; sp = sp->parent)
+        if(sp->abort.load(std::memory_order_relaxed)) _aborted = true;
+}
+
+
+int OthelloEndgame::searchLast1(const uint64_t me, const uint64_t opp, const int sq){
+    ++_nodes;
+
+    // whoever can play fills the board, 64 discs: the differential is 2*mine - 64
+    uint64_t flipped = (NEIGHBOURS[sq] & opp) ? OthelloBoard::flips(me, opp, sq) : 0;
+    if(flipped) return 2 * (std::popcount(me | flipped) + 1) - 64;
+
+    flipped = OthelloBoard::flips(opp, me, sq);
+    if(flipped) return 2 * std::popcount(me & ~flipped) - 64;
+
+    return OthelloEngine::finalDiscDiff(me, opp);
+}
+
+template <int N>
+int OthelloEndgame::searchLast(const uint64_t me, const uint64_t opp, int alpha, const int beta, const int* squares, const bool passed){
+    ++_nodes;
+
+    int best = -MAX_SCORE - 1;
+    for(int i = 0; i < N; ++i){
+        const int sq = squares[i];
+        if(!(NEIGHBOURS[sq] & opp)) continue;
+        const uint64_t flipped = OthelloBoard::flips(me, opp, sq);
+        if(!flipped) continue;
+
+        int rest[N - 1];
+        for(int j = 0, k = 0; j < N; ++j)
+            if(j != i) rest[k++] = squares[j];
+
+        const uint64_t childMe = opp & ~flipped, childOpp = me | flipped | OthelloBoard::squareMask(sq);
+        int score;
+        if constexpr (N == 2) score = -searchLast1(childMe, childOpp, rest[0]);
+        else score = -searchLast<N - 1>(childMe, childOpp, -beta, -alpha, rest, false);
+
+        if(score > best){
+            best = score;
+            if(best > alpha){
+                alpha = best;
+                if(alpha >= beta) return best;
+            }
+        }
+    }
+    if(best > -MAX_SCORE - 1) return best;
+
+    if(passed) return OthelloEngine::finalDiscDiff(me, opp);
+    return -searchLast<N>(opp, me, -beta, -alpha, squares, true);
+}
+
+
+void OthelloEndgame::orderMoves(const uint64_t me, const uint64_t opp, uint64_t moves, const int ttMove, MoveList& list) const{
+    const uint64_t empty = ~(me | opp);
+    const uint64_t odd = oddRegions(empty);
+    const bool fastestFirst = std::popcount(empty) >= FASTEST_FIRST_EMPTIES;
+
+    std::array<int, OthelloBoard::SQUARES> keys;
+    list.count = 0;
+    for(; moves; moves &= moves - 1){
+        const int sq = std::countr_zero(moves);
+        const uint64_t bit = OthelloBoard::squareMask(sq);
+
+        int key = ((odd & bit) ? PARITY_WEIGHT : 0) + ((OthelloEngine::CORNERS & bit) ? CORNER_WEIGHT : 0);
+        if(sq == ttMove){
+            key = 1 << 20;
+        }else if(fastestFirst){
+            // fewest replies first, a reply on a corner counts twice
+            const uint64_t flipped = OthelloBoard::flips(me, opp, sq);
+            const uint64_t replies = OthelloBoard::legalMoves(opp & ~flipped, me | flipped | bit);
+            key -= REPLY_WEIGHT * (std::popcount(replies) + std::popcount(replies & OthelloEngine::CORNERS));
+        }
+
+        int i = list.count++;
+        for(; i > 0 && keys[i - 1] < key; --i){
+            keys[i] = keys[i - 1];
+            list.squares[i] = list.squares[i - 1];
+        }
+        keys[i] = key;
+        list.squares[i] = static_cast<int8_t>(sq);
+    }
+}
+
+int OthelloEndgame::search(const uint64_t me, const uint64_t opp, int alpha, int beta, const bool passed){
+    const uint64_t empty = ~(me | opp);
+    const int empties = std::popcount(empty);
+
+    if(empties <= LAST_EMPTIES){
+        // squares in odd quadrants first
+        const uint64_t odd = oddRegions(empty);
+        int squares[LAST_EMPTIES];
+        int n = 0;
+        for(uint64_t e = empty & odd; e; e &= e - 1) squares[n++] = std::countr_zero(e);
+        for(uint64_t e = empty & ~odd; e; e &= e - 1) squares[n++] = std::countr_zero(e);
+
+        switch(empties){
+            case 4: return searchLast<4>(me, opp, alpha, beta, squares, passed);
+            case 3: return searchLast<3>(me, opp, alpha, beta, squares, passed);
+            case 2: return searchLast<2>(me, opp, alpha, beta, squares, passed);
+            case 1: return searchLast1(me, opp, squares[0]);
+            default: return OthelloEngine::finalDiscDiff(me, opp);
+        }
+    }
+
+    if((++_nodes % LIMIT_POLL_NODES) == 0) pollLimits();
+    if(_aborted) return 0;
+
+    const uint64_t moves = OthelloBoard::legalMoves(me, opp);
+    if(!moves){
+        if(passed) return OthelloEngine::finalDiscDiff(me, opp);
+        return -search(opp, me, -beta, -alpha, true);
+    }
+
+    // stable discs keep their colour, that bounds the result on both sides
+    if(empties >= STABILITY_MIN_EMPTIES){
+        const int upper = MAX_SCORE - 2 * std::popcount(OthelloEngine::stableDiscs(opp, me));
+        if(upper <= alpha) return upper;
+        const int lower = 2 * std::popcount(OthelloEngine::stableDiscs(me, opp)) - MAX_SCORE;
+        if(lower >= beta) return lower;
+        beta = std::min(beta, upper);
+        alpha = std::max(alpha, lower);
+    }
+
+    TableEntry entry{me, opp};
+    entry.empties = static_cast<int8_t>(empties);
+    const bool useTable = empties >= TABLE_MIN_EMPTIES;
+    if(useTable){
+        TableEntry hit;
+        if(probe(me, opp, hit)){
+            if(hit.lower >= beta) return hit.lower;
+            if(hit.upper <= alpha) return hit.upper;
+            if(hit.lower == hit.upper) return hit.lower;
+            entry = hit;
+            alpha = std::max(alpha, static_cast<int>(entry.lower));
+            beta = std::min(beta, static_cast<int>(entry.upper));
+        }
+    }
+    const int ttMove = entry.move;
+
+    MoveList list;
+    orderMoves(me, opp, moves, ttMove, list);
+
+    const int alphaOrig = alpha;
+    int best = -MAX_SCORE - 1;
+    int bestMove = list.squares[0];
+    for(int k = 0; k < list.count; ++k){
+        const int sq = list.squares[k];
+        const uint64_t flipped = OthelloBoard::flips(me, opp, sq);
+        const uint64_t childMe = opp & ~flipped, childOpp = me | flipped | OthelloBoard::squareMask(sq);
+
+        // principal variation search: the first move gets the full window, the rest only have to prove they are worse
+        int score;
+        if(k == 0){
+            score = -search(childMe, childOpp, -beta, -alpha);
+        }else{
+            score = -search(childMe, childOpp, -alpha - 1, -alpha);
+            if(score > alpha && score < beta) score = -search(childMe, childOpp, -beta, -score);
+        }
+        if(_aborted) return 0;
+
+        if(score > best){
+            best = score;
+            bestMove = sq;
+            if(best > alpha){
+                alpha = best;
+                if(alpha >= beta) break;
+            }
+        }
+
+        // young brothers wait: the eldest set the bound without a cutoff, the others are searched in parallel
+        if(k == 0 && _parallel && empties >= _parallel->splitEmpties && list.count > 1){
+            splitSiblings(me, opp, list, alpha, beta, best, bestMove);
+            if(_aborted) return 0;
+            break;
+        }
+    }
+
+    if(useTable){
+        if(best > alphaOrig) entry.lower = static_cast<int8_t>(best);
+        if(best < beta) entry.upper = static_cast<int8_t>(best);
+        entry.move = static_cast<int8_t>(bestMove);
+        store(entry);
+    }
+    return best;
+}
+
+
+OthelloEndgame::Result OthelloEndgame::solve(const OthelloBoard& board, const Color me){
+    _nodes = 0;
+    _aborted = false;
+
+    const uint64_t mine = board.discs(me);
+    const uint64_t theirs = board.discs(static_cast<Color>(!me));
+    const uint64_t moves = OthelloBoard::legalMoves(mine, theirs);
+
+    Result result{-1, 0, 0};
+    if(!moves){
+        result.score = search(mine, theirs, -MAX_SCORE - 1, MAX_SCORE + 1);
+        result.nodes = _nodes;
+        return result;
+    }
+
+    MoveList list;
+    orderMoves(mine, theirs, moves, -1, list);
+
+    int alpha = -MAX_SCORE - 1;
+    for(int k = 0; k < list.count; ++k){
+        const int sq = list.squares[k];
+        const uint64_t flipped = OthelloBoard::flips(mine, theirs, sq);
+        const uint64_t childMe = theirs & ~flipped, childOpp = mine | flipped | OthelloBoard::squareMask(sq);
+
+        int score;
+        if(k == 0){
+            score = -search(childMe, childOpp, -MAX_SCORE - 1, MAX_SCORE + 1);
+        }else{
+            score = -search(childMe, childOpp, -alpha - 1, -alpha);
+            if(score > alpha) score = -search(childMe, childOpp, -MAX_SCORE - 1, -score);
+        }
+        if(_aborted) break;
+
+        if(score > alpha){
+            alpha = score;
+            result.bestMove = sq;
+        }
+
+        if(k == 0 && _parallel && board.emptyCount() >= _parallel->splitEmpties && list.count > 1){
+            int best = alpha;
+            splitSiblings(mine, theirs, list, alpha, MAX_SCORE + 1, best, result.bestMove);
+            break;
+        }
+    }
+
+    result.score = alpha;
+    result.nodes = _nodes;
+    return result;
+}
+
+
+OthelloEndgame* OthelloEndgame::acquireHelper(){
+    std::lock_guard<std::mutex> lock(_parallel->mutex);
+    if(_parallel->idle.empty()){
+        // one per task running at the same time, a waiting thread that runs another split's task needs a second.
+        // small, the table is this solver's
+        auto helper = std::make_unique<OthelloEndgame>(0);
+        helper->_parallel = _parallel;
+        helper->_slots = _slots;
+        helper->_tableMask = _tableMask;
+        _parallel->idle.push_back(helper.get());
+        _parallel->helpers.push_back(std::move(helper));
+    }
+
+    OthelloEndgame* helper = _parallel->idle.back();
+    _parallel->idle.pop_back();
+    return helper;
+}
+
+void OthelloEndgame::releaseHelper(OthelloEndgame* helper){
+    std::lock_guard<std::mutex> lock(_parallel->mutex);
+    _parallel->idle.push_back(helper);
+}
+
+void OthelloEndgame::splitSiblings(const uint64_t me, const uint64_t opp, const MoveList& list, int& alpha, const int beta,
+                                   int& best, int& bestMove){
+    SplitPoint sp;
+    sp.parent = _split;
+    sp.alpha = alpha;
+    sp.best = best;
+    sp.bestMove = bestMove;
+
+    // no new siblings are handed out once sp.abort is set
+    _parallel->pool->parallelFor(static_cast<size_t>(list.count - 1), [&](const size_t i){
+        const int sq = list.squares[i + 1];
+        const uint64_t flipped = OthelloBoard::flips(me, opp, sq);
+        const uint64_t childMe = opp & ~flipped, childOpp = me | flipped | OthelloBoard::squareMask(sq);
+
+        // the helper stops with this solver and with every split point above it, the node limit is left to this solver
+        OthelloEndgame* helper = acquireHelper();
+        helper->_stop = _stop;
+        helper->_deadline = _deadline;
+        helper->_hasDeadline = _hasDeadline;
+        helper->_nodeLimit = 0;
+        helper->_aborted = false;
+        helper->_nodes = 0;
+        helper->_split = &sp;
+
+        auto currentAlpha = [&]{
+            std::lock_guard<std::mutex> lock(sp.mutex);
+            return sp.alpha;
+        };
+        // null window against the best score so far, the full window only for a move that beats it. a brother
+        // may have raised the bound meanwhile, the re-search starts from the higher one
+        const int a = currentAlpha();
+        int score = -helper->search(childMe, childOpp, -a - 1, -a);
+        if(!helper->_aborted && score > a && score < beta){
+            const int bound = std::max(score, currentAlpha());
+            if(bound < beta) score = -helper->search(childMe, childOpp, -beta, -bound);
+        }
+
+        const bool aborted = helper->_aborted;
+        sp.nodes += helper->_nodes;
+        releaseHelper(helper);
+
+        if(aborted){
+            // stopped by a cutoff here is expected, anything else (a cutoff further up, the stop flag, the
+            // deadline) leaves this node without a result
+            if(!sp.abort.exchange(true)) sp.failed = true;
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(sp.mutex);
+        if(score > sp.best){
+            sp.best = score;
+            sp.bestMove = sq;
+            if(score > sp.alpha){
+                sp.alpha = score;
+                if(score >= beta) sp.abort = true;
+            }
+        }
+    }, &sp.abort);
+
+    _nodes += sp.nodes;
+    if(sp.failed) _aborted = true;
+    alpha = sp.alpha;
+    best = sp.best;
+    bestMove = sp.bestMove;
+}
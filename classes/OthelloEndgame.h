@@ -0,0 +1,133 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "OthelloBoard.h"
+#include "ThreadPool.h"
+
+// exact Othello endgame solver, scores are final disc differentials for the side to move (empty squares go to
+// the winner). principal variation search with null windows, fastest-first ordering (fewest opponent replies)
+// weighted by quadrant parity, a stability cutoff, a transposition table for the larger subtrees and dedicated
+// routines for the last 4 empty squares that loop over the empties instead of generating moves.
+// with a thread pool set the search is young brothers wait (YBWC): a node with enough empties searches its first
+// move alone, then hands the other moves to the pool, where helper solvers sharing its table search them
+class OthelloEndgame{
+
+public:
+
+    using Color = OthelloBoard::Color;
+
+    struct Result{
+        int bestMove;       // square, -1 when the side to move has to pass or the game is over
+        int score;          // exact disc differential for the side to move
+        uint64_t nodes;
+    };
+
+    static constexpr int MAX_SCORE = 64;
+    static constexpr uint64_t LIMIT_POLL_NODES = 4096;
+    static constexpr size_t DEFAULT_TABLE_ENTRIES = size_t(1) << 20;
+    // smaller subtrees finish faster than handing them out costs
+    static constexpr int DEFAULT_SPLIT_EMPTIES = 14;
+
+    explicit OthelloEndgame(const size_t tableEntries = DEFAULT_TABLE_ENTRIES);
+    ~OthelloEndgame();
+
+    OthelloEndgame(const OthelloEndgame&) = delete;
+    OthelloEndgame& operator=(const OthelloEndgame&) = delete;
+
+    // same contract as the midgame engine: once *stop is set, the deadline passes or the node limit is hit
+    // the search unwinds, stopped() is true and the result is garbage
+    void            setStopFlag(const std::atomic<bool>* stop) { _stop = stop; }
+    void            setDeadline(const std::chrono::steady_clock::time_point deadline) { _deadline = deadline; _hasDeadline = true; }
+    void            clearDeadline() { _hasDeadline = false; }
+    void            setNodeLimit(const uint64_t nodes) { _nodeLimit = nodes; }
+    bool            stopped() const { return _aborted; }
+    uint64_t        nodes() const { return _nodes; }
+    void            clearTable();
+
+    // splits nodes with at least splitEmpties empty squares over the pool, nullptr searches serially again.
+    // the score is the same either way, with equal scores the best move can differ. with a pool the node limit
+    // counts the helpers' nodes once their split is done
+    void            setThreadPool(ThreadPool* pool, const int splitEmpties = DEFAULT_SPLIT_EMPTIES);
+
+    // exact score and a best move for me
+    Result          solve(const OthelloBoard& board, const Color me);
+    // exact score inside (alpha, beta), fail-soft bounds outside it
+    int             search(const uint64_t me, const uint64_t opp, int alpha, int beta, const bool passed = false);
+
+private:
+
+    struct TableEntry{
+        uint64_t me = 0;
+        uint64_t opp = 0;
+        int8_t lower = -MAX_SCORE;
+        int8_t upper = MAX_SCORE;
+        int8_t move = -1;
+        int8_t empties = -1;
+    };
+
+    // a TableEntry as three words with the key words stored xor the data word: the table is shared by the helper
+    // solvers without locks, a slot torn by two writers fails the key check and reads as a miss
+    struct TableSlot{
+        std::atomic<uint64_t> me{0};
+        std::atomic<uint64_t> opp{0};
+        std::atomic<uint64_t> data{0};
+    };
+
+    struct MoveList{
+        std::array<int8_t, OthelloBoard::SQUARES> squares;
+        int count = 0;
+    };
+
+    // the younger brothers of one node being searched in parallel. a beta cutoff sets abort, which every solver
+    // working below this split point sees at its next poll through the parent chain
+    struct SplitPoint{
+        const SplitPoint* parent;
+        std::atomic<bool> abort{false};
+        std::atomic<bool> failed{false};    // a helper stopped for another reason, the result is garbage
+        std::atomic<uint64_t> nodes{0};
+        std::mutex mutex;
+        int alpha;                          // guarded by mutex, like best and bestMove
+        int best;
+        int bestMove;
+    };
+
+    // pool, split depth and helper solvers, shared by the solver that set the pool and all its helpers
+    struct Parallel;
+
+    // the last N empty squares, passed as a small array instead of a move mask
+    template <int N>
+    int             searchLast(const uint64_t me, const uint64_t opp, int alpha, const int beta, const int* squares, const bool passed);
+    int             searchLast1(const uint64_t me, const uint64_t opp, const int sq);
+    void            orderMoves(const uint64_t me, const uint64_t opp, uint64_t moves, const int ttMove, MoveList& list) const;
+    // buckets of two: the first entry keeps the biggest subtree, the second takes whatever comes
+    TableSlot*      tableBucket(const uint64_t me, const uint64_t opp) const;
+    bool            probe(const uint64_t me, const uint64_t opp, TableEntry& entry) const;
+    void            store(const TableEntry& entry);
+    void            pollLimits();
+
+    // searches list.squares[1..] on the pool, alpha, best and bestMove come from the eldest brother and are updated
+    void            splitSiblings(const uint64_t me, const uint64_t opp, const MoveList& list, int& alpha, const int beta,
+                                  int& best, int& bestMove);
+    OthelloEndgame* acquireHelper();
+    void            releaseHelper(OthelloEndgame* helper);
+
+    std::vector<TableSlot> _table;
+    TableSlot* _slots;              // _table, for a helper the table of the solver it helps
+    size_t _tableMask;
+
+    const std::atomic<bool>* _stop;
+    std::chrono::steady_clock::time_point _deadline;
+    bool _hasDeadline;
+    uint64_t _nodeLimit;
+    bool _aborted;
+    uint64_t _nodes;
+
+    std::unique_ptr<Parallel> _ownParallel;     // set on the solver setThreadPool() was called on
+    Parallel* _parallel;                        // that one's, for it and its helpers
+    const SplitPoint* _split;                   // innermost split point this solver is searching under
+};
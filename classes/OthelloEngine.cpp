@@ -0,0 +1,292 @@
+#include "OthelloEngine.h"
+#include <algorithm>
+#include <bit>
+
+namespace{
+
+constexpr uint64_t COLUMN_A = OthelloBoard::COLUMN_A;
+constexpr uint64_t COLUMN_H = OthelloBoard::COLUMN_H;
+constexpr uint64_t ROW_1 = 0x00000000000000FFULL;
+constexpr uint64_t ROW_8 = 0xFF00000000000000ULL;
+constexpr uint64_t BORDER = COLUMN_A | COLUMN_H | ROW_1 | ROW_8;
+
+// every row, column and diagonal of the board, for the filled line test of stableDiscs()
+template <class F>
+constexpr std::array<uint64_t, 15> lineMasks(F lineOf){
+    std::array<uint64_t, 15> masks{};
+    for(int sq = 0; sq < 64; ++sq) masks[lineOf(sq % 8, sq / 8)] |= uint64_t(1) << sq;
+    return masks;
+}
+constexpr auto ROWS = lineMasks([](int, int y){ return y; });
+constexpr auto COLUMNS = lineMasks([](int x, int){ return x; });
+constexpr auto DIAGONALS_9 = lineMasks([](int x, int y){ return x - y + 7; });     // a1-h8 direction
+constexpr auto DIAGONALS_7 = lineMasks([](int x, int y){ return x + y; });         // h1-a8 direction
+
+uint64_t filledLines(const uint64_t occupied, const std::array<uint64_t, 15>& lines){
+    uint64_t filled = 0;
+    for(uint64_t line : lines)
+        if((occupied & line) == line) filled |= line;
+    return filled;
+}
+
+// static move ordering: corners first, squares next to an empty corner last
+constexpr std::array<int8_t, 64> SQUARE_PRIORITY = {
+    100, -20,  10,   5,   5,  10, -20, 100,
+    -20, -50,  -2,  -2,  -2,  -2, -50, -20,
+     10,  -2,  -1,  -1,  -1,  -1,  -2,  10,
+      5,  -2,  -1,  -1,  -1,  -1,  -2,   5,
+      5,  -2,  -1,  -1,  -1,  -1,  -2,   5,
+     10,  -2,  -1,  -1,  -1,  -1,  -2,  10,
+    -20, -50,  -2,  -2,  -2,  -2, -50, -20,
+    100, -20,  10,   5,   5,  10, -20, 100,
+};
+
+// below this depth children are ordered by square class only, sorting by mobility costs more than it saves
+constexpr int MOBILITY_ORDER_DEPTH = 3;
+constexpr int MOBILITY_ORDER_WEIGHT = 16;
+
+// evaluation weights, the mobility terms are ratios in [-100, 100]
+constexpr int MOBILITY_WEIGHT = 10;
+constexpr int POTENTIAL_MOBILITY_WEIGHT = 5;
+constexpr int CORNER_WEIGHT = 800;
+constexpr int X_SQUARE_WEIGHT = 300;
+constexpr int C_SQUARE_WEIGHT = 100;
+constexpr int STABLE_WEIGHT = 60;
+
+int ratio(const int mine, const int theirs){
+    return 100 * (mine - theirs) / (mine + theirs + 2);
+}
+
+}
+
+
+
+OthelloEngine::OthelloEngine(const size_t tableEntries, const size_t endgameTableEntries) : _endgame(endgameTableEntries){
+    // power of two so the slot is a mask of the hash
+    size_t size = 1;
+    while(size < tableEntries) size <<= 1;
+    _table.resize(size);
+    _tableMask = size - 1;
+
+    _endgameEmpties = DEFAULT_ENDGAME_EMPTIES;
+    _stop = nullptr;
+    _hasDeadline = false;
+    _nodeLimit = 0;
+    _aborted = false;
+    _nodes = 0;
+}
+
+void OthelloEngine::setDeadline(const std::chrono::steady_clock::time_point deadline){
+    _deadline = deadline;
+    _hasDeadline = true;
+    _endgame.setDeadline(deadline);
+}
+
+void OthelloEngine::clearTable(){
+    std::fill(_table.begin(), _table.end(), TableEntry{});
+    _endgame.clearTable();
+}
+
+OthelloEngine::TableEntry& OthelloEngine::tableSlot(const uint64_t me, const uint64_t opp){
+    uint64_t h = me * 0x9E3779B97F4A7C15ULL ^ (opp + 0x632BE59BD9B4E019ULL) * 0xC2B2AE3D27D4EB4FULL;
+    h ^= h >> 29;
+    return _table[h & _tableMask];
+}
+
+void OthelloEngine::pollLimits(){
+    if(_stop && _stop->load(std::memory_order_relaxed)) _aborted = true;
+    if(_hasDeadline && std::chrono::steady_clock::now() >= _deadline) _aborted = true;
+    if(_nodeLimit && _nodes >= _nodeLimit) _aborted = true;
+}
+
+
+int OthelloEngine::finalDiscDiff(const uint64_t me, const uint64_t opp){
+    const int mine = std::popcount(me), theirs = std::popcount(opp);
+    const int empties = 64 - mine - theirs;
+    if(mine > theirs) return mine - theirs + empties;
+    if(theirs > mine) return mine - theirs - empties;
+    return 0;
+}
+
+uint64_t OthelloEngine::stableDiscs(const uint64_t me, const uint64_t opp){
+    // every stable disc is anchored in a corner unless all four lines through it are filled, rare enough to skip
+    if(!(me & CORNERS)) return 0;
+
+    const uint64_t occupied = me | opp;
+    const uint64_t filledH = filledLines(occupied, ROWS);
+    const uint64_t filledV = filledLines(occupied, COLUMNS);
+    const uint64_t filled9 = filledLines(occupied, DIAGONALS_9);
+    const uint64_t filled7 = filledLines(occupied, DIAGONALS_7);
+
+    // a disc is safe along a line when the line is filled or one neighbour on it is off the board or a stable disc of
+    // mine, stable on all four lines means it can never flip. grows from the corners to the least fixed point
+    uint64_t stable = 0;
+    while(true){
+        const uint64_t h = filledH | COLUMN_A | COLUMN_H
+                         | OthelloBoard::shift<1>(stable & ~COLUMN_H) | OthelloBoard::shift<-1>(stable & ~COLUMN_A);
+        const uint64_t v = filledV | ROW_1 | ROW_8 | OthelloBoard::shift<8>(stable) | OthelloBoard::shift<-8>(stable);
+        const uint64_t d9 = filled9 | BORDER
+                          | OthelloBoard::shift<9>(stable & ~COLUMN_H) | OthelloBoard::shift<-9>(stable & ~COLUMN_A);
+        const uint64_t d7 = filled7 | BORDER
+                          | OthelloBoard::shift<7>(stable & ~COLUMN_A) | OthelloBoard::shift<-7>(stable & ~COLUMN_H);
+
+        const uint64_t next = me & h & v & d9 & d7;
+        if(next == stable) return stable;
+        stable = next;
+    }
+}
+
+int OthelloEngine::evaluate(const uint64_t me, const uint64_t opp){
+    const uint64_t empty = ~(me | opp);
+
+    const int mobility = ratio(std::popcount(OthelloBoard::legalMoves(me, opp)), std::popcount(OthelloBoard::legalMoves(opp, me)));
+    // empty squares next to the other side's discs are where moves can appear later
+    const int potential = ratio(std::popcount(OthelloBoard::neighbours(opp) & empty), std::popcount(OthelloBoard::neighbours(me) & empty));
+    const int corners = std::popcount(me & CORNERS) - std::popcount(opp & CORNERS);
+
+    // X and C squares only hurt while their corner is still open
+    const uint64_t exposed = OthelloBoard::neighbours(CORNERS & empty);
+    const int xSquares = std::popcount(me & exposed & X_SQUARES) - std::popcount(opp & exposed & X_SQUARES);
+    const int cSquares = std::popcount(me & exposed & C_SQUARES) - std::popcount(opp & exposed & C_SQUARES);
+
+    const int stable = std::popcount(stableDiscs(me, opp)) - std::popcount(stableDiscs(opp, me));
+
+    return MOBILITY_WEIGHT * mobility + POTENTIAL_MOBILITY_WEIGHT * potential + CORNER_WEIGHT * corners
+         - X_SQUARE_WEIGHT * xSquares - C_SQUARE_WEIGHT * cSquares + STABLE_WEIGHT * stable;
+}
+
+
+void OthelloEngine::orderMoves(const uint64_t me, const uint64_t opp, uint64_t moves, const int ttMove, const bool byMobility,
+                               MoveList& list) const{
+    std::array<int, OthelloBoard::SQUARES> keys;
+    list.count = 0;
+
+    for(; moves; moves &= moves - 1){
+        const int sq = std::countr_zero(moves);
+        int key = SQUARE_PRIORITY[sq];
+        if(sq == ttMove){
+            key = INF_SCORE;
+        }else if(byMobility){
+            // fewer replies for the opponent first
+            const uint64_t flipped = OthelloBoard::flips(me, opp, sq);
+            const uint64_t replies = OthelloBoard::legalMoves(opp & ~flipped, me | flipped | OthelloBoard::squareMask(sq));
+            key -= MOBILITY_ORDER_WEIGHT * std::popcount(replies);
+        }
+
+        // insertion sort, a node rarely has more than 15 moves
+        int i = list.count++;
+        for(; i > 0 && keys[i - 1] < key; --i){
+            keys[i] = keys[i - 1];
+            list.squares[i] = list.squares[i - 1];
+        }
+        keys[i] = key;
+        list.squares[i] = static_cast<int8_t>(sq);
+    }
+}
+
+int OthelloEngine::negamax(const uint64_t me, const uint64_t opp, int alpha, int beta, const int depth, const bool passed){
+    if((++_nodes % LIMIT_POLL_NODES) == 0) pollLimits();
+    if(_aborted) return 0;
+
+    const uint64_t moves = OthelloBoard::legalMoves(me, opp);
+    if(!moves){
+        if(passed) return gameScore(finalDiscDiff(me, opp));
+        return -negamax(opp, me, -beta, -alpha, depth, true);
+    }
+    if(depth <= 0) return _patterns.loaded() ? _patterns.evaluate(me, opp) : evaluate(me, opp);
+
+    TableEntry& slot = tableSlot(me, opp);
+    int ttMove = -1;
+    if(slot.me == me && slot.opp == opp){
+        ttMove = slot.move;
+        if(slot.depth >= depth){
+            if(slot.bound == EXACT) return slot.score;
+            if(slot.bound == LOWER) alpha = std::max(alpha, slot.score);
+            else beta = std::min(beta, slot.score);
+            if(alpha >= beta) return slot.score;
+        }
+    }
+
+    MoveList list;
+    orderMoves(me, opp, moves, ttMove, depth >= MOBILITY_ORDER_DEPTH, list);
+
+    const int alphaOrig = alpha;
+    int best = -INF_SCORE;
+    int bestMove = list.squares[0];
+    for(int k = 0; k < list.count; ++k){
+        const int sq = list.squares[k];
+        const uint64_t flipped = OthelloBoard::flips(me, opp, sq);
+        const int score = -negamax(opp & ~flipped, me | flipped | OthelloBoard::squareMask(sq), -beta, -alpha, depth - 1);
+        if(_aborted) return 0;
+
+        if(score > best){
+            best = score;
+            bestMove = sq;
+        }
+        if(best > alpha) alpha = best;
+        if(alpha >= beta) break;
+    }
+
+    slot.me = me;
+    slot.opp = opp;
+    slot.score = best;
+    slot.depth = static_cast<int8_t>(depth);
+    slot.bound = best <= alphaOrig ? UPPER : (best >= beta ? LOWER : EXACT);
+    slot.move = static_cast<int8_t>(bestMove);
+    return best;
+}
+
+
+OthelloEngine::SearchResult OthelloEngine::search(const OthelloBoard& board, const Color me, const int maxDepth){
+    _nodes = 0;
+    _aborted = false;
+
+    const uint64_t mine = board.discs(me);
+    const uint64_t theirs = board.discs(static_cast<Color>(!me));
+    const uint64_t moves = OthelloBoard::legalMoves(mine, theirs);
+
+    SearchResult result{-1, 0, 0, 0, false, false};
+    if(!moves) return result;
+
+    int bookScore, bookDepth;
+    const int bookMove = _book.bestMove(mine, theirs, &bookScore, &bookDepth);
+    if(bookMove >= 0) return {bookMove, bookScore, bookDepth, 0, false, true};
+
+    MoveList list;
+    orderMoves(mine, theirs, moves, -1, true, list);
+    result.bestMove = list.squares[0];
+
+    // passes don't use up depth, so searching as deep as there are empty squares reaches the end of every line
+    const bool solve = _endgameEmpties > 0 && board.emptyCount() <= _endgameEmpties;
+    const int lastDepth = std::min(solve ? ENDGAME_FALLBACK_DEPTH : maxDepth, board.emptyCount());
+    for(int d = 1; d <= lastDepth; ++d){
+        int alpha = -INF_SCORE;
+        int bestMove = -1;
+        for(int k = 0; k < list.count; ++k){
+            const int sq = list.squares[k];
+            const uint64_t flipped = OthelloBoard::flips(mine, theirs, sq);
+            const int score = -negamax(theirs & ~flipped, mine | flipped | OthelloBoard::squareMask(sq), -INF_SCORE, -alpha, d - 1);
+            if(_aborted) break;
+            if(score > alpha){
+                alpha = score;
+                bestMove = sq;
+            }
+        }
+        if(_aborted) break;
+
+        result = {bestMove, alpha, d, _nodes, false, false};
+        // the next iteration starts with this one's best move
+        auto* it = std::find(list.squares.begin(), list.squares.begin() + list.count, static_cast<int8_t>(bestMove));
+        std::rotate(list.squares.begin(), it, it + 1);
+    }
+
+    if(solve && !_aborted){
+        const OthelloEndgame::Result solved = _endgame.solve(board, me);
+        _nodes += solved.nodes;
+        _aborted = _endgame.stopped();
+        if(!_aborted) result = {solved.bestMove, gameScore(solved.score), board.emptyCount(), _nodes, true, false};
+    }
+
+    result.nodes = _nodes;
+    return result;
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "OthelloBoard.h"
+#include "OthelloBook.h"
+#include "OthelloEndgame.h"
+#include "OthelloPatterns.h"
+
+// alpha-beta Othello search on OthelloBoard masks: iterative deepening, transposition table, move ordering
+// by table move, square class and opponent mobility. positions are passed as (me, opp) = side to move, other side
+// from endgameEmpties() empty squares on search() hands over to the exact OthelloEndgame solver. leaves are scored by
+// the learned OthelloPatterns tables when a weight file is loaded, by the handcrafted evaluate() otherwise.
+// with an opening book loaded, search() plays the book move without searching while the position is in it
+class OthelloEngine{
+
+public:
+
+    using Color = OthelloBoard::Color;
+
+    struct SearchResult{
+        int bestMove;       // square, -1 if the side to move has to pass
+        int score;
+        int depth;          // last completed iteration
+        uint64_t nodes;
+        bool exact;         // solved to the end by the endgame solver
+        bool book;          // taken from the opening book, score and depth are the book's
+    };
+
+    // finished games score WIN_SCORE plus the disc differential, evaluations stay well below it
+    static constexpr int32_t WIN_SCORE = 1000000;
+    static constexpr int32_t INF_SCORE = WIN_SCORE * 2;
+    static constexpr uint64_t LIMIT_POLL_NODES = 1024;
+    static constexpr size_t DEFAULT_TABLE_ENTRIES = size_t(1) << 20;
+    static constexpr int DEFAULT_ENDGAME_EMPTIES = 16;
+    // depth of the midgame search that runs before the solver, its move is played if the solver runs out of time
+    static constexpr int ENDGAME_FALLBACK_DEPTH = 4;
+
+    explicit OthelloEngine(const size_t tableEntries = DEFAULT_TABLE_ENTRIES,
+                           const size_t endgameTableEntries = OthelloEndgame::DEFAULT_TABLE_ENTRIES);
+
+    // same contract as Connect4Engine: search unwinds once *stop is set, the deadline passes or the node limit
+    // is hit, search() then returns the last completed iteration
+    void            setStopFlag(const std::atomic<bool>* stop) { _stop = stop; _endgame.setStopFlag(stop); }
+    void            setDeadline(const std::chrono::steady_clock::time_point deadline);
+    void            clearDeadline() { _hasDeadline = false; _endgame.clearDeadline(); }
+    void            setNodeLimit(const uint64_t nodes) { _nodeLimit = nodes; _endgame.setNodeLimit(nodes); }
+    bool            stopped() const { return _aborted; }
+    uint64_t        nodes() const { return _nodes; }
+    void            clearTable();
+
+    // positions with at most this many empty squares are solved exactly, 0 switches the solver off
+    void            setEndgameEmpties(const int empties) { _endgameEmpties = empties; }
+    int             endgameEmpties() const { return _endgameEmpties; }
+    // the exact solves split over this pool (OthelloEndgame::setThreadPool), nullptr solves on the calling thread
+    void            setEndgamePool(ThreadPool* pool) { _endgame.setThreadPool(pool); }
+
+    // the weights are optional, a failed load keeps the handcrafted evaluation
+    bool            loadPatterns(const std::string& path, std::string* error = nullptr) { return _patterns.loadWeights(path, error); }
+    void            setPatterns(const OthelloPatterns& patterns) { _patterns = patterns; }
+    bool            usingPatterns() const { return _patterns.loaded(); }
+
+    // the book is optional as well, a failed load leaves the engine searching every move
+    bool            loadBook(const std::string& path, std::string* error = nullptr) { return _book.load(path, error); }
+    void            setBook(const OthelloBook& book) { _book = book; }
+    bool            usingBook() const { return _book.loaded(); }
+
+    // iterative deepening from depth 1 up to maxDepth for the side me
+    SearchResult    search(const OthelloBoard& board, const Color me, const int maxDepth);
+    // fixed depth, a pass does not use up depth
+    int             negamax(const uint64_t me, const uint64_t opp, int alpha, int beta, const int depth, const bool passed = false);
+
+    // static evaluation for the side to move: mobility, potential mobility, corners, X/C squares, stable discs
+    static int      evaluate(const uint64_t me, const uint64_t opp);
+    // discs of me that can never be flipped (a safe subset: edges anchored in corners and filled lines)
+    static uint64_t stableDiscs(const uint64_t me, const uint64_t opp);
+    // disc differential of a finished game for me, empty squares go to the winner
+    static int      finalDiscDiff(const uint64_t me, const uint64_t opp);
+    // search score of a finished game with that differential
+    static int      gameScore(const int discDiff) { return discDiff > 0 ? WIN_SCORE + discDiff : (discDiff < 0 ? -WIN_SCORE + discDiff : 0); }
+
+    static constexpr uint64_t CORNERS = 0x8100000000000081ULL;
+    // diagonal neighbours of the corners, and the edge squares next to them
+    static constexpr uint64_t X_SQUARES = 0x0042000000004200ULL;
+    static constexpr uint64_t C_SQUARES = 0x4281000000008142ULL;
+
+private:
+
+    enum Bound: uint8_t{ EXACT, LOWER, UPPER };
+
+    struct TableEntry{
+        uint64_t me = 0;
+        uint64_t opp = 0;
+        int32_t score = 0;
+        int8_t depth = -1;
+        Bound bound = EXACT;
+        int8_t move = -1;
+    };
+
+    // moves of one node, best candidates first
+    struct MoveList{
+        std::array<int8_t, OthelloBoard::SQUARES> squares;
+        int count = 0;
+    };
+
+    // table move first, then corners before X squares, at deeper nodes also fewest opponent replies first
+    void            orderMoves(const uint64_t me, const uint64_t opp, uint64_t moves, const int ttMove, const bool byMobility,
+                               MoveList& list) const;
+    TableEntry&     tableSlot(const uint64_t me, const uint64_t opp);
+    void            pollLimits();
+
+    std::vector<TableEntry> _table;
+    size_t _tableMask;
+    OthelloEndgame _endgame;
+    int _endgameEmpties;
+    OthelloPatterns _patterns;
+    OthelloBook _book;
+
+    const std::atomic<bool>* _stop;
+    std::chrono::steady_clock::time_point _deadline;
+    bool _hasDeadline;
+    uint64_t _nodeLimit;
+    bool _aborted;
+    uint64_t _nodes;
+};
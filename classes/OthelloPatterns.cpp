@@ -0,0 +1,136 @@
+#include "OthelloPatterns.h"
+#include "OthelloBoard.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace{
+
+struct Instance{
+    int size;
+    uint32_t offset;        // first entry of the pattern's table in a phase block
+    uint64_t mask;
+    std::array<int8_t, OthelloPatterns::MAX_SQUARES> squares;
+};
+
+// every pattern under the 8 board symmetries, images covering the same squares as an earlier one are dropped
+constexpr std::array<Instance, OthelloPatterns::INSTANCES> INSTANCE_TABLE = []{
+    std::array<Instance, OthelloPatterns::INSTANCES> instances{};
+    int count = 0;
+    uint32_t offset = 0;
+    for(const OthelloPatterns::Pattern& p : OthelloPatterns::PATTERNS){
+        const int first = count;
+        for(int s = 0; s < OthelloBoard::SYMMETRIES; ++s){
+            Instance image{p.size, offset, 0, {}};
+            for(int i = 0; i < p.size; ++i){
+                image.squares[i] = static_cast<int8_t>(OthelloBoard::transformSquare(p.squares[i], s));
+                image.mask |= OthelloBoard::squareMask(image.squares[i]);
+            }
+            bool seen = false;
+            for(int k = first; k < count; ++k) seen = seen || instances[k].mask == image.mask;
+            if(seen) continue;
+            if(count == OthelloPatterns::INSTANCES) throw "more pattern instances than INSTANCES";
+            instances[count++] = image;
+        }
+        offset += OthelloPatterns::tableSize(p.size);
+    }
+    if(count != OthelloPatterns::INSTANCES) throw "fewer pattern instances than INSTANCES";
+    return instances;
+}();
+
+uint32_t patternIndex(const Instance& instance, const uint64_t me, const uint64_t opp){
+    uint32_t index = 0;
+    for(int i = instance.size - 1; i >= 0; --i){
+        const int sq = instance.squares[i];
+        index = index * 3 + static_cast<uint32_t>((me >> sq) & 1) + 2 * static_cast<uint32_t>((opp >> sq) & 1);
+    }
+    return index;
+}
+
+}
+
+
+
+int OthelloPatterns::phase(const uint64_t me, const uint64_t opp){
+    const int discs = std::popcount(me | opp);
+    return std::clamp((discs - 4) * PHASES / 61, 0, PHASES - 1);
+}
+
+void OthelloPatterns::features(const uint64_t me, const uint64_t opp, std::array<uint32_t, FEATURES>& out){
+    for(int i = 0; i < INSTANCES; ++i) out[i] = INSTANCE_TABLE[i].offset + patternIndex(INSTANCE_TABLE[i], me, opp);
+    out[INSTANCES] = BIAS;
+}
+
+int OthelloPatterns::evaluate(const uint64_t me, const uint64_t opp) const{
+    const int16_t* w = _weights->data() + static_cast<size_t>(phase(me, opp)) * PHASE_WEIGHTS;
+    int score = w[BIAS];
+    for(const Instance& instance : INSTANCE_TABLE) score += w[instance.offset + patternIndex(instance, me, opp)];
+    return score;
+}
+
+
+bool OthelloPatterns::setWeights(std::vector<int16_t> weights){
+    if(weights.size() != static_cast<size_t>(PHASES) * PHASE_WEIGHTS) return false;
+    _weights = std::make_shared<const std::vector<int16_t>>(std::move(weights));
+    return true;
+}
+
+bool OthelloPatterns::loadWeights(const std::string& path, std::string* error){
+    auto fail = [&](const std::string& msg){
+        if(error) *error = msg;
+        _weights.reset();
+        return false;
+    };
+
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open()) return fail("could not open " + path);
+
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t offset = 0;
+    auto read = [&](void* dst, const size_t bytes){
+        if(offset + bytes > data.size()) return false;
+        std::memcpy(dst, data.data() + offset, bytes);
+        offset += bytes;
+        return true;
+    };
+
+    char magic[4];
+    uint32_t version = 0, phases = 0, phaseWeights = 0;
+    if(!read(magic, sizeof(magic)) || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0)
+        return fail("bad magic in " + path);
+    if(!read(&version, sizeof(version)) || version != FILE_VERSION)
+        return fail("unsupported version in " + path);
+    if(!read(&phases, sizeof(phases)) || !read(&phaseWeights, sizeof(phaseWeights)) || phases != PHASES || phaseWeights != PHASE_WEIGHTS)
+        return fail("pattern layout of " + path + " does not match this build");
+
+    std::vector<int16_t> weights(static_cast<size_t>(PHASES) * PHASE_WEIGHTS);
+    if(!read(weights.data(), weights.size() * sizeof(int16_t))) return fail("truncated weight file " + path);
+    if(offset != data.size()) return fail("trailing bytes in " + path);
+
+    setWeights(std::move(weights));
+    return true;
+}
+
+bool OthelloPatterns::saveWeights(const std::string& path, std::string* error) const{
+    if(!_weights){
+        if(error) *error = "no weights to save";
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    const uint32_t phases = PHASES, phaseWeights = PHASE_WEIGHTS;
+    file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    file.write(reinterpret_cast<const char*>(&FILE_VERSION), sizeof(FILE_VERSION));
+    file.write(reinterpret_cast<const char*>(&phases), sizeof(phases));
+    file.write(reinterpret_cast<const char*>(&phaseWeights), sizeof(phaseWeights));
+    file.write(reinterpret_cast<const char*>(_weights->data()), static_cast<std::streamsize>(_weights->size() * sizeof(int16_t)));
+
+    if(!file){
+        if(error) *error = "could not write " + path;
+        return false;
+    }
+    return true;
+}
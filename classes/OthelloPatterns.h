@@ -0,0 +1,77 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// learned Othello evaluation from pattern tables. every instance of a pattern reads its squares as a base 3 number
+// (0 empty, 1 side to move, 2 opponent, first square lowest digit) and looks it up in the table that all symmetric
+// instances of the pattern share. one set of tables per game phase (disc count), the score is the phase bias plus
+// INSTANCES table entries. the tables are fitted offline by othello_fit and loaded from a flat weight file
+class OthelloPatterns{
+
+public:
+
+    struct Pattern{
+        const char* name;
+        int size;
+        std::array<int8_t, 10> squares;     // one instance, the others are its images under the board symmetries
+    };
+
+    static constexpr int MAX_SQUARES = 10;
+    static constexpr std::array<Pattern, 8> PATTERNS = {{
+        {"edge+2x",   10, {0, 1, 2, 3, 4, 5, 6, 7, 9, 14}},
+        {"corner3x3",  9, {0, 1, 2, 8, 9, 10, 16, 17, 18}},
+        {"corner2x5", 10, {0, 1, 2, 3, 4, 8, 9, 10, 11, 12}},
+        {"diagonal8",  8, {0, 9, 18, 27, 36, 45, 54, 63}},
+        {"diagonal7",  7, {1, 10, 19, 28, 37, 46, 55}},
+        {"diagonal6",  6, {2, 11, 20, 29, 38, 47}},
+        {"diagonal5",  5, {3, 12, 21, 30, 39}},
+        {"diagonal4",  4, {4, 13, 22, 31}},
+    }};
+    // distinct images of the patterns above: 4 + 4 + 8 + 2 + 4 + 4 + 4 + 4
+    static constexpr int INSTANCES = 34;
+    // the instances plus the phase bias
+    static constexpr int FEATURES = INSTANCES + 1;
+
+    // entries of one phase: the tables in PATTERNS order, then the bias
+    static constexpr uint32_t PHASE_WEIGHTS = []{
+        uint32_t size = 1;
+        for(const Pattern& p : PATTERNS){
+            uint32_t table = 1;
+            for(int i = 0; i < p.size; ++i) table *= 3;
+            size += table;
+        }
+        return size;
+    }();
+    static constexpr uint32_t BIAS = PHASE_WEIGHTS - 1;
+
+    // 4..64 discs split into this many phases of about 5 moves
+    static constexpr int PHASES = 12;
+    // weights and evaluate() are in 1/100 disc
+    static constexpr int UNITS_PER_DISC = 100;
+
+    // flat little endian weight file: magic, version, phases, entries per phase, then PHASES * PHASE_WEIGHTS int16
+    static constexpr char     FILE_MAGIC[4] = {'O', 'T', 'P', 'W'};
+    static constexpr uint32_t FILE_VERSION = 1;
+
+    static constexpr uint32_t tableSize(const int squares){ return squares ? 3 * tableSize(squares - 1) : 1; }
+    static int      phase(const uint64_t me, const uint64_t opp);
+    // entry of every instance in its phase block, the bias last
+    static void     features(const uint64_t me, const uint64_t opp, std::array<uint32_t, FEATURES>& out);
+
+    bool            loadWeights(const std::string& path, std::string* error = nullptr);
+    bool            saveWeights(const std::string& path, std::string* error = nullptr) const;
+    // PHASES * PHASE_WEIGHTS entries, phase major
+    bool            setWeights(std::vector<int16_t> weights);
+    bool            loaded() const { return _weights != nullptr; }
+
+    // expected final disc differential for the side to move, in 1/UNITS_PER_DISC discs
+    int             evaluate(const uint64_t me, const uint64_t opp) const;
+
+private:
+
+    // shared between engine copies, the tables are 3.5MB
+    std::shared_ptr<const std::vector<int16_t>> _weights;
+};
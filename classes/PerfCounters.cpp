@@ -0,0 +1,137 @@
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+
+bool PerfCounters::Sample::any() const{
+    for(bool v : valid)
+        if(v) return true;
+    return false;
+}
+
+double PerfCounters::Sample::ipc() const{
+    if(!valid[CYCLES] || !valid[INSTRUCTIONS] || values[CYCLES] == 0) return 0.0;
+    return static_cast<double>(values[INSTRUCTIONS]) / values[CYCLES];
+}
+
+double PerfCounters::Sample::perNode(const Event event, const uint64_t nodes) const{
+    if(!valid[event] || nodes == 0) return 0.0;
+    return static_cast<double>(values[event]) / nodes;
+}
+
+
+#ifdef __linux__
+
+namespace{
+
+struct EventConfig{
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t cacheMissConfig(const uint64_t cache){
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+constexpr std::array<EventConfig, PerfCounters::EVENT_COUNT> EVENT_CONFIGS = {{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_LL)},
+}};
+
+// value, time enabled, time running (PERF_FORMAT_TOTAL_TIME_*)
+struct ReadFormat{
+    uint64_t value;
+    uint64_t enabled;
+    uint64_t running;
+};
+
+}
+
+
+PerfCounters::PerfCounters(){
+    for(int i = 0; i < EVENT_COUNT; ++i){
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = EVENT_CONFIGS[i].type;
+        attr.config = EVENT_CONFIGS[i].config;
+        attr.disabled = 1;
+        // user space only, that's all perf_event_paranoid=2 allows and all the search does anyway
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+        _fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if(_fds[i] < 0 && _error.empty())
+            _error = std::string(EVENT_NAMES[i]) + ": " + std::strerror(errno);
+    }
+}
+
+PerfCounters::~PerfCounters(){
+    for(int fd : _fds)
+        if(fd >= 0) close(fd);
+}
+
+bool PerfCounters::available() const{
+    for(int fd : _fds)
+        if(fd >= 0) return true;
+    return false;
+}
+
+void PerfCounters::start(){
+    for(int fd : _fds){
+        if(fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+PerfCounters::Sample PerfCounters::stop(){
+    Sample sample;
+
+    for(int i = 0; i < EVENT_COUNT; ++i){
+        if(_fds[i] < 0) continue;
+        ioctl(_fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+        ReadFormat r;
+        if(read(_fds[i], &r, sizeof(r)) != sizeof(r) || r.running == 0) continue;
+
+        // the kernel multiplexes when there are more events than hardware counters, scale up to the full interval
+        sample.values[i] = r.running < r.enabled ? static_cast<uint64_t>(static_cast<double>(r.value) * r.enabled / r.running) : r.value;
+        sample.valid[i] = true;
+    }
+
+    return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters(){
+    _fds.fill(-1);
+    _error = "perf_event_open is Linux only";
+}
+
+PerfCounters::~PerfCounters(){}
+
+bool PerfCounters::available() const{
+    return false;
+}
+
+void PerfCounters::start(){}
+
+PerfCounters::Sample PerfCounters::stop(){
+    return Sample{};
+}
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+
+// hardware performance counters of the calling thread through Linux perf_event_open
+// every counter is optional: ones the kernel or the machine refuses (perf_event_paranoid, VMs without a PMU)
+// are reported as invalid, on other platforms nothing is available and start()/stop() are no-ops
+class PerfCounters{
+
+public:
+
+    enum Event{
+        CYCLES = 0,
+        INSTRUCTIONS,
+        BRANCH_MISSES,
+        L1D_MISSES,
+        LLC_MISSES,
+        EVENT_COUNT
+    };
+
+    struct Sample{
+        std::array<uint64_t, EVENT_COUNT> values{};
+        std::array<bool, EVENT_COUNT> valid{};
+
+        bool    any() const;
+        // instructions per cycle, 0 if either counter is missing
+        double  ipc() const;
+        // count per searched node, 0 if the counter is missing
+        double  perNode(const Event event, const uint64_t nodes) const;
+    };
+
+    static constexpr std::array<const char*, EVENT_COUNT> EVENT_NAMES = {"Cycles", "Instructions", "BranchMisses", "L1DMisses", "LLCMisses"};
+
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool                available() const;
+    // why counters are missing, empty if all of them opened
+    const std::string&  error() const { return _error; }
+
+    void    start();
+    Sample  stop();
+
+private:
+
+    std::array<int, EVENT_COUNT> _fds;
+    std::string _error;
+};
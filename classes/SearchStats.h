@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// search instrumentation, only counted when built with CONNECT4_SEARCH_STATS (cmake -DENABLE_SEARCH_STATS=ON)
+// SEARCH_STAT(...) drops its statements otherwise, so a release build without stats pays nothing
+#ifdef CONNECT4_SEARCH_STATS
+#define SEARCH_STAT(...) __VA_ARGS__
+#else
+#define SEARCH_STAT(...)
+#endif
+
+
+
+// counters of one search, indexed by ply from the root position (the nodes after the root moves are ply 1)
+struct SearchStats{
+
+#ifdef CONNECT4_SEARCH_STATS
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    // one more than the cells of the largest board the engine is instantiated for (10x8)
+    static constexpr int MAX_PLY = 81;
+
+    struct Counters{
+        uint64_t nodes = 0;
+        uint64_t leafEvals = 0;
+        uint64_t betaCutoffs = 0;
+        uint64_t firstMoveCutoffs = 0;  // cutoffs caused by the first move searched, measures move ordering
+        uint64_t terminalHits = 0;      // won, lost or full positions
+        uint64_t cacheProbes = 0;
+        uint64_t cacheHits = 0;
+    };
+
+    std::array<Counters, MAX_PLY> ply{};
+    int maxPly = 0;
+
+    void clear() { *this = SearchStats{}; }
+
+    // merges the counters of a search that ran on an engine copy
+    void add(const SearchStats& other){
+        for(int i = 0; i <= other.maxPly; ++i){
+            ply[i].nodes += other.ply[i].nodes;
+            ply[i].leafEvals += other.ply[i].leafEvals;
+            ply[i].betaCutoffs += other.ply[i].betaCutoffs;
+            ply[i].firstMoveCutoffs += other.ply[i].firstMoveCutoffs;
+            ply[i].terminalHits += other.ply[i].terminalHits;
+            ply[i].cacheProbes += other.ply[i].cacheProbes;
+            ply[i].cacheHits += other.ply[i].cacheHits;
+        }
+        if(other.maxPly > maxPly) maxPly = other.maxPly;
+    }
+
+    Counters total() const{
+        Counters sum;
+        for(int i = 0; i <= maxPly; ++i){
+            sum.nodes += ply[i].nodes;
+            sum.leafEvals += ply[i].leafEvals;
+            sum.betaCutoffs += ply[i].betaCutoffs;
+            sum.firstMoveCutoffs += ply[i].firstMoveCutoffs;
+            sum.terminalHits += ply[i].terminalHits;
+            sum.cacheProbes += ply[i].cacheProbes;
+            sum.cacheHits += ply[i].cacheHits;
+        }
+        return sum;
+    }
+
+    // share of cutoffs found on the first move, 1.0 is perfect ordering
+    static double firstMoveRate(const Counters& c) { return c.betaCutoffs ? static_cast<double>(c.firstMoveCutoffs) / c.betaCutoffs : 0.0; }
+};
@@ -0,0 +1,76 @@
+#include "SearchTrace.h"
+#include <fstream>
+
+
+
+SearchTrace::SearchTrace(const size_t capacity, const int maxPly){
+    _buffer.resize(capacity > 0 ? capacity : 1);
+    _maxPly = maxPly;
+    clear();
+}
+
+void SearchTrace::clear(){
+    _head = 0;
+    _count = 0;
+    _wrapped = false;
+}
+
+
+void SearchTrace::beginSearch(const std::array<uint64_t, 2>& pieces, const bool yellowToMove, const int depth){
+    Record r{};
+    r.pieces = pieces;
+    r.alpha = depth;
+    r.cutoffIdx = -1;
+    r.flags = SEARCH_START | (yellowToMove ? PLAYER_YELLOW : 0);
+    record(r);
+}
+
+void SearchTrace::record(const Record& r){
+    _buffer[_head] = r;
+    _head = (_head + 1) % _buffer.size();
+
+    if(_count < _buffer.size()) ++_count;
+    else _wrapped = true;
+}
+
+
+bool SearchTrace::dump(const std::string& path) const{
+    std::ofstream out(path, std::ios::binary);
+    if(!out) return false;
+
+    const uint32_t header[4] = {FILE_MAGIC, FILE_VERSION, static_cast<uint32_t>(sizeof(Record)), static_cast<uint32_t>(_count)};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    // oldest first
+    const size_t first = (_head + _buffer.size() - _count) % _buffer.size();
+    for(size_t i = 0; i < _count; ++i)
+        out.write(reinterpret_cast<const char*>(&_buffer[(first + i) % _buffer.size()]), sizeof(Record));
+
+    return static_cast<bool>(out);
+}
+
+bool SearchTrace::load(const std::string& path, std::vector<Record>& records, std::string* error){
+    std::ifstream in(path, std::ios::binary);
+    if(!in){
+        if(error) *error = "cannot open " + path;
+        return false;
+    }
+
+    uint32_t header[4];
+    if(!in.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != FILE_MAGIC){
+        if(error) *error = "not a search trace";
+        return false;
+    }
+    if(header[1] != FILE_VERSION || header[2] != sizeof(Record)){
+        if(error) *error = "unsupported trace version";
+        return false;
+    }
+
+    records.resize(header[3]);
+    if(!in.read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record)))){
+        if(error) *error = "truncated trace";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// bounded negamax tree recorder: every node down to maxPly is written on exit (children before parents)
+// into a fixed size ring buffer, the oldest records are overwritten once it is full
+// dump() writes the buffer oldest first, tools/connect4_trace turns the file into folded stacks or DOT
+class SearchTrace{
+
+public:
+
+    enum Flags: uint8_t{
+        PLAYER_YELLOW = 1,      // side to move at this node
+        LEAF = 2,               // depth ran out, static eval
+        TERMINAL = 4,           // won, lost or full board
+        SEARCH_START = 8,       // not a node: a new root search, pieces = root position, alpha = depth
+    };
+
+    struct Record{
+        std::array<uint64_t, 2> pieces;     // red, yellow
+        int32_t alpha;                      // window on entry
+        int32_t beta;
+        int32_t score;
+        uint32_t subtreeNodes;              // nodes searched below and including this one, saturates
+        uint8_t ply;                        // 1 = the nodes after the root moves
+        int8_t cutoffIdx;                   // position in move order of the move that failed high, -1 if none
+        uint8_t searched;                   // children searched
+        uint8_t flags;
+    };
+
+    static constexpr uint32_t FILE_MAGIC = 0x52543443;     // "C4TR"
+    static constexpr uint32_t FILE_VERSION = 1;
+
+    SearchTrace(const size_t capacity = 1 << 16, const int maxPly = 4);
+
+    int     maxPly() const { return _maxPly; }
+    void    setMaxPly(const int maxPly) { _maxPly = maxPly; }
+    void    clear();
+
+    void    beginSearch(const std::array<uint64_t, 2>& pieces, const bool yellowToMove, const int depth);
+    void    record(const Record& r);
+
+    size_t  size() const { return _count; }
+    bool    wrapped() const { return _wrapped; }
+
+    bool    dump(const std::string& path) const;
+    static bool load(const std::string& path, std::vector<Record>& records, std::string* error = nullptr);
+
+private:
+
+    std::vector<Record> _buffer;
+    size_t _head;           // next slot to write
+    size_t _count;
+    bool _wrapped;
+    int _maxPly;
+};
@@ -6,6 +6,12 @@
 
 // Simple helper function to load an image into a OpenGL texture with common settings
 bool Sprite::LoadTextureFromFile(const char* filename)
+{
+    _texture = LoadTexture(filename, _size);
+    return _texture != 0;
+}
+
+ImTextureID Sprite::LoadTexture(const char* filename, ImVec2& size)
 {
     // Load from file
     int image_width = 0;
@@ -14,18 +20,18 @@ bool Sprite::LoadTextureFromFile(const char* filename)
     std::string newFilename = resourcePath.string();
     unsigned char* image_data = stbi_load(newFilename.c_str(), &image_width, &image_height, NULL, 4);
     if (image_data == NULL) {
-        _size = ImVec2(0, 0);
+        size = ImVec2(0, 0);
         std::cout << "Failed to load texture: " << newFilename << std::endl;
-        return false;
+        return 0;
     }
-    _texture = _loadTextureFromMemory(image_data, image_width, image_height);
+    ImTextureID texture = _loadTextureFromMemory(image_data, image_width, image_height);
     stbi_image_free(image_data);
-    if (_texture == 0) {
-        _size = ImVec2(0, 0);
-        return false;
+    if (texture == 0) {
+        size = ImVec2(0, 0);
+        return 0;
     }
-    _size = ImVec2((float)image_width, (float)image_height);
-    return true;
+    size = ImVec2((float)image_width, (float)image_height);
+    return texture;
 }
 
 void Sprite::setHighlighted(bool highlighted)
@@ -36,6 +36,7 @@ public:
         _location = ImVec2(point.x - _size.x / 2, point.y - _size.y / 2);
     }
     const ImVec2 &getPosition() { return _location; }
+    const ImVec2 &getSize() { return _size; }
 
     void setSize(float x, float y)
     {
@@ -76,6 +77,11 @@ public:
     }
 
     bool LoadTextureFromFile(const char* filename);
+    // load a texture without a sprite to hold it, 0 and a zero size if the file is missing
+    static ImTextureID LoadTexture(const char* filename, ImVec2& size);
+    // share a texture another sprite already loaded, no file access or upload
+    ImTextureID getTexture() const { return _texture; }
+    void setTexture(ImTextureID texture) { _texture = texture; }
 	
     // set the highlighted state
 	virtual void	setHighlighted(bool yes);
@@ -105,5 +111,5 @@ protected:
     // currently highlighted
    	bool	_highlighted;
     // private platform specific texture loading
-    ImTextureID _loadTextureFromMemory(const unsigned char *image_data, int image_width, int image_height);
+    static ImTextureID _loadTextureFromMemory(const unsigned char *image_data, int image_width, int image_height);
 };
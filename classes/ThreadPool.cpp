@@ -0,0 +1,177 @@
+#include "ThreadPool.h"
+#include <chrono>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace{
+
+// which pool and deque the current thread works for, -1 outside any pool
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local int currentIndex = -1;
+
+// how long a waiting TaskGroup sleeps before looking for queued work again
+constexpr auto HELP_POLL = std::chrono::microseconds(200);
+
+}
+
+
+
+ThreadPool::ThreadPool(const int workers, const bool pinCores){
+    const int count = workers > 0 ? workers : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    for(int i = 0; i < count; ++i) _queues.push_back(std::make_unique<Queue>());
+    for(int i = 0; i < count; ++i) _threads.emplace_back(&ThreadPool::workerLoop, this, i, pinCores);
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stop = true;
+    }
+    _sleepCv.notify_all();
+    for(auto& t : _threads) t.join();
+}
+
+ThreadPool& ThreadPool::shared(){
+    static ThreadPool pool;
+    return pool;
+}
+
+
+int ThreadPool::currentWorker() const{
+    return currentPool == this ? currentIndex : -1;
+}
+
+void ThreadPool::post(Task task){
+    const int self = currentWorker();
+    const size_t target = self >= 0 ? static_cast<size_t>(self) : _nextQueue++ % _queues.size();
+    {
+        // counted before it can be popped, a thief's decrement must never come first and wrap the counter
+        std::lock_guard<std::mutex> lock(_queues[target]->mutex);
+        ++_pending;
+        _queues[target]->tasks.push_back(std::move(task));
+    }
+
+    // taking the lock orders the increment against a worker that is just about to sleep
+    { std::lock_guard<std::mutex> lock(_sleepMutex); }
+    _sleepCv.notify_one();
+}
+
+bool ThreadPool::popOrSteal(const int self, Task& task){
+    if(self >= 0){
+        Queue& own = *_queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if(!own.tasks.empty()){
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --_pending;
+            return true;
+        }
+    }
+
+    const size_t count = _queues.size();
+    const size_t start = self >= 0 ? static_cast<size_t>(self) + 1 : 0;
+    for(size_t k = 0; k < count; ++k){
+        Queue& victim = *_queues[(start + k) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        --_pending;
+        return true;
+    }
+    return false;
+}
+
+bool ThreadPool::runPending(){
+    Task task;
+    if(!popOrSteal(currentWorker(), task)) return false;
+    task();
+    return true;
+}
+
+
+void ThreadPool::workerLoop(const int index, const bool pinCore){
+    currentPool = this;
+    currentIndex = index;
+
+#ifdef __linux__
+    if(pinCore){
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(index % std::max(1u, std::thread::hardware_concurrency()), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+
+    while(true){
+        Task task;
+        if(popOrSteal(index, task)){
+            task();
+            continue;
+        }
+
+        // queued work is finished before the pool shuts down
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _sleepCv.wait(lock, [this]{ return _stop || _pending > 0; });
+        if(_stop && _pending == 0) return;
+    }
+}
+
+
+
+TaskGroup::TaskGroup(ThreadPool& pool) : _pool(pool) {}
+
+TaskGroup::~TaskGroup(){
+    try{ wait(); }catch(...){}
+}
+
+void TaskGroup::run(ThreadPool::Task task){
+    {
+        std::lock_guard<std::mutex> lock(_doneMutex);
+        ++_pending;
+    }
+
+    _pool.post([this, task = std::move(task)]() mutable {
+        if(!_cancelled){
+            try{
+                task();
+            }catch(...){
+                std::lock_guard<std::mutex> lock(_doneMutex);
+                if(!_error) _error = std::current_exception();
+                _cancelled = true;
+            }
+        }
+        task = nullptr;     // release the captures before wait() can return
+        finish();
+    });
+}
+
+void TaskGroup::finish(){
+    // decrement and notify under the lock: wait() can only return (and destroy the group) after we let go
+    std::lock_guard<std::mutex> lock(_doneMutex);
+    if(--_pending == 0) _doneCv.notify_all();
+}
+
+void TaskGroup::wait(){
+    while(true){
+        {
+            std::lock_guard<std::mutex> lock(_doneMutex);
+            if(_pending == 0) break;
+        }
+        if(_pool.runPending()) continue;
+
+        std::unique_lock<std::mutex> lock(_doneMutex);
+        _doneCv.wait_for(lock, HELP_POLL, [this]{ return _pending == 0; });
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(_doneMutex);
+        std::swap(error, _error);
+    }
+    if(error) std::rethrow_exception(error);
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// work-stealing task pool shared by the searches, self-play and the batch tools
+// every worker owns a deque: it pushes and pops its own tasks at the back (newest first, data still in cache)
+// and steals from the front of the others (oldest first, usually the biggest pieces of work).
+// tasks posted from outside the pool are dealt round robin. a thread waiting in TaskGroup::wait() runs
+// queued tasks instead of blocking, so fork/join can nest without running out of workers
+class ThreadPool{
+
+public:
+
+    using Task = std::function<void()>;
+
+    // workers = 0 starts one per hardware thread. pinCores binds worker i to core i (Linux, ignored elsewhere)
+    explicit ThreadPool(const int workers = 0, const bool pinCores = false);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // the process wide pool, one worker per hardware thread, started on first use
+    static ThreadPool& shared();
+
+    int     workers() const { return static_cast<int>(_threads.size()); }
+
+    // fire and forget, the task must not throw
+    void    post(Task task);
+    // the future carries the result or the exception
+    template <class F>
+    auto    submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>>;
+    // fn(i) for every i in [0, count), the calling thread works along and returns once all are done.
+    // no new indices are handed out once *cancel is set or fn throws (the exception is rethrown here)
+    template <class F>
+    void    parallelFor(const size_t count, F&& fn, const std::atomic<bool>* cancel = nullptr);
+
+    // runs one queued task on the calling thread, false if there was none
+    bool    runPending();
+
+private:
+
+    struct Queue{
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void    workerLoop(const int index, const bool pinCore);
+    bool    popOrSteal(const int self, Task& task);
+    int     currentWorker() const;
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::atomic<size_t> _pending{0};
+    std::atomic<size_t> _nextQueue{0};
+
+    std::mutex _sleepMutex;
+    std::condition_variable _sleepCv;
+    bool _stop = false;
+};
+
+
+// fork/join on a pool: run() forks, wait() joins and helps with queued work meanwhile
+// cancel() drops tasks that have not started, running ones can poll cancelled() (or hand cancelFlag()
+// to Connect4Engine::setStopFlag). the first exception of a task cancels the group and is rethrown by wait()
+class TaskGroup{
+
+public:
+
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::shared());
+    // waits for the tasks still running, swallows their exceptions
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void    run(ThreadPool::Task task);
+    void    wait();
+    void    cancel() { _cancelled = true; }
+    bool    cancelled() const { return _cancelled; }
+    const std::atomic<bool>* cancelFlag() const { return &_cancelled; }
+
+private:
+
+    void    finish();
+
+    ThreadPool& _pool;
+    std::atomic<bool> _cancelled{false};
+    size_t _pending = 0;            // guarded by _doneMutex
+    std::mutex _doneMutex;
+    std::condition_variable _doneCv;
+    std::exception_ptr _error;      // guarded by _doneMutex
+};
+
+#include "ThreadPool.tpp"
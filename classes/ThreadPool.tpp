@@ -0,0 +1,45 @@
+#pragma once
+#include <algorithm>
+
+
+
+template <class F>
+auto ThreadPool::submit(F&& f) -> std::future<std::invoke_result_t<std::decay_t<F>>>{
+    using Result = std::invoke_result_t<std::decay_t<F>>;
+
+    // std::function needs a copyable target, the packaged task is not
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(f));
+    std::future<Result> future = task->get_future();
+    post([task]{ (*task)(); });
+    return future;
+}
+
+template <class F>
+void ThreadPool::parallelFor(const size_t count, F&& fn, const std::atomic<bool>* cancel){
+    std::atomic<size_t> next{0};
+    auto body = [&]{
+        for(size_t i = next++; i < count; i = next++){
+            if(cancel && cancel->load(std::memory_order_relaxed)) return;
+            try{
+                fn(i);
+            }catch(...){
+                // whichever thread threw, nobody takes another index. a helper's exception comes back from wait()
+                next = count;
+                throw;
+            }
+        }
+    };
+
+    TaskGroup group(*this);
+    const size_t helpers = std::min<size_t>(count, static_cast<size_t>(workers()));
+    for(size_t h = 1; h < helpers; ++h) group.run(body);
+
+    try{
+        body();
+    }catch(...){
+        // the helpers still use next and fn
+        try{ group.wait(); }catch(...){}
+        throw;
+    }
+    group.wait();
+}
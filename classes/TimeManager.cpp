@@ -0,0 +1,80 @@
+#include "TimeManager.h"
+#include <algorithm>
+
+
+
+TimeManager::TimeManager(){
+    newGame(0, 0);
+}
+
+
+void TimeManager::newGame(const double totalMs, const double incrementMs){
+    _totalMs = totalMs;
+    _incrementMs = incrementMs;
+    _remainingMs = totalMs;
+
+    _allocatedMs = 0;
+    _softMs = 0;
+    _hardMs = 0;
+
+    _hasPrevious = false;
+    _previousScore = 0;
+    _previousMove = -1;
+    _stableIterations = 0;
+    _extended = false;
+}
+
+
+void TimeManager::startMove(const int moveNumber, const int legalMoves, const int movesLeft){
+    _hasPrevious = false;
+    _stableIterations = 0;
+    _extended = false;
+
+    const double usable = std::max(0.0, _remainingMs - SAFETY_MS);
+
+    // spread the clock over the moves that are left, the increment comes back every move
+    const double base = usable / std::max(1, movesLeft) + _incrementMs * 0.8;
+
+    // the middle game decides connect4 (the depth table peaks around move 9-10),
+    // so the first and last moves get less than their share
+    const double phase = moveNumber < 3 ? 0.6 : (moveNumber < 14 ? 1.3 : 0.8);
+
+    // fewer legal moves, smaller tree
+    const double branching = legalMoves <= 1 ? 0.05 : 0.5 + 0.5 * legalMoves / 7.0;
+
+    const double maxShare = usable * MAX_CLOCK_SHARE;
+
+    _softMs = std::min(base * phase * branching, maxShare);
+    _hardMs = std::min(_softMs * HARD_FACTOR, maxShare);
+    _allocatedMs = _softMs;
+}
+
+
+bool TimeManager::iterationDone(const double elapsedMs, const int score, const int bestMove){
+    if(_hasPrevious){
+        // the best line got worse: think longer before committing to it
+        if(score < _previousScore - SCORE_DROP){
+            _softMs = std::min(_softMs * SCORE_DROP_EXTEND, _hardMs);
+            _extended = true;
+            _stableIterations = 0;
+        }else if(bestMove == _previousMove){
+            ++_stableIterations;
+        }else{
+            _stableIterations = 0;
+        }
+    }
+
+    _hasPrevious = true;
+    _previousScore = score;
+    _previousMove = bestMove;
+
+    const double scale = _stableIterations >= STABLE_ITERATIONS ? STABLE_SCALE : 1.0;
+
+    // the next iteration costs several times the ones before it, don't start what can't finish
+    return elapsedMs < _softMs * scale * 0.5;
+}
+
+
+void TimeManager::endMove(const double usedMs){
+    _remainingMs = std::max(0.0, _remainingMs - usedMs) + _incrementMs;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// whole-game clock for one AI player: total time plus a per-move increment
+// startMove() allocates a soft and a hard budget for the coming move,
+// iterationDone() decides after every finished iterative deepening pass whether
+// to start another one, endMove() charges the clock
+class TimeManager{
+
+public:
+
+    static constexpr double SAFETY_MS = 20.0;           // never plan to use the last few ms
+    static constexpr double HARD_FACTOR = 4.0;          // hard limit = soft limit * 4 (capped by the clock)
+    static constexpr double MAX_CLOCK_SHARE = 0.5;      // a single move never takes more than half the clock
+    static constexpr double SCORE_DROP_EXTEND = 1.5;    // soft limit multiplier when the score falls
+    static constexpr int    SCORE_DROP = 20;            // eval units counted as a drop between iterations
+    static constexpr int    STABLE_ITERATIONS = 3;      // same best move this often -> stop early
+    static constexpr double STABLE_SCALE = 0.6;
+
+    TimeManager();
+
+    void    newGame(const double totalMs, const double incrementMs);
+    bool    enabled() const { return _totalMs > 0; }
+
+    // moveNumber counts this player's moves from 0, movesLeft is the most moves this player can still make
+    void    startMove(const int moveNumber, const int legalMoves, const int movesLeft);
+    // returns true if another iteration should be started
+    bool    iterationDone(const double elapsedMs, const int score, const int bestMove);
+    void    endMove(const double usedMs);
+
+    double  softLimitMs() const { return _softMs; }
+    double  hardLimitMs() const { return _hardMs; }
+    double  allocatedMs() const { return _allocatedMs; }
+    double  remainingMs() const { return _remainingMs; }
+    bool    extended() const { return _extended; }
+
+private:
+
+    double  _totalMs;
+    double  _incrementMs;
+    double  _remainingMs;
+
+    double  _allocatedMs;   // initial soft budget of the current move
+    double  _softMs;
+    double  _hardMs;
+
+    bool    _hasPrevious;
+    int     _previousScore;
+    int     _previousMove;
+    int     _stableIterations;
+    bool    _extended;
+};
@@ -0,0 +1,181 @@
+#include "Connect4Reference.h"
+#include <algorithm>
+#include <bit>
+
+namespace{
+
+constexpr std::array<uint64_t, 69> referenceWinningPatterns(){
+        std::array<uint64_t, 69> winningPatterns{};
+        //horizontal _
+        winningPatterns[0] = (0b1111000000000000000000000000000000000000000000000000000000000000);
+
+        for(int i = 1; i < 4*6;++i)
+            winningPatterns[i] = winningPatterns[i-1] >> (i%4 == 0? 4 :1);
+        //vertical |
+        winningPatterns[24] = (0b100000010000001000000100000000000000000000<<22);
+
+        for(int i = 25; i < 24+3*7; ++i)
+            winningPatterns[i] = winningPatterns[i-1] >> 1;
+
+        //diagonal /
+        winningPatterns[45] = (0b100000001000000010000000100000000000000000<<22);
+
+        for(int i = 46; i < 57; ++i)
+            winningPatterns[i] = winningPatterns[i-1] >> ((i == 49 || i == 53 )? 4 : 1);
+
+        winningPatterns[57] = (0b0001000001000001000001000000000000000000000000000000000000000000);
+
+        //diagonal '\'
+        for(int i = 58; i < 69; ++i)
+            winningPatterns[i] = winningPatterns[i-1] >> ((i == 61 || i == 65)?4 : 1);
+
+        return winningPatterns;
+}
+
+constexpr std::array<uint64_t, 19> referenceUtilPatterns(){
+    std::array<uint64_t, 19> utilPatterns{};
+
+    utilPatterns[0] = 0ULL;
+    utilPatterns[1] = 0b1111111111111111111111111111111111111111110000000000000000000000;
+    utilPatterns[2] = 0b1000000100000010000001000000100000010000000000000000000000000000;
+
+    for(int i = 3; i < 9; ++i)
+        utilPatterns[i] = utilPatterns[i-1] >> 1;
+
+    utilPatterns[9] = 0b1111111000000000000000000000000000000000000000000000000000000000;
+
+    for(int i = 10; i < 15; ++i)
+        utilPatterns[i] = utilPatterns[i-1] >> 7;
+
+    utilPatterns[15] = utilPatterns[2] | utilPatterns[3] | utilPatterns[4] | utilPatterns[5];
+    utilPatterns[16] = utilPatterns[9] | utilPatterns[10] | utilPatterns[11];
+    utilPatterns[17] = utilPatterns[15] & utilPatterns[16];
+    utilPatterns[18] = (utilPatterns[5] | utilPatterns[6] | utilPatterns[7] | utilPatterns[8]) & utilPatterns[16];
+
+    return utilPatterns;
+}
+
+constexpr std::array<uint64_t, 69> WINNING_PATTERNS = referenceWinningPatterns();
+constexpr std::array<uint64_t, 19> UTIL_PATTERNS = referenceUtilPatterns();
+constexpr std::array<uint8_t, 42> SORTED_CELL_VALUES = {24, 17, 23, 25, 16, 18, 31, 10, 22, 26, 30, 32, 9, 11, 15, 19, 38, 3, 29, 33, 8, 12, 21, 27, 37, 39, 2, 4, 14, 20, 28, 34, 36, 40, 1, 5, 7, 13, 35, 41, 0, 6};
+
+constexpr int FULL = 1;
+constexpr int HORIZONTAL_START = 15, VERTICAL_START = 16, DIAGONAL_LR_START = 17, DIAGONAL_RL_START = 18;
+
+}
+
+
+
+Connect4Reference::Connect4Reference(){
+    _board.pieces[RED] = 0;
+    _board.pieces[YELLOW] = 0;
+    _nodes = 0;
+}
+
+void Connect4Reference::setBoard(const uint64_t red, const uint64_t yellow){
+    _board.pieces[RED] = red;
+    _board.pieces[YELLOW] = yellow;
+    _nodes = 0;
+}
+
+
+std::array<int, 42> Connect4Reference::rootScores(const Color me, const int d){
+    std::array<int, 42> scores;
+    scores.fill(NO_MOVE);
+
+    for(int i = 0; i < 42; ++i){
+        if(!moveIsLegal((_board.pieces[RED] | _board.pieces[YELLOW]), i)) continue;
+
+        setBitInPlace(_board.pieces[me], i, true);
+        scores[i] = -negamax(static_cast<Color>(!me), -MATE, MATE, d);
+        setBitInPlace(_board.pieces[me], i, false);
+    }
+
+    return scores;
+}
+
+
+int Connect4Reference::negamax(const Color player, int a, const int b, const int d){
+    ++_nodes;
+
+    switch(comboWon(_board.pieces[player]) *1 + comboWon(_board.pieces[!player]) *2 + boardIsFull()*3){
+        case 1: return MATE/(d+1);
+        case 2: return -MATE*(d+1);
+        case 3: return 0;
+        case 4: return MATE/(d+1);
+        case 5: return -MATE*(d+1);
+    }
+
+    if(d <= 0){
+        return evalBoardState(_board, player);
+    }
+
+    int bestScore = -MATE;
+    int res = -MATE/10;
+
+    for(int i = 0; i < 42; ++i){
+        int bestMove = SORTED_CELL_VALUES[i];
+
+        if(!moveIsLegal(_board.pieces[RED] | _board.pieces[YELLOW], bestMove)) continue;
+        setBitInPlace(_board.pieces[player], bestMove, true);
+        res = -negamax(static_cast<Color>(!player), -b, -a, d-1);
+        setBitInPlace(_board.pieces[player], bestMove, false);
+
+        bestScore = std::max(bestScore, res);
+        a = std::max(a, res);
+
+        if(a >= b) return bestScore;
+    }
+
+    return bestScore;
+}
+
+
+int Connect4Reference::assessWinPattern(const Board& board, const Color color, const int patternIdx) const{
+    if((WINNING_PATTERNS[patternIdx] & board.pieces[!color]) != 0)
+        return 0;
+
+    int piecesMatched = std::popcount(board.pieces[color] & WINNING_PATTERNS[patternIdx]);
+
+    return piecesMatched == 4? MATE : 1 << piecesMatched;
+}
+
+int Connect4Reference::evalBoardState(const Board& board, const Color color) const{
+    int score = 0;
+    int oppScore = 0;
+
+    for(int i = 0; i < 69; ++i){
+        score += assessWinPattern(board, color, i);
+        oppScore += assessWinPattern(board, static_cast<Color>(!color), i);
+    }
+
+    return score - (oppScore/1.2);
+}
+
+
+bool Connect4Reference::boardIsFull() const{
+    return ((_board.pieces[RED] | _board.pieces[YELLOW]) == UTIL_PATTERNS[FULL]);
+}
+
+bool Connect4Reference::comboWon(const uint64_t piecies){
+    return
+    (piecies & (piecies << 1) & (piecies << 2) & (piecies << 3) & UTIL_PATTERNS[HORIZONTAL_START]) ||
+    (piecies & (piecies << 7) & (piecies << 14) & (piecies << 21) & UTIL_PATTERNS[VERTICAL_START]) ||
+    (piecies & (piecies << 8) & (piecies << 16) & (piecies << 24) & UTIL_PATTERNS[DIAGONAL_LR_START]) ||
+    (piecies & (piecies << 6) & (piecies << 12) & (piecies << 18) & UTIL_PATTERNS[DIAGONAL_RL_START]);
+}
+
+bool Connect4Reference::moveIsLegal(const uint64_t board, const int i){
+    return (getBit(board, i) == 0 && ( (i>=35) || ((getBit(board, i+7) == 1))));
+}
+
+
+void Connect4Reference::setBitInPlace(uint64_t& x, const unsigned int pos, const bool value){
+    const unsigned shift = 63 - pos;
+    const uint64_t mask = 1ULL << shift;
+    x = (x & ~mask) | (static_cast<uint64_t>(value) << shift);
+}
+
+int Connect4Reference::getBit(uint64_t x, const unsigned int pos){
+    return static_cast<int>((x >> (63 - pos)) & 1ULL);
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// frozen copy of the AI1 search as of the differential harness, kept as the
+// reference every Connect4Engine speedup is checked against
+// do not optimize this file, change Connect4Engine instead
+class Connect4Reference{
+
+public:
+
+    enum Color: bool{
+        RED = 0,
+        YELLOW = 1
+    };
+
+    struct Board{
+        std::array<uint64_t, 2> pieces;
+    };
+
+    static constexpr int32_t MATE = 99999;
+
+    Connect4Reference();
+
+    void        setBoard(const uint64_t red, const uint64_t yellow);
+    uint64_t    nodes() const { return _nodes; }
+
+    // score of every root cell after a full window search, or NO_MOVE if the cell is not playable
+    std::array<int, 42> rootScores(const Color me, const int d);
+    static constexpr int NO_MOVE = -MATE*100;
+
+    int         negamax(const Color player, int a, const int b, const int d);
+
+    static bool comboWon(const uint64_t piecies);
+    static bool moveIsLegal(const uint64_t board, const int i);
+
+private:
+
+    int         assessWinPattern(const Board& board, const Color color, const int patternIdx) const;
+    int         evalBoardState(const Board& board, const Color color) const;
+    bool        boardIsFull() const;
+
+    static void setBitInPlace(uint64_t& x, const unsigned int pos, const bool value);
+    static int  getBit(uint64_t x, const unsigned int pos);
+
+    Board _board;
+    uint64_t _nodes;
+};
@@ -0,0 +1,122 @@
+#include "OthelloReference.h"
+
+// N, NE, E, SE, S, SW, W, NW
+const int OthelloReference::DIRECTIONS[8][2] = {
+    {0, -1}, {1, -1}, {1, 0}, {1, 1},
+    {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}
+};
+
+OthelloReference::OthelloReference(){
+    for(int y = 0; y < 8; y++)
+        for(int x = 0; x < 8; x++)
+            _cells[y][x] = EMPTY;
+
+    _cells[3][3] = WHITE;
+    _cells[4][4] = WHITE;
+    _cells[3][4] = BLACK;
+    _cells[4][3] = BLACK;
+}
+
+bool OthelloReference::setStateString(const std::string& s){
+    if(s.size() != 64) return false;
+    for(char c : s)
+        if(c < '0' || c > '2') return false;
+
+    for(int i = 0; i < 64; i++) _cells[i / 8][i % 8] = static_cast<int8_t>(s[i] - '0');
+    return true;
+}
+
+std::string OthelloReference::stateString() const{
+    std::string s(64, '0');
+    for(int i = 0; i < 64; i++) s[i] = static_cast<char>('0' + _cells[i / 8][i % 8]);
+    return s;
+}
+
+bool OthelloReference::isValidMove(const int x, const int y, const int player) const{
+    if(!isValid(x, y) || _cells[y][x] != EMPTY) return false;
+
+    // Check if placing a piece here would flip at least one opponent piece
+    for(int i = 0; i < 8; i++){
+        if(checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player) > 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+int OthelloReference::checkDirection(const int x, const int y, const int dx, const int dy, const int player) const{
+    int count = 0;
+    int nx = x + dx;
+    int ny = y + dy;
+
+    if(!isValid(nx, ny)) return 0;
+
+    const int first = _cells[ny][nx];
+    if(first == EMPTY || first == player) return 0;
+
+    // Count opponent pieces in this direction
+    while(isValid(nx, ny)){
+        const int piece = _cells[ny][nx];
+        if(piece == EMPTY) return 0;
+        if(piece == player) return count;
+        count++;
+        nx += dx;
+        ny += dy;
+    }
+    return 0;
+}
+
+void OthelloReference::flipPieces(const int x, const int y, const int player){
+    for(int i = 0; i < 8; i++){
+        const int count = checkDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player);
+        if(count > 0){
+            flipInDirection(x, y, DIRECTIONS[i][0], DIRECTIONS[i][1], player, count);
+        }
+    }
+}
+
+void OthelloReference::flipInDirection(const int x, const int y, const int dx, const int dy, const int player, const int count){
+    int nx = x + dx;
+    int ny = y + dy;
+
+    for(int i = 0; i < count; i++){
+        _cells[ny][nx] = static_cast<int8_t>(player);
+        nx += dx;
+        ny += dy;
+    }
+}
+
+bool OthelloReference::hasValidMove(const int player) const{
+    for(int y = 0; y < 8; y++)
+        for(int x = 0; x < 8; x++)
+            if(isValidMove(x, y, player)) return true;
+    return false;
+}
+
+void OthelloReference::placeAndFlip(const int x, const int y, const int player){
+    _cells[y][x] = static_cast<int8_t>(player);
+    flipPieces(x, y, player);
+}
+
+uint64_t OthelloReference::perft(const int player, const int depth, uint64_t& nodes) const{
+    ++nodes;
+    if(depth == 0) return 1;
+
+    const int opponent = player == BLACK ? WHITE : BLACK;
+    uint64_t leaves = 0;
+    bool moved = false;
+    for(int y = 0; y < 8; y++){
+        for(int x = 0; x < 8; x++){
+            if(!isValidMove(x, y, player)) continue;
+            moved = true;
+            OthelloReference child = *this;
+            child.placeAndFlip(x, y, player);
+            leaves += child.perft(opponent, depth - 1, nodes);
+        }
+    }
+    if(moved) return leaves;
+
+    // pass, or the game is over when neither side can move
+    if(!hasValidMove(opponent)) return 1;
+    return perft(opponent, depth - 1, nodes);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// frozen copy of the square by square Othello move logic the game used before OthelloBoard (isValidMove walking
+// checkDirection over the 8 directions, flipPieces/flipInDirection), on a plain 8x8 array instead of the ImGui Grid.
+// kept as the reference OthelloBoard is checked and timed against
+// do not optimize this file, change OthelloBoard instead
+class OthelloReference{
+
+public:
+
+    // owners as in Othello::stateString(), a player is BLACK or WHITE
+    enum Cell: int8_t{
+        EMPTY = 0,
+        BLACK = 1,
+        WHITE = 2
+    };
+
+    OthelloReference();
+
+    bool            setStateString(const std::string& s);
+    std::string     stateString() const;
+
+    bool            isValidMove(const int x, const int y, const int player) const;
+    bool            hasValidMove(const int player) const;
+    // the old actionForEmptyHolder without the UI: place the disc, then flip
+    void            placeAndFlip(const int x, const int y, const int player);
+
+    // leaves at depth, a pass uses up a ply and a finished game counts as one leaf
+    uint64_t        perft(const int player, const int depth, uint64_t& nodes) const;
+
+private:
+
+    static const int DIRECTIONS[8][2];
+
+    static bool     isValid(const int x, const int y) { return x >= 0 && x < 8 && y >= 0 && y < 8; }
+    int             checkDirection(const int x, const int y, const int dx, const int dy, const int player) const;
+    void            flipPieces(const int x, const int y, const int player);
+    void            flipInDirection(const int x, const int y, const int dx, const int dy, const int player, const int count);
+
+    int8_t _cells[8][8];    // [y][x]
+};
@@ -0,0 +1,312 @@
+// differential test: Connect4Engine against the frozen Connect4Reference on random positions
+//
+//   connect4_diff [--positions N] [--depth D] [--seed S] [--solver] [--empties E] [--sizes] [--parallel]
+//
+// fixed depth mode compares the exact score of every root move at depth D,
+// solver mode fills the board up to E empty cells, searches to the end and compares win/draw/loss only
+// sizes mode plays random games on the 7x6, 8x7, 9x7 and 10x8 engines and checks the bitboard helpers
+// against a plain grid, and that a depth 2 search takes an immediate win whenever there is one
+// parallel mode checks that searchRoot on a ThreadPool picks the same move with the same score and node count as the
+// serial searchRoot (the pool itself is tested by thread_pool)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include "Connect4Reference.h"
+#include "../classes/Connect4Engine.h"
+
+namespace{
+
+struct Options{
+    int positions = 200;
+    int depth = 6;
+    unsigned seed = 1;
+    bool solver = false;
+    int empties = 12;
+    bool sizes = false;
+    bool parallel = false;
+};
+
+struct Position{
+    uint64_t red;
+    uint64_t yellow;
+    Connect4Engine::Color toMove;
+};
+
+int emptyCells(const Position& p){
+    return 42 - std::popcount(p.red | p.yellow);
+}
+
+// plays random legal moves until the position has the wanted number of empty cells,
+// returns false if someone won or the board filled up on the way
+bool randomPosition(std::mt19937& rng, const int empties, Position& out){
+    out = {0, 0, Connect4Engine::RED};
+
+    while(emptyCells(out) > empties){
+        const uint64_t occupied = out.red | out.yellow;
+        int cells[7];
+        int count = 0;
+        for(int col = 0; col < 7; ++col){
+            const int idx = Connect4Engine::landingCell(occupied, col);
+            if(idx >= 0) cells[count++] = idx;
+        }
+        if(count == 0) return false;
+
+        const int idx = cells[rng() % count];
+        uint64_t& pieces = out.toMove == Connect4Engine::RED ? out.red : out.yellow;
+        pieces |= Connect4Engine::cellMask(idx);
+        if(Connect4Engine::comboWon(pieces)) return false;
+
+        out.toMove = static_cast<Connect4Engine::Color>(!out.toMove);
+    }
+
+    return true;
+}
+
+std::array<int, 42> engineRootScores(Connect4Engine& engine, const Connect4Engine::Color me, const int d){
+    std::array<int, 42> scores;
+    scores.fill(Connect4Reference::NO_MOVE);
+
+    for(int i = 0; i < 42; ++i){
+        const uint64_t occupied = engine.board().pieces[Connect4Engine::RED] | engine.board().pieces[Connect4Engine::YELLOW];
+        if(!Connect4Engine::moveIsLegal(occupied, i)) continue;
+
+        engine.makeMove(me, i);
+        scores[i] = -engine.negamax(static_cast<Connect4Engine::Color>(!me), -Connect4Engine::MATE, Connect4Engine::MATE, d);
+        engine.unmakeMove(me, i);
+    }
+
+    return scores;
+}
+
+int outcome(const int score){
+    return (score > 0) - (score < 0);
+}
+
+
+// grid[y][x]: -1 empty, otherwise the color
+template <int W, int H>
+using Grid = std::array<std::array<int, W>, H>;
+
+template <int W, int H, int N>
+bool gridWon(const Grid<W, H>& grid, const int color){
+    constexpr int DX[4] = {1, 0, 1, -1};
+    constexpr int DY[4] = {0, 1, 1, 1};
+
+    for(int y = 0; y < H; ++y)
+        for(int x = 0; x < W; ++x)
+            for(int dir = 0; dir < 4; ++dir){
+                int k = 0;
+                while(k < N){
+                    const int cx = x + DX[dir]*k, cy = y + DY[dir]*k;
+                    if(cx < 0 || cx >= W || cy >= H || grid[cy][cx] != color) break;
+                    ++k;
+                }
+                if(k == N) return true;
+            }
+    return false;
+}
+
+// random games on a W x H board, returns false on the first disagreement with the grid
+template <int W, int H, int N>
+bool checkSize(std::mt19937& rng, const int games){
+    using Engine = BasicConnect4Engine<W, H, N>;
+    using BitBoard = typename Engine::BitBoard;
+    Engine engine;
+    int wins = 0;
+
+    for(int game = 0; game < games; ++game){
+        Grid<W, H> grid;
+        for(auto& row : grid) row.fill(-1);
+        std::array<BitBoard, 2> pieces{0, 0};
+        auto me = Engine::RED;
+
+        for(int ply = 0; ply < Engine::CELLS; ++ply){
+            const BitBoard occupied = pieces[0] | pieces[1];
+
+            // landing cell and legality of every column, and whether me can win right away
+            int winningCol = -1;
+            for(int col = 0; col < W; ++col){
+                int y = H - 1;
+                while(y >= 0 && grid[y][col] >= 0) --y;
+                const int expected = y < 0 ? -1 : y*W + col;
+
+                if(Engine::landingCell(occupied, col) != expected){
+                    std::printf("MISMATCH %dx%d game %d ply %d: landingCell(%d) = %d, grid %d\n", W, H, game, ply, col,
+                        Engine::landingCell(occupied, col), expected);
+                    return false;
+                }
+                for(int yy = 0; yy < H; ++yy)
+                    if(Engine::moveIsLegal(occupied, yy*W + col) != (yy == y)){
+                        std::printf("MISMATCH %dx%d game %d ply %d: moveIsLegal(%d)\n", W, H, game, ply, yy*W + col);
+                        return false;
+                    }
+
+                if(y < 0 || winningCol >= 0) continue;
+                grid[y][col] = me;
+                if(gridWon<W, H, N>(grid, me)) winningCol = col;
+                grid[y][col] = -1;
+            }
+
+            if(winningCol >= 0){
+                engine.setBoard(pieces[0], pieces[1]);
+                const auto result = engine.searchRoot(me, 2);
+                const int col = result.bestMoveIdx % W;
+                int y = H - 1;
+                while(grid[y][col] >= 0) --y;
+                grid[y][col] = me;
+                const bool won = gridWon<W, H, N>(grid, me);
+                grid[y][col] = -1;
+                if(!won){
+                    std::printf("MISMATCH %dx%d game %d ply %d: search played column %d, column %d wins\n", W, H, game, ply, col, winningCol);
+                    return false;
+                }
+                ++wins;
+            }
+
+            const int col = static_cast<int>(rng() % W);
+            const int idx = Engine::landingCell(occupied, col);
+            if(idx < 0){
+                --ply;
+                continue;
+            }
+            grid[idx / W][idx % W] = me;
+            pieces[me] |= Engine::cellMask(idx);
+
+            const bool won = gridWon<W, H, N>(grid, me);
+            const int winner = Engine::winner({pieces});
+            if(Engine::comboWon(pieces[me]) != won || (won && winner != me) || (!won && winner >= 0)){
+                std::printf("MISMATCH %dx%d game %d ply %d: comboWon %d winner %d, grid %d\n", W, H, game, ply,
+                    Engine::comboWon(pieces[me]), winner, won);
+                return false;
+            }
+            if(won) break;
+            if(Engine::boardIsFull({pieces}) != (ply == Engine::CELLS - 1)){
+                std::printf("MISMATCH %dx%d game %d ply %d: boardIsFull\n", W, H, game, ply);
+                return false;
+            }
+
+            me = static_cast<typename Engine::Color>(!me);
+        }
+    }
+
+    std::printf("%dx%d connect %d: %d games, %d immediate wins found, all match\n", W, H, N, games, wins);
+    return true;
+}
+
+bool checkParallel(std::mt19937& rng, const Options& opt){
+    ThreadPool pool(4);
+
+    Connect4Engine serial, parallel;
+    int tested = 0;
+    while(tested < opt.positions){
+        Position pos;
+        if(!randomPosition(rng, 2 + static_cast<int>(rng() % 39), pos)) continue;
+
+        serial.setBoard(pos.red, pos.yellow);
+        parallel.setBoard(pos.red, pos.yellow);
+        const auto expected = serial.searchRoot(pos.toMove, opt.depth);
+        const auto actual = parallel.searchRoot(pos.toMove, opt.depth, pool);
+
+        if(expected.bestMoveIdx != actual.bestMoveIdx || expected.bestScore != actual.bestScore || serial.nodes() != parallel.nodes()){
+            std::printf("MISMATCH position %d red=%016llx yellow=%016llx toMove=%d depth=%d serial=%d/%d/%llu parallel=%d/%d/%llu\n",
+                tested, static_cast<unsigned long long>(pos.red), static_cast<unsigned long long>(pos.yellow),
+                static_cast<int>(pos.toMove), opt.depth, expected.bestMoveIdx, expected.bestScore,
+                static_cast<unsigned long long>(serial.nodes()), actual.bestMoveIdx, actual.bestScore,
+                static_cast<unsigned long long>(parallel.nodes()));
+            return false;
+        }
+        ++tested;
+    }
+
+    std::printf("%d positions, %d workers, parallel root search matches the serial one\n", tested, pool.workers());
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& opt){
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--positions") && hasValue) opt.positions = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--depth") && hasValue) opt.depth = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--seed") && hasValue) opt.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if(!std::strcmp(argv[i], "--empties") && hasValue) opt.empties = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--solver")) opt.solver = true;
+        else if(!std::strcmp(argv[i], "--sizes")) opt.sizes = true;
+        else if(!std::strcmp(argv[i], "--parallel")) opt.parallel = true;
+        else{
+            std::fprintf(stderr, "usage: %s [--positions N] [--depth D] [--seed S] [--solver] [--empties E] [--sizes] [--parallel]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    Options opt;
+    if(!parseOptions(argc, argv, opt)) return 2;
+
+    std::mt19937 rng(opt.seed);
+    if(opt.sizes){
+        const bool ok = checkSize<7, 6, 4>(rng, opt.positions) && checkSize<8, 7, 4>(rng, opt.positions) &&
+                        checkSize<9, 7, 4>(rng, opt.positions) && checkSize<10, 8, 4>(rng, opt.positions);
+        return ok ? 0 : 1;
+    }
+    if(opt.parallel) return checkParallel(rng, opt) ? 0 : 1;
+
+    Connect4Reference reference;
+    Connect4Engine engine;
+
+    uint64_t referenceNodes = 0, engineNodes = 0;
+    double referenceMs = 0, engineMs = 0;
+    int tested = 0;
+
+    while(tested < opt.positions){
+        // fixed depth mode samples the whole game, solver mode only the last few plies
+        const int empties = opt.solver ? opt.empties : 2 + static_cast<int>(rng() % 39);
+        Position pos;
+        if(!randomPosition(rng, empties, pos)) continue;
+
+        const int depth = opt.solver ? emptyCells(pos) : opt.depth;
+
+        reference.setBoard(pos.red, pos.yellow);
+        auto t0 = std::chrono::steady_clock::now();
+        const auto expected = reference.rootScores(static_cast<Connect4Reference::Color>(pos.toMove), depth);
+        auto t1 = std::chrono::steady_clock::now();
+
+        engine.setBoard(pos.red, pos.yellow);
+        const auto actual = engineRootScores(engine, pos.toMove, depth);
+        auto t2 = std::chrono::steady_clock::now();
+
+        referenceMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        engineMs += std::chrono::duration<double, std::milli>(t2 - t1).count();
+        referenceNodes += reference.nodes();
+        engineNodes += engine.nodes();
+
+        for(int i = 0; i < 42; ++i){
+            const bool same = opt.solver ? outcome(expected[i]) == outcome(actual[i]) : expected[i] == actual[i];
+            if(same) continue;
+
+            std::printf("MISMATCH position %d red=%016llx yellow=%016llx toMove=%d depth=%d cell=%d reference=%d engine=%d\n",
+                tested, static_cast<unsigned long long>(pos.red), static_cast<unsigned long long>(pos.yellow),
+                static_cast<int>(pos.toMove), depth, i, expected[i], actual[i]);
+            return 1;
+        }
+
+        ++tested;
+    }
+
+    std::printf("%d positions, %s, all root scores match\n", tested, opt.solver ? "solver mode" : "fixed depth");
+    std::printf("nodes  reference %llu engine %llu ratio %.3f\n",
+        static_cast<unsigned long long>(referenceNodes), static_cast<unsigned long long>(engineNodes),
+        referenceNodes ? static_cast<double>(engineNodes) / referenceNodes : 0.0);
+    std::printf("time   reference %.1fms engine %.1fms ratio %.3f\n",
+        referenceMs, engineMs, referenceMs > 0 ? engineMs / referenceMs : 0.0);
+
+    return 0;
+}
@@ -0,0 +1,174 @@
+// Connect4NNUE kernel and accumulator check on seeded random weights
+//
+//   connect4_nnue [--games N] [--seed S] [--weights path]
+//
+// writes a random weight file, loads it and plays N random move sequences with every kernel the CPU supports.
+// in every position the incrementally updated accumulators have to equal a refresh() from scratch, and taking
+// the moves back one by one has to give back the accumulators seen on the way in. the evaluations and
+// accumulators of every kernel have to match the scalar ones position by position.
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../classes/Connect4NNUE.h"
+
+namespace{
+
+using Kernel = Connect4NNUE::Kernel;
+using Accumulator = std::array<int16_t, Connect4NNUE::ACC_SIZE>;
+
+constexpr int WIDTH = 7;
+constexpr int HEIGHT = 6;
+
+// what one kernel saw in one position
+struct Snapshot{
+    std::array<Accumulator, 2> acc;
+    std::array<int, 2> eval;
+
+    bool operator==(const Snapshot& other) const { return acc == other.acc && eval == other.eval; }
+};
+
+template <class T>
+void writeRandom(std::ofstream& out, std::mt19937& rng, const size_t count, const int lo, const int hi){
+    std::uniform_int_distribution<int> dist(lo, hi);
+    for(size_t i = 0; i < count; ++i){
+        const T value = static_cast<T>(dist(rng));
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+}
+
+// the layout loadWeights() reads, small first layer weights so a good part of the accumulator stays inside 0..ACT_MAX
+bool writeWeights(const std::string& path, const unsigned seed){
+    using N = Connect4NNUE;
+    std::mt19937 rng(seed);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(N::FILE_MAGIC, sizeof(N::FILE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&N::FILE_VERSION), sizeof(N::FILE_VERSION));
+    writeRandom<int16_t>(out, rng, N::ACC_SIZE, -64, 64);
+    writeRandom<int16_t>(out, rng, N::INPUTS * N::ACC_SIZE, -32, 32);
+    writeRandom<int32_t>(out, rng, N::L1_SIZE, -2000, 2000);
+    writeRandom<int8_t>(out, rng, N::L1_SIZE * 2 * N::ACC_SIZE, -128, 127);
+    writeRandom<int32_t>(out, rng, N::L2_SIZE, -2000, 2000);
+    writeRandom<int8_t>(out, rng, N::L2_SIZE * N::L1_SIZE, -128, 127);
+    writeRandom<int32_t>(out, rng, 1, -2000, 2000);
+    writeRandom<int8_t>(out, rng, N::L2_SIZE, -128, 127);
+    return static_cast<bool>(out);
+}
+
+Snapshot snapshot(const Connect4NNUE& net){
+    return {{net.accumulator(0), net.accumulator(1)}, {net.evaluate(0), net.evaluate(1)}};
+}
+
+// cell bits as refresh() reads them, 0 = MSB
+uint64_t cellBit(const int cell){
+    return 1ULL << (63 - cell);
+}
+
+// one pass over the same seeded games with the current kernel, every position's snapshot appended to seen
+bool runGames(const Connect4NNUE& loaded, const int games, const unsigned seed, std::vector<Snapshot>& seen){
+    std::mt19937 rng(seed);
+    const char* kernel = Connect4NNUE::kernelName(Connect4NNUE::kernel());
+
+    for(int g = 0; g < games; ++g){
+        Connect4NNUE net = loaded;
+        net.refresh(0, 0);
+        std::array<uint64_t, 2> pieces{0, 0};
+        std::array<int, WIDTH> heights{};
+        std::vector<int> cells;
+        std::vector<Snapshot> path{snapshot(net)};
+
+        // a random number of random legal drops, up to a full board
+        const int length = static_cast<int>(rng() % (WIDTH * HEIGHT + 1));
+        for(int ply = 0; ply < length; ++ply){
+            int column = static_cast<int>(rng() % WIDTH);
+            while(heights[column] == HEIGHT) column = (column + 1) % WIDTH;
+            const int cell = (HEIGHT - 1 - heights[column]++) * WIDTH + column;
+            const int color = ply % 2;
+
+            net.addPiece(color, cell);
+            pieces[color] |= cellBit(cell);
+            cells.push_back(cell);
+
+            Connect4NNUE fresh = loaded;
+            fresh.refresh(pieces[0], pieces[1]);
+            const Snapshot incremental = snapshot(net);
+            if(!(incremental == snapshot(fresh))){
+                std::printf("MISMATCH %s kernel: game %d ply %d, incremental update differs from refresh\n", kernel, g, ply + 1);
+                return false;
+            }
+            path.push_back(incremental);
+            seen.push_back(incremental);
+        }
+
+        for(int ply = static_cast<int>(cells.size()) - 1; ply >= 0; --ply){
+            net.removePiece(ply % 2, cells[ply]);
+            if(!(snapshot(net) == path[ply])){
+                std::printf("MISMATCH %s kernel: game %d, taking back ply %d does not restore the accumulator\n", kernel, g, ply + 1);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    int games = 200;
+    unsigned seed = 1;
+    std::string weights = "connect4_nnue_test.nnue";
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--games") && hasValue) games = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--seed") && hasValue) seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if(!std::strcmp(argv[i], "--weights") && hasValue) weights = argv[++i];
+        else{
+            std::fprintf(stderr, "usage: %s [--games N] [--seed S] [--weights path]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    Connect4NNUE net;
+    std::string error;
+    if(!writeWeights(weights, seed) || !net.loadWeights(weights, &error)){
+        std::printf("CHECK FAILED: random weights: %s\n", error.empty() ? ("could not write " + weights).c_str() : error.c_str());
+        return 1;
+    }
+    const Kernel selected = Connect4NNUE::kernel();
+    std::printf("evaluate() uses %s\n", Connect4NNUE::kernelName(selected));
+
+    std::vector<Snapshot> reference;
+    for(const Kernel kernel : {Kernel::SCALAR, Kernel::AVX2}){
+        if(!Connect4NNUE::setKernel(kernel)){
+            std::printf("%-6s not supported, skipped\n", Connect4NNUE::kernelName(kernel));
+            continue;
+        }
+
+        std::vector<Snapshot> seen;
+        if(!runGames(net, games, seed, seen)) return 1;
+        std::printf("%-6s %d games, %zu positions: incremental = refresh, take backs restore the accumulator\n",
+            Connect4NNUE::kernelName(kernel), games, seen.size());
+
+        if(reference.empty()){
+            reference = std::move(seen);
+            continue;
+        }
+        for(size_t i = 0; i < seen.size(); ++i){
+            if(seen[i] == reference[i]) continue;
+            std::printf("MISMATCH %s kernel: position %zu evaluates %d/%d, scalar %d/%d\n", Connect4NNUE::kernelName(kernel), i,
+                seen[i].eval[0], seen[i].eval[1], reference[i].eval[0], reference[i].eval[1]);
+            return 1;
+        }
+        std::printf("%-6s matches scalar in every position\n", Connect4NNUE::kernelName(kernel));
+    }
+
+    Connect4NNUE::setKernel(selected);
+    return 0;
+}
@@ -0,0 +1,189 @@
+// OthelloEngine against plain minimax, and its stable discs against the rest of the game
+//
+//   othello_engine [--endgames N] [--midgames N] [--depth D] [--playouts N] [--seed S]
+//
+// endgames: random positions with 6-10 empty squares solved by search() (the exact solver) and by negamax() down
+// to the end of the game (the midgame search with its table), both have to give the minimax result.
+// midgames: random positions with 20-40 empties searched to depth D by negamax() on a cleared table and by
+// search()'s iterative deepening, both have to give the score of a minimax without pruning or table.
+// playouts: random games where every disc stableDiscs() reports has to keep its colour until the game ends.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "../classes/OthelloEngine.h"
+
+namespace{
+
+struct Options{
+    int endgames = 300;
+    int midgames = 100;
+    int depth = 4;
+    int playouts = 6000;
+    unsigned seed = 1;
+};
+
+struct Position{
+    uint64_t me;
+    uint64_t opp;
+};
+
+void play(uint64_t& me, uint64_t& opp, const int sq){
+    const uint64_t flipped = OthelloBoard::flips(me, opp, sq);
+    const uint64_t next = opp & ~flipped;
+    opp = me | flipped | OthelloBoard::squareMask(sq);
+    me = next;
+}
+
+int randomMove(std::mt19937& rng, uint64_t moves){
+    for(int skip = static_cast<int>(rng() % std::popcount(moves)); skip > 0; --skip) moves &= moves - 1;
+    return std::countr_zero(moves);
+}
+
+// a random game stopped at the given number of empties with a move for the side to move, false if it ended first
+bool randomPosition(std::mt19937& rng, const int empties, Position& pos){
+    uint64_t me = OthelloBoard::START_BLACK, opp = OthelloBoard::START_WHITE;
+    while(64 - std::popcount(me | opp) > empties){
+        const uint64_t moves = OthelloBoard::legalMoves(me, opp);
+        if(moves) play(me, opp, randomMove(rng, moves));
+        else if(OthelloBoard::legalMoves(opp, me)) std::swap(me, opp);
+        else return false;
+    }
+    pos = {me, opp};
+    return OthelloBoard::legalMoves(me, opp) != 0;
+}
+
+// every line, no pruning, no table. same rules as OthelloEngine::negamax: a pass does not use up depth
+int minimax(const uint64_t me, const uint64_t opp, const int depth, const bool passed = false){
+    uint64_t moves = OthelloBoard::legalMoves(me, opp);
+    if(!moves){
+        if(passed) return OthelloEngine::gameScore(OthelloEngine::finalDiscDiff(me, opp));
+        return -minimax(opp, me, depth, true);
+    }
+    if(depth <= 0) return OthelloEngine::evaluate(me, opp);
+
+    int best = -OthelloEngine::INF_SCORE;
+    for(; moves; moves &= moves - 1){
+        uint64_t m = me, o = opp;
+        play(m, o, std::countr_zero(moves));
+        best = std::max(best, -minimax(m, o, depth - 1));
+    }
+    return best;
+}
+
+bool checkEndgames(std::mt19937& rng, const Options& opt){
+    OthelloEngine engine;
+    int tested = 0;
+    while(tested < opt.endgames){
+        Position pos;
+        const int empties = 6 + static_cast<int>(rng() % 5);
+        if(!randomPosition(rng, empties, pos)) continue;
+
+        const int expected = minimax(pos.me, pos.opp, empties);
+        const OthelloEngine::SearchResult solved = engine.search(OthelloBoard(pos.me, pos.opp), OthelloBoard::BLACK, empties);
+        engine.clearTable();
+        const int searched = engine.negamax(pos.me, pos.opp, -OthelloEngine::INF_SCORE, OthelloEngine::INF_SCORE, empties);
+
+        if(!solved.exact || solved.score != expected || searched != expected){
+            std::printf("MISMATCH endgame %s: minimax %d, search() %d%s, negamax() %d\n", OthelloBoard(pos.me, pos.opp).stateString().c_str(),
+                expected, solved.score, solved.exact ? "" : " (not exact)", searched);
+            return false;
+        }
+        ++tested;
+    }
+    std::printf("%d endgames with 6-10 empties: solver and midgame search give the minimax result\n", tested);
+    return true;
+}
+
+bool checkMidgames(std::mt19937& rng, const Options& opt){
+    OthelloEngine engine;
+    engine.setEndgameEmpties(0);
+    int tested = 0;
+    while(tested < opt.midgames){
+        Position pos;
+        if(!randomPosition(rng, 20 + static_cast<int>(rng() % 21), pos)) continue;
+
+        const int expected = minimax(pos.me, pos.opp, opt.depth);
+        engine.clearTable();
+        const int searched = engine.negamax(pos.me, pos.opp, -OthelloEngine::INF_SCORE, OthelloEngine::INF_SCORE, opt.depth);
+        const OthelloEngine::SearchResult deepened = engine.search(OthelloBoard(pos.me, pos.opp), OthelloBoard::BLACK, opt.depth);
+
+        if(searched != expected || deepened.score != expected || deepened.depth != opt.depth){
+            std::printf("MISMATCH midgame %s depth %d: minimax %d, negamax() %d, search() %d at depth %d\n",
+                OthelloBoard(pos.me, pos.opp).stateString().c_str(), opt.depth, expected, searched, deepened.score, deepened.depth);
+            return false;
+        }
+        ++tested;
+    }
+    std::printf("%d midgames with 20-40 empties at depth %d: search with the table gives the minimax score\n", tested, opt.depth);
+    return true;
+}
+
+bool checkStability(std::mt19937& rng, const Options& opt){
+    uint64_t stableSeen = 0;
+    for(int game = 0; game < opt.playouts; ++game){
+        // both colours' discs after every move, black first
+        std::vector<std::array<uint64_t, 2>> positions;
+        uint64_t me = OthelloBoard::START_BLACK, opp = OthelloBoard::START_WHITE;
+        bool blackToMove = true;
+        while(true){
+            positions.push_back(blackToMove ? std::array<uint64_t, 2>{me, opp} : std::array<uint64_t, 2>{opp, me});
+            const uint64_t moves = OthelloBoard::legalMoves(me, opp);
+            if(moves) play(me, opp, randomMove(rng, moves));
+            else if(!OthelloBoard::legalMoves(opp, me)) break;
+            else std::swap(me, opp);
+            blackToMove = !blackToMove;
+        }
+
+        for(size_t i = 0; i < positions.size(); ++i){
+            const std::array<uint64_t, 2> stable = {OthelloEngine::stableDiscs(positions[i][0], positions[i][1]),
+                                                    OthelloEngine::stableDiscs(positions[i][1], positions[i][0])};
+            stableSeen += std::popcount(stable[0] | stable[1]);
+            for(size_t j = i + 1; j < positions.size(); ++j){
+                if((positions[j][0] & stable[0]) == stable[0] && (positions[j][1] & stable[1]) == stable[1]) continue;
+                std::printf("MISMATCH playout %d: a stable disc of %s flipped %zu moves later\n", game,
+                    OthelloBoard(positions[i][0], positions[i][1]).stateString().c_str(), j - i);
+                return false;
+            }
+        }
+    }
+    std::printf("%d playouts: %llu stable discs reported, none of them flipped\n", opt.playouts,
+        static_cast<unsigned long long>(stableSeen));
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& opt){
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--endgames") && hasValue) opt.endgames = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--midgames") && hasValue) opt.midgames = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--depth") && hasValue) opt.depth = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--playouts") && hasValue) opt.playouts = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--seed") && hasValue) opt.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else return false;
+    }
+    return opt.depth >= 1;
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    Options opt;
+    if(!parseOptions(argc, argv, opt)){
+        std::fprintf(stderr, "usage: %s [--endgames N] [--midgames N] [--depth D] [--playouts N] [--seed S]\n", argv[0]);
+        return 2;
+    }
+
+    std::mt19937 rng(opt.seed);
+    if(!checkEndgames(rng, opt)) return 1;
+    if(!checkMidgames(rng, opt)) return 1;
+    if(!checkStability(rng, opt)) return 1;
+    return 0;
+}
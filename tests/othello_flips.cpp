@@ -0,0 +1,133 @@
+// flip kernel cross-check: OthelloBoard's scalar, AVX2 and BMI2 flips against each other and the frozen OthelloReference
+//
+//   othello_flips [--positions N] [--seed S]
+//
+// plays N seeded random games and, in every position reached, asks each kernel the CPU supports for the flips of
+// both colours on every empty square (illegal squares have to give 0). the reference places the disc and flips square
+// by square, its changed discs have to be the same set. then times every kernel on the legal moves it saw.
+
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "OthelloReference.h"
+#include "../classes/OthelloBoard.h"
+
+namespace{
+
+using Kernel = OthelloBoard::FlipKernel;
+using FlipFunction = uint64_t (*)(uint64_t, uint64_t, int);
+
+struct KernelInfo{
+    Kernel kernel;
+    FlipFunction flips;
+};
+
+constexpr KernelInfo KERNELS[] = {
+    {Kernel::SCALAR, &OthelloBoard::flipsScalar},
+    {Kernel::AVX2, &OthelloBoard::flipsAVX2},
+    {Kernel::BMI2, &OthelloBoard::flipsBMI2},
+};
+
+struct Move{
+    uint64_t me;
+    uint64_t opp;
+    int sq;
+};
+
+// the discs the reference turned, as a mask
+uint64_t referenceFlips(const OthelloBoard& board, const OthelloBoard::Color c, const int sq){
+    OthelloReference reference;
+    reference.setStateString(board.stateString());
+    const int player = c == OthelloBoard::BLACK ? OthelloReference::BLACK : OthelloReference::WHITE;
+    if(!reference.isValidMove(sq % 8, sq / 8, player)) return 0;
+    reference.placeAndFlip(sq % 8, sq / 8, player);
+
+    OthelloBoard after;
+    after.setStateString(reference.stateString());
+    return after.discs(c) & board.discs(static_cast<OthelloBoard::Color>(!c));
+}
+
+bool checkPosition(const OthelloBoard& board, const std::vector<KernelInfo>& kernels, std::vector<Move>& legal){
+    for(const OthelloBoard::Color c : {OthelloBoard::BLACK, OthelloBoard::WHITE}){
+        const uint64_t me = board.discs(c), opp = board.discs(static_cast<OthelloBoard::Color>(!c));
+        for(uint64_t empty = board.empties(); empty; empty &= empty - 1){
+            const int sq = std::countr_zero(empty);
+            const uint64_t expected = referenceFlips(board, c, sq);
+            for(const KernelInfo& k : kernels){
+                const uint64_t got = k.flips(me, opp, sq);
+                if(got != expected){
+                    std::printf("MISMATCH %s kernel: %s %c square %d flips %016llx, reference %016llx\n",
+                        OthelloBoard::kernelName(k.kernel), board.stateString().c_str(), c == OthelloBoard::BLACK ? 'b' : 'w', sq,
+                        static_cast<unsigned long long>(got), static_cast<unsigned long long>(expected));
+                    return false;
+                }
+            }
+            if(expected) legal.push_back({me, opp, sq});
+        }
+    }
+    return true;
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    int positions = 2000;
+    unsigned seed = 1;
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--positions") && hasValue) positions = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--seed") && hasValue) seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else{
+            std::fprintf(stderr, "usage: %s [--positions N] [--seed S]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<KernelInfo> kernels;
+    for(const KernelInfo& k : KERNELS){
+        const bool supported = OthelloBoard::kernelSupported(k.kernel);
+        std::printf("%-6s %s\n", OthelloBoard::kernelName(k.kernel), supported ? "supported" : "not supported, skipped");
+        if(supported) kernels.push_back(k);
+    }
+    std::printf("flips() uses %s\n", OthelloBoard::kernelName(OthelloBoard::flipKernel()));
+
+    // random games, every position on the way is checked
+    std::mt19937 rng(seed);
+    std::vector<Move> legal;
+    int checked = 0;
+    while(checked < positions){
+        OthelloBoard board;
+        OthelloBoard::Color toMove = OthelloBoard::BLACK;
+        while(checked < positions && !board.gameOver()){
+            if(!checkPosition(board, kernels, legal)) return 1;
+            ++checked;
+
+            uint64_t moves = board.legal(toMove);
+            if(moves){
+                for(int skip = static_cast<int>(rng() % std::popcount(moves)); skip > 0; --skip) moves &= moves - 1;
+                board.play(toMove, std::countr_zero(moves));
+            }
+            toMove = static_cast<OthelloBoard::Color>(!toMove);
+        }
+    }
+    std::printf("%d positions, %zu legal moves: all kernels agree with the reference\n", checked, legal.size());
+
+    for(const KernelInfo& k : kernels){
+        uint64_t sum = 0;
+        const int rounds = 20;
+        const auto t0 = std::chrono::steady_clock::now();
+        for(int r = 0; r < rounds; ++r)
+            for(const Move& m : legal) sum += k.flips(m.me, m.opp, m.sq);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::printf("%-6s %8.1fms %14.0f flips/s (checksum %016llx)\n", OthelloBoard::kernelName(k.kernel), ms,
+            ms > 0 ? rounds * legal.size() * 1000.0 / ms : 0.0, static_cast<unsigned long long>(sum));
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+// Othello perft: leaf counts of the full move tree to depth N, timed for OthelloBoard and the frozen OthelloReference
+//
+//   othello_perft [--depth N] [--state S] [--side b|w] [--reference-depth M] [--kernel scalar|avx2|bmi2]
+//
+// S is a 64 character Othello::stateString() (0 empty, 1 black, 2 white), the start position by default.
+// a pass uses up a ply and a finished game counts as one leaf, the usual convention of the published counts.
+// every depth up to N is counted by OthelloBoard, and up to M (default N, 0 skips it) also by the square by square
+// reference, with nodes/sec for both and the speedup. the counts have to agree with each other, and from the
+// start position with the known perft numbers. --kernel times a given flip kernel instead of the one picked at startup.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "OthelloReference.h"
+#include "../classes/OthelloBoard.h"
+
+namespace{
+
+// black to move from the start position, depth 0..11
+constexpr uint64_t KNOWN_PERFT[] = {1, 4, 12, 56, 244, 1396, 8200, 55092, 390216, 3005288, 24571284, 212258800};
+constexpr int KNOWN_DEPTHS = sizeof(KNOWN_PERFT) / sizeof(KNOWN_PERFT[0]);
+
+struct Options{
+    int depth = 8;
+    int referenceDepth = -1;
+    std::string state;
+    std::string kernel;
+    bool whiteToMove = false;
+};
+
+struct Count{
+    uint64_t leaves = 0;
+    uint64_t nodes = 0;
+    double ms = 0;
+};
+
+uint64_t perft(const uint64_t me, const uint64_t opp, const int depth, uint64_t& nodes){
+    ++nodes;
+    if(depth == 0) return 1;
+
+    uint64_t moves = OthelloBoard::legalMoves(me, opp);
+    if(!moves){
+        // pass, or the game is over when neither side can move
+        if(!OthelloBoard::legalMoves(opp, me)) return 1;
+        return perft(opp, me, depth - 1, nodes);
+    }
+
+    uint64_t leaves = 0;
+    for(; moves; moves &= moves - 1){
+        const int sq = std::countr_zero(moves);
+        const uint64_t flipped = OthelloBoard::flips(me, opp, sq);
+        leaves += perft(opp & ~flipped, me | flipped | OthelloBoard::squareMask(sq), depth - 1, nodes);
+    }
+    return leaves;
+}
+
+template <class F>
+Count timed(F&& count){
+    Count c;
+    const auto t0 = std::chrono::steady_clock::now();
+    c.leaves = count(c.nodes);
+    c.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return c;
+}
+
+double nodesPerSecond(const Count& c){
+    return c.ms > 0 ? c.nodes * 1000.0 / c.ms : 0.0;
+}
+
+bool parseOptions(int argc, char** argv, Options& opt){
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--depth") && hasValue) opt.depth = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--reference-depth") && hasValue) opt.referenceDepth = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--state") && hasValue) opt.state = argv[++i];
+        else if(!std::strcmp(argv[i], "--kernel") && hasValue) opt.kernel = argv[++i];
+        else if(!std::strcmp(argv[i], "--side") && hasValue){
+            const std::string side = argv[++i];
+            if(side != "b" && side != "w") return false;
+            opt.whiteToMove = side == "w";
+        }
+        else return false;
+    }
+    if(opt.referenceDepth < 0) opt.referenceDepth = opt.depth;
+    return opt.depth >= 0;
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    Options opt;
+    if(!parseOptions(argc, argv, opt)){
+        std::fprintf(stderr, "usage: %s [--depth N] [--state S] [--side b|w] [--reference-depth M] [--kernel scalar|avx2|bmi2]\n", argv[0]);
+        return 2;
+    }
+
+    if(!opt.kernel.empty()){
+        bool selected = false;
+        for(const auto kernel : {OthelloBoard::FlipKernel::SCALAR, OthelloBoard::FlipKernel::AVX2, OthelloBoard::FlipKernel::BMI2})
+            if(opt.kernel == OthelloBoard::kernelName(kernel)) selected = OthelloBoard::setFlipKernel(kernel);
+        if(!selected){
+            std::fprintf(stderr, "flip kernel %s is unknown or not supported by this CPU\n", opt.kernel.c_str());
+            return 2;
+        }
+    }
+
+    OthelloBoard board;
+    OthelloReference reference;
+    if(!opt.state.empty() && (!board.setStateString(opt.state) || !reference.setStateString(opt.state))){
+        std::fprintf(stderr, "bad state string: %s\n", opt.state.c_str());
+        return 2;
+    }
+    const bool startPosition = board.stateString() == OthelloBoard().stateString() && !opt.whiteToMove;
+
+    const OthelloBoard::Color toMove = opt.whiteToMove ? OthelloBoard::WHITE : OthelloBoard::BLACK;
+    const uint64_t me = board.discs(toMove), opp = board.discs(static_cast<OthelloBoard::Color>(!toMove));
+    const int referencePlayer = opt.whiteToMove ? OthelloReference::WHITE : OthelloReference::BLACK;
+
+    std::printf("%s %s to move, %s flips\n", board.stateString().c_str(), opt.whiteToMove ? "white" : "black",
+        OthelloBoard::kernelName(OthelloBoard::flipKernel()));
+    std::printf("depth %14s %12s %14s %12s %14s %8s\n", "leaves", "board ms", "nodes/s", "reference ms", "nodes/s", "speedup");
+
+    for(int depth = 1; depth <= opt.depth; ++depth){
+        const Count fast = timed([&](uint64_t& nodes){ return perft(me, opp, depth, nodes); });
+        std::printf("%5d %14llu %12.1f %14.0f", depth, static_cast<unsigned long long>(fast.leaves), fast.ms, nodesPerSecond(fast));
+
+        if(depth <= opt.referenceDepth){
+            const Count slow = timed([&](uint64_t& nodes){ return reference.perft(referencePlayer, depth, nodes); });
+            std::printf(" %12.1f %14.0f %7.1fx", slow.ms, nodesPerSecond(slow), fast.ms > 0 ? slow.ms / fast.ms : 0.0);
+            if(slow.leaves != fast.leaves || slow.nodes != fast.nodes){
+                std::printf("\nMISMATCH at depth %d: reference %llu leaves %llu nodes, board %llu leaves %llu nodes\n", depth,
+                    static_cast<unsigned long long>(slow.leaves), static_cast<unsigned long long>(slow.nodes),
+                    static_cast<unsigned long long>(fast.leaves), static_cast<unsigned long long>(fast.nodes));
+                return 1;
+            }
+        }
+        std::printf("\n");
+
+        if(startPosition && depth < KNOWN_DEPTHS && fast.leaves != KNOWN_PERFT[depth]){
+            std::printf("MISMATCH at depth %d: expected %llu\n", depth, static_cast<unsigned long long>(KNOWN_PERFT[depth]));
+            return 1;
+        }
+    }
+
+    if(startPosition) std::printf("start position counts match the known perft numbers up to depth %d\n", std::min(opt.depth, KNOWN_DEPTHS - 1));
+    return 0;
+}
@@ -0,0 +1,126 @@
+// ThreadPool and TaskGroup checks: nesting, cancellation, exceptions and submit
+//
+//   thread_pool [--workers N] [--rounds R]
+//
+// every check runs R times on a pool of N workers, timing dependent failures (a lost wakeup, a loop
+// index handed out twice) need a few goes to show up
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include "../classes/ThreadPool.h"
+
+namespace{
+
+bool checkNested(ThreadPool& pool){
+    // nested parallelFor: every worker can end up waiting on inner loops, waiting threads must run them
+    std::atomic<int> sum{0};
+    pool.parallelFor(64, [&](const size_t i){
+        pool.parallelFor(64, [&](const size_t j){ sum += static_cast<int>(i * j); });
+    });
+    if(sum != 63*64/2 * 63*64/2){
+        std::printf("CHECK FAILED: nested parallelFor sum %d\n", sum.load());
+        return false;
+    }
+    return true;
+}
+
+bool checkGroupException(ThreadPool& pool){
+    // the first exception comes back out of wait() and cancels the tasks that have not started
+    TaskGroup group(pool);
+    std::atomic<int> ran{0};
+    for(int i = 0; i < 1000; ++i)
+        group.run([&, i]{
+            if(i == 0) throw std::runtime_error("task failed");
+            ++ran;
+        });
+    bool caught = false;
+    try{ group.wait(); }catch(const std::runtime_error&){ caught = true; }
+    if(!caught || !group.cancelled()){
+        std::printf("CHECK FAILED: task group exception not propagated\n");
+        return false;
+    }
+    return true;
+}
+
+bool checkLoopException(ThreadPool& pool){
+    // a worker throws: the loop stops handing out indices on every thread and the exception reaches the caller.
+    // each thread may still finish the index it holds, nothing starts after that
+    constexpr size_t COUNT = 2000;
+    const std::thread::id caller = std::this_thread::get_id();
+    std::atomic<bool> thrown{false};
+    std::atomic<int> startedAfter{0};
+    bool caught = false;
+    try{
+        pool.parallelFor(COUNT, [&](const size_t){
+            if(thrown) ++startedAfter;
+            else if(std::this_thread::get_id() != caller && !thrown.exchange(true)) throw std::runtime_error("worker failed");
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        });
+    }catch(const std::runtime_error&){
+        caught = true;
+    }
+
+    if(!thrown){
+        std::printf("CHECK FAILED: no worker took part in the loop\n");
+        return false;
+    }
+    if(!caught || startedAfter > pool.workers()){
+        std::printf("CHECK FAILED: worker exception %s, %d indices started after it\n", caught ? "caught" : "lost", startedAfter.load());
+        return false;
+    }
+    return true;
+}
+
+bool checkCancel(ThreadPool& pool){
+    // a cancelled loop hands out no indices
+    std::atomic<bool> cancel{true};
+    std::atomic<int> ran{0};
+    pool.parallelFor(100, [&](const size_t){ ++ran; }, &cancel);
+    if(ran != 0){
+        std::printf("CHECK FAILED: cancelled parallelFor ran %d tasks\n", ran.load());
+        return false;
+    }
+    return true;
+}
+
+bool checkSubmit(ThreadPool& pool){
+    if(pool.submit([]{ return 42; }).get() != 42){
+        std::printf("CHECK FAILED: submit result\n");
+        return false;
+    }
+    return true;
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    int workers = 4;
+    int rounds = 20;
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--workers") && hasValue) workers = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--rounds") && hasValue) rounds = std::atoi(argv[++i]);
+        else{
+            std::fprintf(stderr, "usage: %s [--workers N] [--rounds R]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    ThreadPool pool(workers);
+    for(int r = 0; r < rounds; ++r){
+        if(!checkNested(pool) || !checkGroupException(pool) || !checkLoopException(pool) || !checkCancel(pool) || !checkSubmit(pool)){
+            std::printf("round %d of %d\n", r + 1, rounds);
+            return 1;
+        }
+    }
+
+    std::printf("%d workers, %d rounds: nesting, cancellation, exceptions and submit hold up\n", pool.workers(), rounds);
+    return 0;
+}
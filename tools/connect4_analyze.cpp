@@ -0,0 +1,261 @@
+// post-game blunder analysis for Connect4 self-play sessions
+//
+//   connect4_analyze <log or games file> [--depth D] [--threshold T] [--threads N] [--nnue weights] [--out summary.txt]
+//
+// reads every "GEN Game: <red> <yellow> <columns> <result>" line the game logs at the end of a game
+// (bare "<red> <yellow> <columns> <result>" lines work too), re-searches every position and flags a move as
+// a blunder when it throws away a forced result or, in open positions, scores more than T below the best move.
+// a position is searched DEPTH_MARGIN plies past the depth AI1 plays it at (Connect4Engine::DEPTH_AT_TURN),
+// never below D, and solved to the end of the game once SOLVE_EMPTIES or fewer cells are left
+// the summary uses the log's "AIx Datatype: value" format so DataAnalyzer.py can read it
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../classes/Connect4Engine.h"
+
+namespace{
+
+// scores past this are forced wins/losses (a win further away scores lower, that's not a mistake)
+constexpr int DECIDED = Connect4Engine::MATE / 50;
+// a judge searching only as deep as the bot calls its horizon effects blunders
+constexpr int DEPTH_MARGIN = 2;
+constexpr int SOLVE_EMPTIES = 16;
+
+struct Options{
+    std::string input;
+    std::string out = "connect4_blunders.txt";
+    std::string nnue;
+    int depth = 0;              // minimum, the schedule decides above it
+    int threshold = 50;
+    int threads = 0;
+};
+
+struct Game{
+    std::string players[2];     // red, yellow
+    std::vector<int> columns;
+    std::string result;
+};
+
+struct MoveReview{
+    int ply;
+    int played;                 // column
+    int best;
+    int playedScore;
+    int bestScore;
+};
+
+struct GameReview{
+    std::vector<MoveReview> moves;
+    bool valid = true;
+};
+
+
+// -1 lost, 0 open, 1 won
+int outcome(const int score){
+    return score >= DECIDED ? 1 : (score <= -DECIDED ? -1 : 0);
+}
+
+bool isBlunder(const MoveReview& m, const int threshold){
+    const int best = outcome(m.bestScore);
+    const int played = outcome(m.playedScore);
+    if(best != played) return played < best;
+    return best == 0 && m.bestScore - m.playedScore > threshold;
+}
+
+// plies searched from a position ply moves in with empties cells left
+int reviewDepth(const int ply, const int empties, const int minDepth){
+    if(empties <= SOLVE_EMPTIES) return empties - 1;
+    const int depth = std::max(minDepth, Connect4Engine::DEPTH_AT_TURN[ply / 2] + DEPTH_MARGIN);
+    return std::min(depth, empties - 1);
+}
+
+bool parseGame(const std::string& line, Game& game){
+    const size_t tag = line.find("Game:");
+    std::istringstream fields(tag == std::string::npos ? line : line.substr(tag + 5));
+
+    std::string columns;
+    if(!(fields >> game.players[0] >> game.players[1] >> columns >> game.result)) return false;
+    if(game.result != "red" && game.result != "yellow" && game.result != "draw") return false;
+
+    game.columns.clear();
+    for(char c : columns){
+        if(c < '1' || c > '7') return false;
+        game.columns.push_back(c - '1');
+    }
+    return !game.columns.empty();
+}
+
+// plies of the game up to and including a winning move, -1 when a move is illegal
+int reviewedPlies(const Game& game){
+    std::array<uint64_t, 2> pieces{0, 0};
+    for(int ply = 0; ply < static_cast<int>(game.columns.size()); ++ply){
+        const int cell = Connect4Engine::landingCell(pieces[0] | pieces[1], game.columns[ply]);
+        if(cell < 0) return -1;
+        pieces[ply % 2] |= Connect4Engine::cellMask(cell);
+        if(Connect4Engine::comboWon(pieces[ply % 2])) return ply + 1;
+    }
+    return static_cast<int>(game.columns.size());
+}
+
+// the position before move ply from the mover's point of view: best move and the move that was played.
+// searched on a copy of prototype, which shares the loaded NNUE weights
+MoveReview reviewMove(const Game& game, const int ply, const Options& opt, const Connect4Engine& prototype){
+    std::array<uint64_t, 2> pieces{0, 0};
+    for(int i = 0; i < ply; ++i)
+        pieces[i % 2] |= Connect4Engine::cellMask(Connect4Engine::landingCell(pieces[0] | pieces[1], game.columns[i]));
+
+    Connect4Engine engine = prototype;
+    const auto me = static_cast<Connect4Engine::Color>(ply % 2);
+    const auto opp = static_cast<Connect4Engine::Color>(!me);
+    const int cell = Connect4Engine::landingCell(pieces[0] | pieces[1], game.columns[ply]);
+    const int empties = 42 - std::popcount(pieces[0] | pieces[1]);
+    const int depth = reviewDepth(ply, empties, opt.depth);
+
+    engine.setBoard(pieces[0], pieces[1]);
+    const auto best = engine.multiPV(me, depth, 1);
+
+    engine.makeMove(me, cell);
+    const int playedScore = -engine.negamax(opp, -Connect4Engine::INF_SCORE, Connect4Engine::INF_SCORE, depth);
+
+    // the played move is legal, so there is a best one
+    return {ply, game.columns[ply], best[0].moveIdx % 7, playedScore, best[0].score};
+}
+
+
+// every position of every game spread over the shared pool, --threads N runs on a pool of its own.
+// positions rather than games: the opening plies are the deep ones and a session is often only a few games
+std::vector<GameReview> reviewAll(const std::vector<Game>& games, const Options& opt, const Connect4Engine& prototype){
+    std::vector<GameReview> reviews(games.size());
+    std::vector<std::pair<size_t, int>> positions;
+    for(size_t g = 0; g < games.size(); ++g){
+        const int plies = reviewedPlies(games[g]);
+        reviews[g].valid = plies >= 0;
+        reviews[g].moves.resize(std::max(plies, 0));
+        for(int ply = 0; ply < plies; ++ply) positions.emplace_back(g, ply);
+    }
+
+    std::unique_ptr<ThreadPool> ownPool;
+    if(opt.threads > 0) ownPool = std::make_unique<ThreadPool>(opt.threads);
+    ThreadPool& pool = ownPool ? *ownPool : ThreadPool::shared();
+
+    std::atomic<size_t> done{0};
+    pool.parallelFor(positions.size(), [&](const size_t i){
+        const auto [g, ply] = positions[i];
+        reviews[g].moves[ply] = reviewMove(games[g], ply, opt, prototype);
+        const size_t finished = ++done;
+        if(finished % 10 == 0) std::fprintf(stderr, "\r%zu/%zu positions", finished, positions.size());
+    });
+    std::fprintf(stderr, "\r%zu/%zu positions\n", positions.size(), positions.size());
+
+    return reviews;
+}
+
+
+bool parseOptions(int argc, char** argv, Options& opt){
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--depth") && hasValue) opt.depth = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--threshold") && hasValue) opt.threshold = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--threads") && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--nnue") && hasValue) opt.nnue = argv[++i];
+        else if(!std::strcmp(argv[i], "--out") && hasValue) opt.out = argv[++i];
+        else if(argv[i][0] != '-' && opt.input.empty()) opt.input = argv[i];
+        else return false;
+    }
+    return !opt.input.empty();
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    Options opt;
+    if(!parseOptions(argc, argv, opt)){
+        std::fprintf(stderr, "usage: %s <log or games file> [--depth D] [--threshold T] [--threads N] [--nnue weights] [--out summary.txt]\n", argv[0]);
+        return 2;
+    }
+
+    std::ifstream in(opt.input);
+    if(!in){
+        std::fprintf(stderr, "cannot open %s\n", opt.input.c_str());
+        return 1;
+    }
+
+    std::vector<Game> games;
+    std::string line;
+    while(std::getline(in, line)){
+        Game game;
+        if(parseGame(line, game)) games.push_back(game);
+    }
+    if(games.empty()){
+        std::fprintf(stderr, "no games in %s\n", opt.input.c_str());
+        return 1;
+    }
+
+    Connect4Engine prototype;
+    std::string error;
+    if(!opt.nnue.empty() && !prototype.loadNNUE(opt.nnue, &error)){
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    const std::vector<GameReview> reviews = reviewAll(games, opt, prototype);
+
+    struct BotTotals{
+        int moves = 0;
+        int blunders = 0;
+        std::vector<int> blunderPlies;
+    };
+    std::map<std::string, BotTotals> bots;
+
+    for(size_t g = 0; g < games.size(); ++g){
+        if(!reviews[g].valid){
+            std::printf("game %zu: illegal move list, skipped\n", g);
+            continue;
+        }
+
+        for(const MoveReview& m : reviews[g].moves){
+            const std::string& bot = games[g].players[m.ply % 2];
+            BotTotals& totals = bots[bot];
+            ++totals.moves;
+
+            if(!isBlunder(m, opt.threshold)) continue;
+
+            ++totals.blunders;
+            totals.blunderPlies.push_back(m.ply + 1);
+            std::printf("game %zu ply %d %s played %d, best %d (%d -> %d)\n", g, m.ply + 1, bot.c_str(),
+                m.played + 1, m.best + 1, m.bestScore, m.playedScore);
+        }
+    }
+
+    std::ofstream out(opt.out);
+    std::printf("\n%-6s %8s %9s %8s\n", "bot", "moves", "blunders", "rate");
+    for(const auto& [bot, totals] : bots){
+        const double rate = totals.moves ? static_cast<double>(totals.blunders) / totals.moves : 0.0;
+        std::printf("%-6s %8d %9d %7.2f%%  by ply:", bot.c_str(), totals.moves, totals.blunders, 100 * rate);
+
+        std::map<int, int> byPly;
+        for(int ply : totals.blunderPlies) ++byPly[ply];
+        for(const auto& [ply, count] : byPly) std::printf(" %d:%d", ply, count);
+        std::printf("\n");
+
+        out << bot << " Moves: " << totals.moves << "\n";
+        out << bot << " Blunders: " << totals.blunders << "\n";
+        out << bot << " BlunderRate: " << rate << "\n";
+        for(int ply : totals.blunderPlies) out << bot << " BlunderPly: " << ply << "\n";
+    }
+    std::printf("\nsummary written to %s\n", opt.out.c_str());
+
+    return 0;
+}
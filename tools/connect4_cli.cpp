@@ -0,0 +1,275 @@
+// headless Connect4 engine speaking a UCI style line protocol on stdin/stdout, for tournament runners and scripts
+//
+//   uci                                         id, options, uciok
+//   isready                                     readyok (also while searching)
+//   setoption name MultiPV value K              report the K best root moves
+//   setoption name NNUE value <weights>         evaluate with the network, an empty value switches it off
+//   ucinewgame                                  empty board
+//   position [startpos] [moves] <columns>       columns 1-7 from red's first move on, "4453" or "4 4 5 3"
+//   go [depth D] [movetime ms] [nodes N] [infinite]
+//   stop                                        finish with the last complete depth
+//                                               (other commands wait for a running depth/movetime/nodes search)
+//   d                                           print the board
+//   quit
+//
+// go searches depth 0, 1, 2, ... (the engine's depth: the root move plus D plies) and prints after every depth
+//   info depth D multipv K score cp S|mate M nodes N nps N time ms pv <columns>
+//   bestmove <column>|none
+// mate M counts the moves of the side that wins, negative when the side to move loses
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../classes/Connect4Engine.h"
+
+namespace{
+
+constexpr int DECIDED = Connect4Engine::MATE / 50;
+
+struct Limits{
+    int depth = -1;             // -1 = until the board is full
+    double movetimeMs = 0;
+    uint64_t nodes = 0;
+    bool infinite = false;
+};
+
+struct Session{
+    Connect4Engine engine;
+    std::array<uint64_t, 2> pieces{0, 0};
+    Connect4Engine::Color toMove = Connect4Engine::RED;
+    int multiPV = 1;
+
+    std::thread search;
+    bool infinite = false;
+    std::atomic<bool> stop{false};
+};
+
+std::mutex outputMutex;
+
+// search thread and command loop both write, one line at a time
+void emit(const std::string& line){
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::fputs(line.c_str(), stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
+
+
+std::string scoreString(const int score, const int depth){
+    if(score >= Connect4Engine::MATE || score <= -Connect4Engine::MATE){
+        // the game ended at a node with remaining = |score|/MATE - 1 depth left, plies counts the root move
+        const int remaining = std::abs(score) / Connect4Engine::MATE - 1;
+        const int moves = (depth + 1 - remaining + 1) / 2;
+        return "mate " + std::to_string(score > 0 ? moves : -moves);
+    }
+    return "cp " + std::to_string(score);
+}
+
+std::string pvString(const Connect4Engine::PVLine& pv){
+    std::string s;
+    for(int i = 0; i < pv.length; ++i){
+        if(i) s += ' ';
+        s += std::to_string(pv.moves[i] % Connect4Engine::WIDTH + 1);
+    }
+    return s;
+}
+
+bool gameOver(const std::array<uint64_t, 2>& pieces){
+    return Connect4Engine::comboWon(pieces[0]) || Connect4Engine::comboWon(pieces[1]) || Connect4Engine::boardIsFull({pieces});
+}
+
+
+// runs on the search thread with its own copy of the engine
+void think(Connect4Engine engine, const std::array<uint64_t, 2> pieces, const Connect4Engine::Color me, const int multiPV,
+           const Limits limits, const std::atomic<bool>* stop){
+    const uint64_t occupied = pieces[0] | pieces[1];
+    if(gameOver(pieces)){
+        emit("bestmove none");
+        return;
+    }
+
+    const int empties = Connect4Engine::CELLS - std::popcount(occupied);
+    const int maxDepth = limits.depth < 0 ? empties - 1 : std::min(limits.depth, empties - 1);
+
+    int bestColumn = -1;
+    for(int col : Connect4Engine::COLUMN_ORDER)
+        if(Connect4Engine::landingCell(occupied, col) >= 0){
+            bestColumn = col;
+            break;
+        }
+
+    const auto start = std::chrono::steady_clock::now();
+    engine.setBoard(pieces[0], pieces[1]);
+    engine.setStopFlag(stop);
+    engine.setNodeLimit(limits.nodes);
+    if(limits.movetimeMs > 0) engine.setDeadline(start + std::chrono::microseconds(static_cast<long long>(limits.movetimeMs * 1000)));
+
+    for(int d = 0; d <= maxDepth; ++d){
+        const auto lines = engine.multiPV(me, d, multiPV);
+        if(engine.stopped() || lines.empty()) break;
+
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const auto nps = static_cast<unsigned long long>(ms > 0 ? engine.nodes() * 1000.0 / ms : 0.0);
+        for(size_t k = 0; k < lines.size(); ++k){
+            std::ostringstream info;
+            info << "info depth " << d << " multipv " << k + 1 << " score " << scoreString(lines[k].score, d)
+                 << " nodes " << engine.nodes() << " nps " << nps << " time " << static_cast<long long>(ms)
+                 << " pv " << pvString(lines[k].pv);
+            emit(info.str());
+        }
+        bestColumn = lines[0].moveIdx % Connect4Engine::WIDTH;
+
+        // forced results don't change with more depth
+        const bool decided = std::all_of(lines.begin(), lines.end(), [](const Connect4Engine::RootMove& m){ return std::abs(m.score) >= DECIDED; });
+        if(decided) break;
+    }
+
+    // infinite searches report only once they are stopped
+    while(limits.infinite && !stop->load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    emit("bestmove " + std::to_string(bestColumn + 1));
+}
+
+void stopSearch(Session& s){
+    s.stop = true;
+    if(s.search.joinable()) s.search.join();
+    s.stop = false;
+}
+
+// commands arriving during a search queue behind it, so piped scripts get every result; an infinite one is stopped
+void waitSearch(Session& s){
+    if(s.infinite) stopSearch(s);
+    else if(s.search.joinable()) s.search.join();
+}
+
+
+// replaces the position only if every move is legal
+void setPosition(Session& s, std::istringstream& args){
+    std::array<uint64_t, 2> pieces{0, 0};
+    auto toMove = Connect4Engine::RED;
+
+    std::string token;
+    while(args >> token){
+        if(token == "startpos" || token == "moves") continue;
+
+        for(char c : token){
+            const int col = c - '1';
+            const int idx = col >= 0 && col < Connect4Engine::WIDTH ? Connect4Engine::landingCell(pieces[0] | pieces[1], col) : -1;
+            if(idx < 0 || gameOver(pieces)){
+                emit(std::string("info string illegal move ") + c + ", position unchanged");
+                return;
+            }
+            pieces[toMove] |= Connect4Engine::cellMask(idx);
+            toMove = static_cast<Connect4Engine::Color>(!toMove);
+        }
+    }
+
+    s.pieces = pieces;
+    s.toMove = toMove;
+}
+
+void go(Session& s, std::istringstream& args){
+    Limits limits;
+    std::string token;
+    while(args >> token){
+        if(token == "depth") args >> limits.depth;
+        else if(token == "movetime") args >> limits.movetimeMs;
+        else if(token == "nodes") args >> limits.nodes;
+        else if(token == "infinite") limits.infinite = true;
+    }
+
+    s.infinite = limits.infinite;
+    s.search = std::thread(think, s.engine, s.pieces, s.toMove, s.multiPV, limits, &s.stop);
+}
+
+void setOption(Session& s, const std::string& line){
+    const size_t name = line.find("name ");
+    const size_t value = line.find(" value");
+    if(name == std::string::npos) return;
+
+    const std::string key = line.substr(name + 5, value == std::string::npos ? std::string::npos : value - name - 5);
+    const std::string val = value == std::string::npos ? "" : line.substr(std::min(line.size(), value + 7));
+
+    if(key == "MultiPV"){
+        s.multiPV = std::clamp(std::atoi(val.c_str()), 1, Connect4Engine::WIDTH);
+    }else if(key == "NNUE"){
+        s.engine = Connect4Engine{};
+        std::string error;
+        if(!val.empty() && !s.engine.loadNNUE(val, &error)) emit("info string NNUE not loaded: " + error);
+    }else{
+        emit("info string unknown option " + key);
+    }
+}
+
+void printBoard(const Session& s){
+    for(int y = 0; y < Connect4Engine::HEIGHT; ++y){
+        std::string row;
+        for(int x = 0; x < Connect4Engine::WIDTH; ++x){
+            const uint64_t cell = Connect4Engine::cellMask(y * Connect4Engine::WIDTH + x);
+            row += (s.pieces[Connect4Engine::RED] & cell) ? 'x' : ((s.pieces[Connect4Engine::YELLOW] & cell) ? 'o' : '.');
+        }
+        emit(row);
+    }
+    emit(std::string("to move: ") + (s.toMove == Connect4Engine::RED ? "red (x)" : "yellow (o)"));
+}
+
+}
+
+
+
+int main(){
+    Session s;
+    std::string line;
+
+    while(std::getline(std::cin, line)){
+        std::istringstream args(line);
+        std::string command;
+        if(!(args >> command)) continue;
+
+        if(command == "uci"){
+            emit("id name connect4_cli");
+            emit("option name MultiPV type spin default 1 min 1 max 7");
+            emit("option name NNUE type string default <empty>");
+            emit("uciok");
+        }
+        else if(command == "isready") emit("readyok");
+        else if(command == "setoption"){
+            waitSearch(s);
+            setOption(s, line);
+        }
+        else if(command == "ucinewgame"){
+            waitSearch(s);
+            s.pieces = {0, 0};
+            s.toMove = Connect4Engine::RED;
+        }
+        else if(command == "position"){
+            waitSearch(s);
+            setPosition(s, args);
+        }
+        else if(command == "go"){
+            waitSearch(s);
+            go(s, args);
+        }
+        else if(command == "stop") stopSearch(s);
+        else if(command == "d") printBoard(s);
+        else if(command == "quit"){
+            stopSearch(s);
+            return 0;
+        }
+        else emit("info string unknown command " + command);
+    }
+
+    // end of input, a piped "go depth 12" still finishes
+    waitSearch(s);
+    return 0;
+}
@@ -0,0 +1,747 @@
+// Connect4 analysis server: engine evaluations for several local tools at once over a Unix domain socket
+//
+//   connect4_server [--socket path] [--workers N] [--cache-entries N] [--nnue weights]
+//   connect4_server --selftest          serves a temporary socket and checks the answers over loopback
+//
+// one request per line, answers come back on the same connection as they finish, not necessarily in order
+//   eval <id> <columns|-> [depth D] [movetime ms] [nodes N]
+//   ok <id> move <column> score <s> depth <d> nodes <n> pv <columns> cached <0|1> queue_ms <q> search_ms <s> queue_depth <n>
+//   error <id> <reason>
+//   stats
+//   stats requests <n> cache_hits <n> queued <n> busy <n> avg_queue_ms <x> avg_search_ms <x>
+// columns (and the pv) are 1-7 from red's first move on, "-" is the empty board, depth defaults to DEFAULT_DEPTH
+// depth-only requests up to SHALLOW_DEPTH go to a batch queue that workers drain BATCH_SIZE at a time,
+// deeper and time/node limited searches never take the last free worker so batches keep moving
+// all workers share one position cache, a repeated position is answered straight from the connection thread
+// by hand: socat - UNIX-CONNECT:connect4.sock
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../classes/Connect4Engine.h"
+
+namespace{
+
+constexpr int DEFAULT_DEPTH = 8;
+constexpr int SHALLOW_DEPTH = 6;
+constexpr size_t BATCH_SIZE = 32;
+constexpr int ACCEPT_POLL_MS = 100;
+constexpr int DECIDED = Connect4Engine::MATE / 50;
+
+std::atomic<bool> interrupted{false};
+
+struct Options{
+    std::string socket = "connect4.sock";
+    int workers = 0;
+    size_t cacheEntries = 1 << 16;
+    std::string nnue;
+    bool selftest = false;
+};
+
+using Pieces = std::array<uint64_t, 2>;
+
+double msSince(const std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool gameOver(const Pieces& pieces){
+    return Connect4Engine::comboWon(pieces[0]) || Connect4Engine::comboWon(pieces[1]) || Connect4Engine::boardIsFull({pieces});
+}
+
+// plays a column string ("4453", "-" for none), false on an illegal move or a move after the game ended
+bool playColumns(const std::string& columns, Pieces& pieces, Connect4Engine::Color& toMove){
+    pieces = {0, 0};
+    toMove = Connect4Engine::RED;
+    if(columns == "-") return true;
+
+    for(char c : columns){
+        const int col = c - '1';
+        const int idx = col >= 0 && col < Connect4Engine::WIDTH ? Connect4Engine::landingCell(pieces[0] | pieces[1], col) : -1;
+        if(idx < 0 || gameOver(pieces)) return false;
+        pieces[toMove] |= Connect4Engine::cellMask(idx);
+        toMove = static_cast<Connect4Engine::Color>(!toMove);
+    }
+    return true;
+}
+
+std::string pvString(const Connect4Engine::PVLine& pv){
+    std::string s;
+    for(int i = 0; i < pv.length; ++i)
+        s += static_cast<char>('1' + pv.moves[i] % Connect4Engine::WIDTH);
+    return s.empty() ? "-" : s;
+}
+
+
+// one client socket, written by whichever thread finishes a request
+class Connection{
+
+public:
+
+    explicit Connection(const int fd) : _fd(fd) {}
+    ~Connection() { close(); }
+
+    int  fd() const { return _fd; }
+    // replies still queued for a closed connection are dropped, the descriptor number may already belong to someone else
+    void close(){
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        if(_fd >= 0) ::close(_fd);
+        _fd = -1;
+    }
+    void send(const std::string& line){
+        const std::string data = line + "\n";
+        std::lock_guard<std::mutex> lock(_writeMutex);
+        if(_fd < 0) return;
+        for(size_t sent = 0; sent < data.size();){
+            const ssize_t n = ::send(_fd, data.data() + sent, data.size() - sent, 0);
+            if(n <= 0) return;      // client went away, nobody to tell
+            sent += static_cast<size_t>(n);
+        }
+    }
+
+private:
+
+    int _fd;
+    std::mutex _writeMutex;
+};
+
+
+struct Result{
+    int move;               // column
+    int score;
+    int depth;
+    uint64_t nodes;
+    Connect4Engine::PVLine pv;
+};
+
+// direct mapped, shared by all workers. a slot keeps the deeper result when the same position comes back
+class PositionCache{
+
+public:
+
+    explicit PositionCache(const size_t entries) : _entries(std::max<size_t>(entries, 1)) {}
+
+    // any stored result at least minDepth deep
+    bool probe(const Pieces& pieces, const int minDepth, Result& out){
+        const size_t i = slot(pieces);
+        std::lock_guard<std::mutex> lock(_locks[i % SHARDS]);
+        const Entry& e = _entries[i];
+        if(!e.valid || e.pieces != pieces || e.result.depth < minDepth) return false;
+        out = e.result;
+        return true;
+    }
+
+    void store(const Pieces& pieces, const Result& result){
+        const size_t i = slot(pieces);
+        std::lock_guard<std::mutex> lock(_locks[i % SHARDS]);
+        Entry& e = _entries[i];
+        if(e.valid && e.pieces == pieces && e.result.depth >= result.depth) return;
+        e = {pieces, result, true};
+    }
+
+private:
+
+    static constexpr size_t SHARDS = 64;
+
+    struct Entry{
+        Pieces pieces;
+        Result result;
+        bool valid = false;
+    };
+
+    size_t slot(const Pieces& pieces) const{
+        uint64_t h = pieces[0] * 0x9E3779B97F4A7C15ULL ^ pieces[1];
+        h ^= h >> 31;
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 29;
+        return static_cast<size_t>(h % _entries.size());
+    }
+
+    std::vector<Entry> _entries;
+    std::array<std::mutex, SHARDS> _locks;
+};
+
+
+struct Request{
+    std::shared_ptr<Connection> conn;
+    std::string id;
+    Pieces pieces;
+    Connect4Engine::Color toMove;
+    int depth;                          // -1 = up to the end of the game (time/node limited only)
+    double movetimeMs = 0;
+    uint64_t nodes = 0;
+    std::chrono::steady_clock::time_point queued;
+    size_t queueDepth = 0;
+
+    bool limited() const { return movetimeMs > 0 || nodes > 0; }
+    bool shallow() const { return !limited() && depth <= SHALLOW_DEPTH; }
+};
+
+
+class Server{
+
+public:
+
+    explicit Server(const Options& opt);
+    ~Server();
+
+    bool listen(std::string* error);
+    // accepts clients until quit is set
+    void run(const std::atomic<bool>& quit);
+    // stops the workers (queued requests are dropped) and closes every connection
+    void shutdown();
+    // clients currently connected
+    size_t connections();
+
+private:
+
+    // one per client, kept until the next accept joins it after its client hung up
+    struct Reader{
+        std::shared_ptr<Connection> conn;   // reset when the client hangs up
+        std::thread thread;
+    };
+
+    void serve(std::shared_ptr<Connection> conn, Reader* reader);
+    void handle(const std::shared_ptr<Connection>& conn, const std::string& line);
+    void enqueue(Request request);
+    void worker();
+    Result search(Connect4Engine& engine, const Request& request);
+    void reply(const Request& request, const Result& result, const bool cached, const double queueMs, const double searchMs);
+    std::string statsLine();
+
+    Options _opt;
+    int _listenFd = -1;
+    PositionCache _cache;
+
+    std::mutex _queueMutex;
+    std::condition_variable _queueCv;
+    std::deque<Request> _shallow;
+    std::deque<Request> _deep;
+    int _deepRunning = 0;
+    int _maxDeep;
+    std::atomic<bool> _stopping{false};
+    std::vector<std::thread> _workers;
+    std::atomic<int> _busy{0};
+
+    std::mutex _connMutex;
+    std::list<Reader> _readers;
+
+    std::atomic<uint64_t> _requests{0};
+    std::atomic<uint64_t> _cacheHits{0};
+    std::atomic<uint64_t> _completed{0};
+    std::atomic<uint64_t> _queueUs{0};
+    std::atomic<uint64_t> _searchUs{0};
+};
+
+
+Server::Server(const Options& opt) : _opt(opt), _cache(opt.cacheEntries){
+    const int count = opt.workers > 0 ? opt.workers : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    _maxDeep = std::max(1, count - 1);
+    for(int i = 0; i < count; ++i) _workers.emplace_back(&Server::worker, this);
+}
+
+Server::~Server(){
+    shutdown();
+}
+
+
+bool Server::listen(std::string* error){
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if(_opt.socket.size() >= sizeof(addr.sun_path)){
+        if(error) *error = "socket path too long";
+        return false;
+    }
+    std::strncpy(addr.sun_path, _opt.socket.c_str(), sizeof(addr.sun_path) - 1);
+
+    _listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(_opt.socket.c_str());
+    if(_listenFd < 0 || bind(_listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(_listenFd, 64) != 0){
+        if(error) *error = std::string(_opt.socket) + ": " + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void Server::run(const std::atomic<bool>& quit){
+    while(!quit && !interrupted){
+        pollfd p{_listenFd, POLLIN, 0};
+        if(poll(&p, 1, ACCEPT_POLL_MS) <= 0) continue;
+
+        const int fd = accept(_listenFd, nullptr, nullptr);
+        if(fd < 0) continue;
+
+        auto conn = std::make_shared<Connection>(fd);
+        std::lock_guard<std::mutex> lock(_connMutex);
+        for(auto it = _readers.begin(); it != _readers.end();){
+            if(it->conn){
+                ++it;
+                continue;
+            }
+            it->thread.join();      // already past its last touch of the server
+            it = _readers.erase(it);
+        }
+        Reader& reader = _readers.emplace_back();
+        reader.conn = conn;
+        reader.thread = std::thread(&Server::serve, this, conn, &reader);
+    }
+}
+
+void Server::shutdown(){
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        if(_stopping && _workers.empty()) return;
+        _stopping = true;
+        _shallow.clear();
+        _deep.clear();
+    }
+    _queueCv.notify_all();
+    for(auto& t : _workers) t.join();
+    _workers.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(_connMutex);
+        for(auto& reader : _readers)
+            if(reader.conn) ::shutdown(reader.conn->fd(), SHUT_RDWR);
+    }
+    // run() has returned, nothing adds readers any more
+    for(auto& reader : _readers) reader.thread.join();
+    _readers.clear();
+
+    if(_listenFd >= 0){
+        close(_listenFd);
+        unlink(_opt.socket.c_str());
+        _listenFd = -1;
+    }
+}
+
+
+size_t Server::connections(){
+    std::lock_guard<std::mutex> lock(_connMutex);
+    return static_cast<size_t>(std::count_if(_readers.begin(), _readers.end(), [](const Reader& r){ return r.conn != nullptr; }));
+}
+
+
+void Server::serve(std::shared_ptr<Connection> conn, Reader* reader){
+    std::string buffer;
+    char chunk[4096];
+
+    while(true){
+        const ssize_t n = read(conn->fd(), chunk, sizeof(chunk));
+        if(n <= 0) break;
+        buffer.append(chunk, static_cast<size_t>(n));
+
+        for(size_t end = buffer.find('\n'); end != std::string::npos; end = buffer.find('\n')){
+            std::string line = buffer.substr(0, end);
+            buffer.erase(0, end + 1);
+            if(!line.empty() && line.back() == '\r') line.pop_back();
+            if(!line.empty()) handle(conn, line);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_connMutex);
+        reader->conn.reset();
+    }
+    conn->close();
+}
+
+void Server::handle(const std::shared_ptr<Connection>& conn, const std::string& line){
+    std::istringstream in(line);
+    std::string command;
+    in >> command;
+
+    if(command == "stats"){
+        conn->send(statsLine());
+        return;
+    }
+    if(command != "eval"){
+        conn->send("error - unknown command " + command);
+        return;
+    }
+
+    Request request;
+    request.conn = conn;
+    std::string columns;
+    if(!(in >> request.id >> columns)){
+        conn->send("error - usage: eval <id> <columns|-> [depth D] [movetime ms] [nodes N]");
+        return;
+    }
+    if(!playColumns(columns, request.pieces, request.toMove) || gameOver(request.pieces)){
+        conn->send("error " + request.id + " illegal move list or game over");
+        return;
+    }
+
+    request.depth = -1;
+    std::string key;
+    while(in >> key){
+        if(key == "depth") in >> request.depth;
+        else if(key == "movetime") in >> request.movetimeMs;
+        else if(key == "nodes") in >> request.nodes;
+    }
+    const int empties = Connect4Engine::CELLS - std::popcount(request.pieces[0] | request.pieces[1]);
+    if(request.depth < 0 && !request.limited()) request.depth = DEFAULT_DEPTH;
+    if(request.depth < 0 || request.depth > empties - 1) request.depth = empties - 1;
+
+    ++_requests;
+    Result cached;
+    if(!request.limited() && _cache.probe(request.pieces, request.depth, cached)){
+        ++_cacheHits;
+        reply(request, cached, true, 0.0, 0.0);
+        return;
+    }
+
+    enqueue(std::move(request));
+}
+
+void Server::enqueue(Request request){
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        if(_stopping) return;
+        request.queued = std::chrono::steady_clock::now();
+        request.queueDepth = _shallow.size() + _deep.size();
+        (request.shallow() ? _shallow : _deep).push_back(std::move(request));
+    }
+    _queueCv.notify_one();
+}
+
+
+void Server::worker(){
+    Connect4Engine engine;
+    if(!_opt.nnue.empty()) engine.loadNNUE(_opt.nnue);
+    engine.setStopFlag(&_stopping);
+
+    while(true){
+        std::vector<Request> batch;
+        bool deep = false;
+        {
+            std::unique_lock<std::mutex> lock(_queueMutex);
+            _queueCv.wait(lock, [this]{ return _stopping || !_shallow.empty() || (!_deep.empty() && _deepRunning < _maxDeep); });
+            if(_stopping) return;
+
+            if(!_shallow.empty()){
+                while(!_shallow.empty() && batch.size() < BATCH_SIZE){
+                    batch.push_back(std::move(_shallow.front()));
+                    _shallow.pop_front();
+                }
+            }else{
+                batch.push_back(std::move(_deep.front()));
+                _deep.pop_front();
+                ++_deepRunning;
+                deep = true;
+            }
+        }
+
+        ++_busy;
+        for(const Request& request : batch){
+            const double queueMs = msSince(request.queued);
+            Result result;
+            // an identical request may have been searched while this one waited
+            if(!request.limited() && _cache.probe(request.pieces, request.depth, result)){
+                ++_cacheHits;
+                reply(request, result, true, queueMs, 0.0);
+                continue;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            result = search(engine, request);
+            if(_stopping) break;
+            reply(request, result, false, queueMs, msSince(start));
+        }
+        --_busy;
+
+        if(deep){
+            {
+                std::lock_guard<std::mutex> lock(_queueMutex);
+                --_deepRunning;
+            }
+            _queueCv.notify_all();
+        }
+    }
+}
+
+Result Server::search(Connect4Engine& engine, const Request& request){
+    engine.setBoard(request.pieces[0], request.pieces[1]);
+    engine.setNodeLimit(request.nodes);
+    if(request.movetimeMs > 0) engine.setDeadline(std::chrono::steady_clock::now() + std::chrono::microseconds(static_cast<long long>(request.movetimeMs * 1000)));
+    else engine.clearDeadline();
+
+    // fixed depth goes straight to the depth, limited searches deepen until they run out
+    Result best{-1, 0, -1, 0, {}};
+    for(int d = request.limited() ? 0 : request.depth; d <= request.depth; ++d){
+        const auto lines = engine.multiPV(request.toMove, d, 1);
+        if(engine.stopped() || lines.empty()) break;
+
+        best = {lines[0].moveIdx % Connect4Engine::WIDTH, lines[0].score, d, engine.nodes(), lines[0].pv};
+        _cache.store(request.pieces, best);
+        if(std::abs(best.score) >= DECIDED) break;
+    }
+
+    best.nodes = engine.nodes();
+    return best;
+}
+
+void Server::reply(const Request& request, const Result& result, const bool cached, const double queueMs, const double searchMs){
+    _queueUs += static_cast<uint64_t>(queueMs * 1000);
+    _searchUs += static_cast<uint64_t>(searchMs * 1000);
+    ++_completed;
+
+    if(result.move < 0){
+        request.conn->send("error " + request.id + " no complete search within the limits");
+        return;
+    }
+
+    char metrics[128];
+    std::snprintf(metrics, sizeof(metrics), " cached %d queue_ms %.2f search_ms %.2f queue_depth %zu",
+        static_cast<int>(cached), queueMs, searchMs, request.queueDepth);
+    request.conn->send("ok " + request.id + " move " + std::to_string(result.move + 1) + " score " + std::to_string(result.score) +
+        " depth " + std::to_string(result.depth) + " nodes " + std::to_string(result.nodes) + " pv " + pvString(result.pv) + metrics);
+}
+
+std::string Server::statsLine(){
+    size_t queued;
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        queued = _shallow.size() + _deep.size();
+    }
+    const uint64_t done = std::max<uint64_t>(_completed, 1);
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "stats requests %llu cache_hits %llu queued %zu busy %d avg_queue_ms %.2f avg_search_ms %.2f",
+        static_cast<unsigned long long>(_requests.load()), static_cast<unsigned long long>(_cacheHits.load()), queued, _busy.load(),
+        _queueUs / 1000.0 / done, _searchUs / 1000.0 / done);
+    return line;
+}
+
+
+// loopback check: a few clients pipeline requests, every answer is re-searched locally and must match
+int connectTo(const std::string& path){
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0){
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+bool readLine(const int fd, std::string& buffer, std::string& line){
+    char chunk[4096];
+    size_t end;
+    while((end = buffer.find('\n')) == std::string::npos){
+        const ssize_t n = read(fd, chunk, sizeof(chunk));
+        if(n <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+    line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    return true;
+}
+
+std::string randomColumns(std::mt19937& rng, const int moves){
+    while(true){
+        std::string columns;
+        Pieces pieces;
+        Connect4Engine::Color toMove;
+        for(int i = 0; i < moves; ++i){
+            const std::string next = columns + static_cast<char>('1' + rng() % Connect4Engine::WIDTH);
+            if(playColumns(next, pieces, toMove) && !gameOver(pieces)) columns = next;
+        }
+        if(static_cast<int>(columns.size()) == moves) return columns.empty() ? "-" : columns;
+    }
+}
+
+bool checkAnswer(const std::string& line, const std::map<std::string, std::string>& sent){
+    std::istringstream in(line);
+    std::string ok, id, key;
+    int move = 0, score = 0, depth = 0;
+    in >> ok >> id;
+    while(in >> key){
+        if(key == "move") in >> move;
+        else if(key == "score") in >> score;
+        else if(key == "depth") in >> depth;
+    }
+    if(ok != "ok" || !sent.count(id)){
+        std::printf("FAIL unexpected answer: %s\n", line.c_str());
+        return false;
+    }
+
+    Pieces pieces;
+    Connect4Engine::Color toMove;
+    playColumns(sent.at(id), pieces, toMove);
+    Connect4Engine engine;
+    engine.setBoard(pieces[0], pieces[1]);
+    const auto expected = engine.multiPV(toMove, depth, 1);
+
+    if(expected.empty() || expected[0].score != score || expected[0].moveIdx % Connect4Engine::WIDTH + 1 != move){
+        std::printf("FAIL %s (%s depth %d): server %d/%d, local %d/%d\n", id.c_str(), sent.at(id).c_str(), depth, move, score,
+            expected.empty() ? 0 : expected[0].moveIdx % Connect4Engine::WIDTH + 1, expected.empty() ? 0 : expected[0].score);
+        return false;
+    }
+    return true;
+}
+
+int selftest(Options opt){
+    opt.socket = "/tmp/connect4_server_selftest_" + std::to_string(getpid()) + ".sock";
+    if(opt.workers <= 0) opt.workers = 3;
+
+    Server server(opt);
+    std::string error;
+    if(!server.listen(&error)){
+        std::printf("FAIL %s\n", error.c_str());
+        return 1;
+    }
+    std::atomic<bool> quit{false};
+    std::thread acceptor([&]{ server.run(quit); });
+
+    constexpr int CLIENTS = 4;
+    constexpr int REQUESTS = 18;
+    std::atomic<int> failures{0};
+    std::atomic<int> cachedRepeats{0};
+
+    auto client = [&](const int c){
+        const int fd = connectTo(opt.socket);
+        if(fd < 0){
+            ++failures;
+            return;
+        }
+        auto conn = std::make_shared<Connection>(fd);
+        std::mt19937 rng(c + 1);
+        std::map<std::string, std::string> sent;
+
+        // mostly shallow batch work, every sixth request a deep one
+        for(int i = 0; i < REQUESTS; ++i){
+            const std::string id = std::to_string(c) + "." + std::to_string(i);
+            const std::string columns = randomColumns(rng, 8 + static_cast<int>(rng() % 14));
+            const int depth = i % 6 == 5 ? 8 : 1 + static_cast<int>(rng() % SHALLOW_DEPTH);
+            sent[id] = columns;
+            conn->send("eval " + id + " " + columns + " depth " + std::to_string(depth));
+        }
+
+        std::string buffer, line, repeat;
+        for(int i = 0; i < REQUESTS; ++i){
+            if(!readLine(fd, buffer, line) || !checkAnswer(line, sent)){
+                ++failures;
+                return;
+            }
+            repeat = sent.begin()->second;
+        }
+
+        // everything is answered, so the same position again has to come from the cache
+        sent["again"] = repeat;
+        conn->send("eval again " + repeat + " depth 1");
+        if(!readLine(fd, buffer, line) || !checkAnswer(line, sent)) ++failures;
+        else if(line.find("cached 1") != std::string::npos) ++cachedRepeats;
+    };
+
+    std::vector<std::thread> clients;
+    for(int c = 0; c < CLIENTS; ++c) clients.emplace_back(client, c);
+    for(auto& t : clients) t.join();
+
+    const int fd = connectTo(opt.socket);
+    std::string buffer, stats;
+    if(fd >= 0){
+        const char request[] = "stats\n";
+        if(write(fd, request, sizeof(request) - 1) > 0) readLine(fd, buffer, stats);
+        close(fd);
+    }
+
+    // clients that come and go, the server has to let go of every one of them
+    constexpr size_t CHURN = 32;
+    auto waitFor = [&](const size_t count){
+        const auto start = std::chrono::steady_clock::now();
+        while(server.connections() != count && msSince(start) < 5000)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return server.connections() == count;
+    };
+    waitFor(0);
+    std::vector<int> churn;
+    for(size_t i = 0; i < CHURN; ++i){
+        const int c = connectTo(opt.socket);
+        if(c >= 0) churn.push_back(c);
+    }
+    const bool allOpen = churn.size() == CHURN && waitFor(CHURN);
+    for(int c : churn) close(c);
+    const bool allClosed = waitFor(0);
+    if(!allOpen || !allClosed){
+        std::printf("FAIL %zu connections still open after %zu clients hung up\n", server.connections(), CHURN);
+        ++failures;
+    }
+
+    quit = true;
+    acceptor.join();
+    server.shutdown();
+
+    std::printf("%d clients x %d requests, %d failures, %d/%d repeats cached, %zu clients connected and hung up\n%s\n", CLIENTS,
+        REQUESTS, failures.load(), cachedRepeats.load(), CLIENTS, CHURN, stats.c_str());
+    return failures == 0 && cachedRepeats == CLIENTS ? 0 : 1;
+}
+
+
+bool parseOptions(int argc, char** argv, Options& opt){
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--socket") && hasValue) opt.socket = argv[++i];
+        else if(!std::strcmp(argv[i], "--workers") && hasValue) opt.workers = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--cache-entries") && hasValue) opt.cacheEntries = std::strtoull(argv[++i], nullptr, 10);
+        else if(!std::strcmp(argv[i], "--nnue") && hasValue) opt.nnue = argv[++i];
+        else if(!std::strcmp(argv[i], "--selftest")) opt.selftest = true;
+        else return false;
+    }
+    return true;
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    Options opt;
+    if(!parseOptions(argc, argv, opt)){
+        std::fprintf(stderr, "usage: %s [--socket path] [--workers N] [--cache-entries N] [--nnue weights] [--selftest]\n", argv[0]);
+        return 2;
+    }
+
+    // a client hanging up mid answer must not kill the server
+    std::signal(SIGPIPE, SIG_IGN);
+    if(opt.selftest) return selftest(opt);
+
+    std::signal(SIGINT, [](int){ interrupted = true; });
+    std::signal(SIGTERM, [](int){ interrupted = true; });
+
+    Server server(opt);
+    std::string error;
+    if(!server.listen(&error)){
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::printf("listening on %s\n", opt.socket.c_str());
+    std::fflush(stdout);
+
+    const std::atomic<bool> quit{false};
+    server.run(quit);
+    server.shutdown();
+    return 0;
+}
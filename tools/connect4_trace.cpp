@@ -0,0 +1,327 @@
+// Connect4 search trace tool
+//
+//   connect4_trace record <red hex> <yellow hex> <0 red|1 yellow to move> <depth> <out.bin> [--max-ply N] [--check]
+//   connect4_trace summary <trace.bin>
+//   connect4_trace folded <trace.bin>                          flame graph input (flamegraph.pl, speedscope)
+//   connect4_trace dot <trace.bin> [--search N] [--max-ply N]  graphviz, one root search (default the last)
+//
+// traces come from the "Dump Trace" button in the game or from record. frames are columns (c0..c6),
+// a node whose cutoff came late in the move order is marked "!cut<k>": those are the ordering failures.
+// record --check reads the file back and exits with 1 unless it holds every record of the one search, for ctest
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../classes/Connect4Engine.h"
+#include "../classes/SearchTrace.h"
+
+namespace{
+
+struct Tree{
+    int depth = -1;                         // -1 if the start of the search was overwritten
+    int start = -1;                         // SEARCH_START record
+    std::vector<int> roots;                 // ply 1 nodes
+    std::vector<int> orphans;               // nodes whose parent never got recorded (ring buffer wrap, aborted search)
+};
+
+struct Forest{
+    std::vector<SearchTrace::Record> records;
+    std::vector<std::vector<int>> children;
+    std::vector<int> parent;
+    std::vector<Tree> trees;
+};
+
+// records are post-order, so a node's children are exactly the nodes one ply deeper still waiting for a parent
+void closeTree(Tree& tree, std::vector<std::vector<int>>& pending){
+    tree.roots = pending[1];
+    for(size_t ply = 2; ply < pending.size(); ++ply)
+        tree.orphans.insert(tree.orphans.end(), pending[ply].begin(), pending[ply].end());
+    for(auto& p : pending) p.clear();
+}
+
+Forest buildForest(std::vector<SearchTrace::Record> records){
+    Forest f;
+    f.records = std::move(records);
+    f.children.resize(f.records.size());
+    f.parent.assign(f.records.size(), -1);
+
+    std::vector<std::vector<int>> pending(SearchStats::MAX_PLY + 2);
+    Tree current;
+    bool any = false;
+
+    for(int i = 0; i < static_cast<int>(f.records.size()); ++i){
+        const SearchTrace::Record& r = f.records[i];
+
+        if(r.flags & SearchTrace::SEARCH_START){
+            if(any){
+                closeTree(current, pending);
+                f.trees.push_back(current);
+            }
+            current = Tree{};
+            current.depth = r.alpha;
+            current.start = i;
+            any = true;
+            continue;
+        }
+
+        any = true;
+        const int ply = std::min<int>(r.ply, SearchStats::MAX_PLY);
+        f.children[i] = pending[ply + 1];
+        for(int child : f.children[i]) f.parent[child] = i;
+        pending[ply + 1].clear();
+        pending[ply].push_back(i);
+    }
+
+    if(any){
+        closeTree(current, pending);
+        f.trees.push_back(current);
+    }
+    return f;
+}
+
+uint64_t occupied(const SearchTrace::Record& r){
+    return r.pieces[0] | r.pieces[1];
+}
+
+// column of the move that led from one record to the next, -1 if they are not one move apart
+int moveColumn(const SearchTrace::Record& from, const SearchTrace::Record& to){
+    const uint64_t diff = occupied(from) ^ occupied(to);
+    if(std::popcount(diff) != 1) return -1;
+    return (63 - std::countr_zero(diff)) % 7;
+}
+
+std::string frameName(const Forest& f, const Tree& tree, const int node){
+    const SearchTrace::Record& r = f.records[node];
+    const int parent = f.parent[node];
+
+    int col = -1;
+    if(parent >= 0) col = moveColumn(f.records[parent], r);
+    else if(tree.start >= 0) col = moveColumn(f.records[tree.start], r);
+
+    std::string name = col < 0 ? "?" : "c";
+    if(col >= 0) name += std::to_string(col);
+    if(r.cutoffIdx > 0){
+        name += "!cut";
+        name += std::to_string(r.cutoffIdx);
+    }
+    return name;
+}
+
+std::string treeName(const Tree& tree, const int index){
+    return "search" + std::to_string(index) + "_d" + (tree.depth < 0 ? std::string("?") : std::to_string(tree.depth));
+}
+
+// nodes searched before the move that finally failed high
+uint64_t wastedNodes(const Forest& f, const int node){
+    const SearchTrace::Record& r = f.records[node];
+    if(r.cutoffIdx <= 0) return 0;
+
+    uint64_t wasted = 0;
+    const auto& kids = f.children[node];
+    for(int i = 0; i < r.cutoffIdx && i < static_cast<int>(kids.size()); ++i)
+        wasted += f.records[kids[i]].subtreeNodes;
+    return wasted;
+}
+
+
+void printFolded(const Forest& f, const std::string& stack, const Tree& tree, const int node){
+    const SearchTrace::Record& r = f.records[node];
+    const std::string frame = stack + ";" + frameName(f, tree, node);
+
+    uint64_t self = r.subtreeNodes;
+    for(int child : f.children[node]){
+        self -= std::min<uint64_t>(self, f.records[child].subtreeNodes);
+        printFolded(f, frame, tree, child);
+    }
+
+    if(self > 0) std::printf("%s %llu\n", frame.c_str(), static_cast<unsigned long long>(self));
+}
+
+int folded(const Forest& f){
+    for(size_t t = 0; t < f.trees.size(); ++t){
+        const Tree& tree = f.trees[t];
+        const std::string base = treeName(tree, static_cast<int>(t));
+        for(int node : tree.roots) printFolded(f, base, tree, node);
+        for(int node : tree.orphans) printFolded(f, base + ";truncated", tree, node);
+    }
+    return 0;
+}
+
+
+int summary(const Forest& f){
+    for(size_t t = 0; t < f.trees.size(); ++t){
+        const Tree& tree = f.trees[t];
+
+        uint64_t nodes = 0, recorded = 0, cutoffs = 0, firstCutoffs = 0;
+        std::vector<int> late;
+        std::vector<int> stack(tree.roots.begin(), tree.roots.end());
+        stack.insert(stack.end(), tree.orphans.begin(), tree.orphans.end());
+        for(int node : tree.roots) nodes += f.records[node].subtreeNodes;
+
+        while(!stack.empty()){
+            const int node = stack.back();
+            stack.pop_back();
+            ++recorded;
+
+            const SearchTrace::Record& r = f.records[node];
+            if(r.cutoffIdx >= 0) ++cutoffs;
+            if(r.cutoffIdx == 0) ++firstCutoffs;
+            if(r.cutoffIdx > 0) late.push_back(node);
+            stack.insert(stack.end(), f.children[node].begin(), f.children[node].end());
+        }
+
+        std::printf("%s: %llu nodes searched, %llu recorded, %llu cutoffs (%.1f%% on the first move)%s\n",
+            treeName(tree, static_cast<int>(t)).c_str(), static_cast<unsigned long long>(nodes), static_cast<unsigned long long>(recorded),
+            static_cast<unsigned long long>(cutoffs), cutoffs ? 100.0 * firstCutoffs / cutoffs : 0.0,
+            tree.orphans.empty() ? "" : ", start overwritten");
+
+        std::sort(late.begin(), late.end(), [&f](int x, int y){ return wastedNodes(f, x) > wastedNodes(f, y); });
+        for(size_t i = 0; i < late.size() && i < 10; ++i){
+            std::string path;
+            for(int n = late[i]; n >= 0; n = f.parent[n]) path = frameName(f, tree, n) + (path.empty() ? "" : " " + path);
+
+            const SearchTrace::Record& r = f.records[late[i]];
+            std::printf("  late cutoff at move %d after %llu wasted nodes: %s  [%d, %d] -> %d\n", r.cutoffIdx,
+                static_cast<unsigned long long>(wastedNodes(f, late[i])), path.c_str(), r.alpha, r.beta, r.score);
+        }
+    }
+    return 0;
+}
+
+
+void printDot(const Forest& f, const Tree& tree, const int node, const int maxPly){
+    const SearchTrace::Record& r = f.records[node];
+
+    const char* color = "white";
+    if(r.flags & SearchTrace::TERMINAL) color = "lightblue";
+    else if(r.flags & SearchTrace::LEAF) color = "gray90";
+    else if(r.cutoffIdx == 0) color = "palegreen";
+    else if(r.cutoffIdx > 0) color = "salmon";
+
+    std::printf("  n%d [label=\"%s\\n[%d, %d]\\nscore %d\\nnodes %u\" fillcolor=%s];\n", node, frameName(f, tree, node).c_str(),
+        r.alpha, r.beta, r.score, r.subtreeNodes, color);
+
+    if(r.ply >= maxPly) return;
+    for(int child : f.children[node]){
+        std::printf("  n%d -> n%d;\n", node, child);
+        printDot(f, tree, child, maxPly);
+    }
+}
+
+int dot(const Forest& f, int search, const int maxPly){
+    if(f.trees.empty()) return 1;
+    if(search < 0 || search >= static_cast<int>(f.trees.size())) search = static_cast<int>(f.trees.size()) - 1;
+    const Tree& tree = f.trees[search];
+
+    std::printf("digraph \"%s\" {\n  node [shape=box style=filled fontname=monospace];\n  root [label=\"%s\"];\n",
+        treeName(tree, search).c_str(), treeName(tree, search).c_str());
+    for(int node : tree.roots){
+        std::printf("  root -> n%d;\n", node);
+        printDot(f, tree, node, maxPly);
+    }
+    std::printf("}\n");
+    return 0;
+}
+
+
+// the dumped file read back: every record there, one search of the recorded depth with one root per legal move
+bool checkDump(const std::string& path, const SearchTrace& trace, const Connect4Engine::Board& board, const int depth){
+    std::vector<SearchTrace::Record> records;
+    std::string error;
+    if(!SearchTrace::load(path, records, &error)){
+        std::printf("CHECK FAILED: %s: %s\n", path.c_str(), error.c_str());
+        return false;
+    }
+    if(records.size() != trace.size()){
+        std::printf("CHECK FAILED: %zu records recorded, %zu read back\n", trace.size(), records.size());
+        return false;
+    }
+
+    int moves = 0;
+    for(int col = 0; col < Connect4Engine::WIDTH; ++col)
+        moves += Connect4Engine::landingCell(board.pieces[0] | board.pieces[1], col) >= 0;
+    const Forest f = buildForest(std::move(records));
+    if(f.trees.size() != 1 || f.trees[0].depth != depth || !f.trees[0].orphans.empty() || static_cast<int>(f.trees[0].roots.size()) != moves){
+        std::printf("CHECK FAILED: %zu searches read back, expected one of depth %d with %d root moves\n", f.trees.size(), depth, moves);
+        return false;
+    }
+    std::printf("check passed: %zu records read back, one depth %d search with %d root moves\n", trace.size(), depth, moves);
+    return true;
+}
+
+int record(int argc, char** argv){
+    if(argc < 7) return 2;
+
+    const uint64_t red = std::strtoull(argv[2], nullptr, 16);
+    const uint64_t yellow = std::strtoull(argv[3], nullptr, 16);
+    const auto toMove = static_cast<Connect4Engine::Color>(std::atoi(argv[4]) != 0);
+    const int depth = std::atoi(argv[5]);
+    int maxPly = 4;
+    bool check = false;
+    for(int i = 7; i < argc; ++i){
+        if(!std::strcmp(argv[i], "--max-ply") && i + 1 < argc) maxPly = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--check")) check = true;
+    }
+
+    SearchTrace trace(1 << 20, maxPly);
+    Connect4Engine engine;
+    engine.setBoard(red, yellow);
+    engine.setTrace(&trace);
+    const auto result = engine.searchRoot(toMove, depth);
+
+    std::printf("best cell %d score %d, %llu nodes, %zu records%s\n", result.bestMoveIdx, result.bestScore,
+        static_cast<unsigned long long>(engine.nodes()), trace.size(), trace.wrapped() ? " (wrapped)" : "");
+    if(!trace.dump(argv[6])) return 1;
+    return !check || checkDump(argv[6], trace, engine.board(), depth) ? 0 : 1;
+}
+
+void usage(const char* name){
+    std::fprintf(stderr,
+        "usage: %s record <red hex> <yellow hex> <0|1> <depth> <out.bin> [--max-ply N] [--check]\n"
+        "       %s summary <trace.bin>\n"
+        "       %s folded <trace.bin>\n"
+        "       %s dot <trace.bin> [--search N] [--max-ply N]\n", name, name, name, name);
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    if(argc < 3){
+        usage(argv[0]);
+        return 2;
+    }
+
+    const std::string command = argv[1];
+    if(command == "record"){
+        const int res = record(argc, argv);
+        if(res == 2) usage(argv[0]);
+        return res;
+    }
+
+    std::vector<SearchTrace::Record> records;
+    std::string error;
+    if(!SearchTrace::load(argv[2], records, &error)){
+        std::fprintf(stderr, "%s: %s\n", argv[2], error.c_str());
+        return 1;
+    }
+    const Forest forest = buildForest(std::move(records));
+
+    int search = -1, maxPly = SearchStats::MAX_PLY;
+    for(int i = 3; i + 1 < argc; i += 2){
+        if(!std::strcmp(argv[i], "--search")) search = std::atoi(argv[i + 1]);
+        else if(!std::strcmp(argv[i], "--max-ply")) maxPly = std::atoi(argv[i + 1]);
+    }
+
+    if(command == "summary") return summary(forest);
+    if(command == "folded") return folded(forest);
+    if(command == "dot") return dot(forest, search, maxPly);
+
+    usage(argv[0]);
+    return 2;
+}
@@ -0,0 +1,324 @@
+// Othello opening book builder
+//
+//   othello_book [--plies N] [--depth D] [--weights file] [--threads N] [--out book] [--check]
+//
+// expands every line from the start position N plies deep (a pass uses up a ply), each position stored once in
+// its canonical form so the 8 symmetric images and transpositions share a node. the positions at ply N are searched
+// to depth D by OthelloEngine (with the pattern tables of --weights if given), a side that has to pass at ply N
+// through its pass child. each leaf gets its own engine so the scores do not depend on which thread got which leaf,
+// spread over the thread pool. the scores are minimaxed back up to the root and every node goes into the book,
+// finished games with their exact result. prints the positions per ply, the leaf search rate and the book line
+// from the start.
+// --check maps the written file back in and verifies every position is found under all 8 symmetries with its score,
+// every inner score is the best of its children and the engine plays from the book, exits with 1 otherwise so it
+// can run under ctest
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../classes/OthelloBook.h"
+#include "../classes/OthelloEngine.h"
+#include "../classes/ThreadPool.h"
+
+namespace{
+
+// one engine per leaf, enough table for the leaf depths a book is built at
+constexpr size_t LEAF_TABLE_ENTRIES = size_t(1) << 18;
+// book depth of a finished game, its score is exact
+constexpr int32_t EXACT_DEPTH = OthelloBoard::SQUARES;
+
+struct Options{
+    std::string out;
+    std::string weights;
+    int plies = 8;
+    int depth = 10;
+    int threads = 0;
+    bool check = false;
+};
+
+struct Node{
+    uint64_t me;
+    uint64_t opp;
+    std::vector<uint32_t> children;     // after each move, the position after the pass when there is none
+    int32_t score = 0;
+    int32_t depth = 0;
+    bool terminal = false;              // neither side can move
+    bool scored = false;
+};
+
+struct KeyHash{
+    size_t operator()(const std::pair<uint64_t, uint64_t>& k) const{
+        uint64_t h = k.first * 0x9E3779B97F4A7C15ULL ^ (k.second + 0x632BE59BD9B4E019ULL) * 0xC2B2AE3D27D4EB4FULL;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+};
+
+// the opening tree as a DAG of canonical positions, root first
+class Tree{
+
+public:
+
+    uint32_t node(uint64_t me, uint64_t opp){
+        OthelloBook::canonical(me, opp);
+        const auto [it, added] = _index.try_emplace({me, opp}, static_cast<uint32_t>(nodes.size()));
+        if(added) nodes.push_back({me, opp, {}});
+        return it->second;
+    }
+
+    std::vector<Node> nodes;
+
+private:
+
+    std::unordered_map<std::pair<uint64_t, uint64_t>, uint32_t, KeyHash> _index;
+};
+
+// breadth first, returns the nodes of the last ply that are left to search
+std::vector<uint32_t> expand(Tree& tree, const int plies){
+    std::vector<uint32_t> level = {tree.node(OthelloBoard::START_BLACK, OthelloBoard::START_WHITE)};
+    std::printf("ply %2d %9zu positions\n", 0, level.size());
+
+    for(int ply = 1; ply <= plies; ++ply){
+        std::vector<uint32_t> next;
+        for(const uint32_t n : level){
+            const uint64_t me = tree.nodes[n].me, opp = tree.nodes[n].opp;
+            uint64_t moves = OthelloBoard::legalMoves(me, opp);
+            std::vector<uint32_t> children;
+            if(!moves){
+                if(!OthelloBoard::legalMoves(opp, me)){
+                    tree.nodes[n].terminal = true;
+                    continue;
+                }
+                children.push_back(tree.node(opp, me));
+            }
+            for(; moves; moves &= moves - 1){
+                const int sq = std::countr_zero(moves);
+                const uint64_t flipped = OthelloBoard::flips(me, opp, sq);
+                children.push_back(tree.node(opp & ~flipped, me | flipped | OthelloBoard::squareMask(sq)));
+            }
+            // symmetric moves lead to the same node
+            std::sort(children.begin(), children.end());
+            children.erase(std::unique(children.begin(), children.end()), children.end());
+            next.insert(next.end(), children.begin(), children.end());
+            tree.nodes[n].children = std::move(children);
+        }
+
+        std::sort(next.begin(), next.end());
+        next.erase(std::unique(next.begin(), next.end()), next.end());
+        level = std::move(next);
+        std::printf("ply %2d %9zu positions\n", ply, level.size());
+    }
+
+    // the last ply may still hold finished games, those are scored exactly instead of searched. a side that has to pass
+    // gets its pass child as the leaf, the engine has no move to search in the position itself
+    std::vector<uint32_t> leaves;
+    for(const uint32_t n : level){
+        const uint64_t me = tree.nodes[n].me, opp = tree.nodes[n].opp;
+        if(!tree.nodes[n].children.empty()) continue;
+        if(OthelloBoard::legalMoves(me, opp)){
+            leaves.push_back(n);
+        }else if(OthelloBoard::legalMoves(opp, me)){
+            const uint32_t pass = tree.node(opp, me);
+            tree.nodes[n].children = {pass};
+            if(tree.nodes[pass].children.empty()) leaves.push_back(pass);
+        }else{
+            tree.nodes[n].terminal = true;
+        }
+    }
+    std::sort(leaves.begin(), leaves.end());
+    leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+    return leaves;
+}
+
+void searchLeaves(Tree& tree, const std::vector<uint32_t>& leaves, const Options& opt, const OthelloPatterns& patterns,
+                  ThreadPool& pool){
+    const auto t0 = std::chrono::steady_clock::now();
+    std::atomic<uint64_t> nodes{0};
+    std::atomic<size_t> done{0};
+
+    pool.parallelFor(leaves.size(), [&](const size_t i){
+        Node& leaf = tree.nodes[leaves[i]];
+        OthelloEngine engine(LEAF_TABLE_ENTRIES, LEAF_TABLE_ENTRIES);
+        if(patterns.loaded()) engine.setPatterns(patterns);
+
+        const OthelloEngine::SearchResult result = engine.search(OthelloBoard(leaf.me, leaf.opp), OthelloBoard::BLACK, opt.depth);
+        leaf.score = result.score;
+        leaf.depth = result.exact ? EXACT_DEPTH : result.depth;
+        leaf.scored = true;
+        nodes += result.nodes;
+
+        const size_t finished = ++done;
+        if(finished % 100 == 0) std::fprintf(stderr, "\r%zu/%zu leaves", finished, leaves.size());
+    });
+    std::fprintf(stderr, "\r%zu/%zu leaves\n", leaves.size(), leaves.size());
+
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("searched %zu leaves to depth %d in %.1fs on %d threads: %.1f leaves/s, %.0f nodes/s\n", leaves.size(),
+        opt.depth, s, pool.workers(), s > 0 ? leaves.size() / s : 0.0, s > 0 ? nodes.load() / s : 0.0);
+}
+
+// negamax over the DAG, every node once
+void minimax(Tree& tree, const uint32_t n){
+    Node& node = tree.nodes[n];
+    if(node.scored) return;
+    node.scored = true;
+
+    if(node.terminal){
+        node.score = OthelloEngine::gameScore(OthelloEngine::finalDiscDiff(node.me, node.opp));
+        node.depth = EXACT_DEPTH;
+        return;
+    }
+
+    node.score = -OthelloEngine::INF_SCORE;
+    node.depth = EXACT_DEPTH;
+    for(const uint32_t c : node.children){
+        minimax(tree, c);
+        const Node& child = tree.nodes[c];
+        node.score = std::max(node.score, -child.score);
+        node.depth = std::min(node.depth, child.depth == EXACT_DEPTH ? EXACT_DEPTH : child.depth + 1);
+    }
+}
+
+std::string squareName(const int sq){
+    return {static_cast<char>('a' + sq % 8), static_cast<char>('1' + sq / 8)};
+}
+
+// the moves both sides play from the start while the position is in the book
+void printBookLine(const OthelloBook& book){
+    uint64_t me = OthelloBoard::START_BLACK, opp = OthelloBoard::START_WHITE;
+    int score = 0;
+    std::string line;
+    for(int move; (move = book.bestMove(me, opp, line.empty() ? &score : nullptr)) >= 0; ){
+        line += squareName(move) + " ";
+        const uint64_t flipped = OthelloBoard::flips(me, opp, move);
+        const uint64_t next = opp & ~flipped;
+        opp = me | flipped | OthelloBoard::squareMask(move);
+        me = next;
+        if(!OthelloBoard::legalMoves(me, opp)) std::swap(me, opp);
+    }
+    std::printf("book line: %s(black scores %d)\n", line.c_str(), score);
+}
+
+bool checkBook(const Options& opt, const Tree& tree){
+    OthelloBook book;
+    std::string error;
+    if(!book.load(opt.out, &error)){
+        std::printf("CHECK FAILED: %s\n", error.c_str());
+        return false;
+    }
+    if(book.size() != tree.nodes.size()){
+        std::printf("CHECK FAILED: %zu entries in the book, %zu positions in the tree\n", book.size(), tree.nodes.size());
+        return false;
+    }
+
+    for(const Node& node : tree.nodes){
+        for(int s = 0; s < OthelloBoard::SYMMETRIES; ++s){
+            const OthelloBook::Entry* e = book.find(OthelloBoard::transform(node.me, s), OthelloBoard::transform(node.opp, s));
+            if(!e || e->score != node.score || e->depth != node.depth){
+                std::printf("CHECK FAILED: %s symmetry %d %s\n", OthelloBoard(node.me, node.opp).stateString().c_str(), s,
+                    e ? "has the wrong score" : "is missing");
+                return false;
+            }
+        }
+
+        // everything but a finished game has a search of at least one ply behind its score
+        if(!node.terminal && node.depth < 1){
+            std::printf("CHECK FAILED: %s was never searched\n", OthelloBoard(node.me, node.opp).stateString().c_str());
+            return false;
+        }
+
+        // an inner position scores what its best move gets, through a pass the negated score of the other side
+        if(node.terminal || node.children.empty()) continue;
+        int best;
+        if(OthelloBoard::legalMoves(node.me, node.opp)){
+            if(book.bestMove(node.me, node.opp, &best) < 0) best = -OthelloEngine::INF_SCORE;
+        }else{
+            best = -book.find(node.opp, node.me)->score;
+        }
+        if(best != node.score){
+            std::printf("CHECK FAILED: %s scores %d, its best child %d\n", OthelloBoard(node.me, node.opp).stateString().c_str(),
+                node.score, best);
+            return false;
+        }
+    }
+
+    OthelloEngine engine(LEAF_TABLE_ENTRIES, LEAF_TABLE_ENTRIES);
+    engine.setBook(book);
+    const OthelloEngine::SearchResult result = engine.search(OthelloBoard(), OthelloBoard::BLACK, opt.depth);
+    if(!result.book || result.nodes != 0 || !OthelloBoard().isLegal(OthelloBoard::BLACK, result.bestMove)){
+        std::printf("CHECK FAILED: the engine searched the start position instead of playing from the book\n");
+        return false;
+    }
+
+    std::printf("check passed: %zu positions found under all symmetries, scores minimaxed, engine plays %s from the book\n",
+        book.size(), squareName(result.bestMove).c_str());
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& opt){
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--plies") && hasValue) opt.plies = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--depth") && hasValue) opt.depth = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--weights") && hasValue) opt.weights = argv[++i];
+        else if(!std::strcmp(argv[i], "--threads") && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--out") && hasValue) opt.out = argv[++i];
+        else if(!std::strcmp(argv[i], "--check")) opt.check = true;
+        else return false;
+    }
+    return opt.plies >= 1 && opt.depth >= 1 && !(opt.check && opt.out.empty());
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    Options opt;
+    if(!parseOptions(argc, argv, opt)){
+        std::fprintf(stderr, "usage: %s [--plies N] [--depth D] [--weights file] [--threads N] [--out book] [--check]\n", argv[0]);
+        return 2;
+    }
+
+    std::unique_ptr<ThreadPool> ownPool;
+    if(opt.threads > 0) ownPool = std::make_unique<ThreadPool>(opt.threads);
+    ThreadPool& pool = ownPool ? *ownPool : ThreadPool::shared();
+
+    OthelloPatterns patterns;
+    std::string error;
+    if(!opt.weights.empty() && !patterns.loadWeights(opt.weights, &error)){
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    Tree tree;
+    const std::vector<uint32_t> leaves = expand(tree, opt.plies);
+    searchLeaves(tree, leaves, opt, patterns, pool);
+    minimax(tree, 0);
+
+    std::vector<OthelloBook::Entry> entries;
+    entries.reserve(tree.nodes.size());
+    for(const Node& node : tree.nodes) entries.push_back({node.me, node.opp, node.score, node.depth});
+    std::printf("%zu book positions, %zu bytes\n", entries.size(), OthelloBook::HEADER_BYTES + entries.size() * sizeof(OthelloBook::Entry));
+
+    if(!opt.out.empty()){
+        if(!OthelloBook::save(opt.out, std::move(entries), &error)){
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+        std::printf("wrote %s\n", opt.out.c_str());
+
+        OthelloBook book;
+        if(book.load(opt.out, &error)) printBookLine(book);
+    }
+
+    if(opt.check && !checkBook(opt, tree)) return 1;
+    return 0;
+}
@@ -0,0 +1,280 @@
+// exact Othello endgame solves with timing
+//
+//   othello_endgame <positions file> [--threads N] [--split E]
+//   othello_endgame --random N [--empties E] [--seed S] [--threads N] [--split E]
+//
+// a positions file has one position per line: "<state> <b|w> [score]", state is the 64 character Othello::stateString()
+// (0 empty, 1 black, 2 white, row by row from a1), b or w the side to move, score the known disc differential for
+// it. '#' starts a comment. prints the best move, exact score, nodes and nodes/sec of every position
+// random mode plays N seeded random games down to E empty squares and checks the solver's score against
+// OthelloEngine::negamax searched to the end of the game
+// --threads N solves every position again with the young brothers wait split on pools of 1..N threads (nodes with at
+// least E empties split, default OthelloEndgame::DEFAULT_SPLIT_EMPTIES), each run from an empty table. the scores
+// have to match the serial solve and the parallel best move has to reach it. prints the speedup over the serial
+// solve and the search overhead (extra nodes) per thread count
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../classes/OthelloEndgame.h"
+#include "../classes/OthelloEngine.h"
+#include "../classes/ThreadPool.h"
+
+namespace{
+
+struct Options{
+    std::string input;
+    int random = 0;
+    int empties = 14;
+    unsigned seed = 1;
+    int threads = 0;
+    int split = OthelloEndgame::DEFAULT_SPLIT_EMPTIES;
+};
+
+// one solver per thread count, runs[0] is the serial one
+struct ThreadRun{
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<OthelloEndgame> solver;
+    uint64_t nodes = 0;
+    double ms = 0;
+};
+
+std::string squareName(const int sq){
+    if(sq < 0) return "pass";
+    return std::string(1, static_cast<char>('a' + sq % 8)) + static_cast<char>('1' + sq / 8);
+}
+
+// random game from the start position, false if it ended before reaching the wanted number of empties
+bool randomPosition(std::mt19937& rng, const int empties, OthelloBoard& board, OthelloBoard::Color& toMove){
+    board = OthelloBoard();
+    toMove = OthelloBoard::BLACK;
+
+    while(board.emptyCount() > empties){
+        uint64_t moves = board.legal(toMove);
+        if(!moves){
+            if(!board.legal(static_cast<OthelloBoard::Color>(!toMove))) return false;
+            toMove = static_cast<OthelloBoard::Color>(!toMove);
+            continue;
+        }
+        for(int skip = static_cast<int>(rng() % std::popcount(moves)); skip > 0; --skip) moves &= moves - 1;
+        board.play(toMove, std::countr_zero(moves));
+        toMove = static_cast<OthelloBoard::Color>(!toMove);
+    }
+    return true;
+}
+
+std::vector<ThreadRun> makeRuns(const Options& opt){
+    std::vector<ThreadRun> runs(opt.threads + 1);
+    for(int t = 0; t <= opt.threads; ++t){
+        runs[t].solver = std::make_unique<OthelloEndgame>();
+        if(t == 0) continue;
+        runs[t].pool = std::make_unique<ThreadPool>(t);
+        runs[t].solver->setThreadPool(runs[t].pool.get(), opt.split);
+    }
+    return runs;
+}
+
+// the position solved by every run from an empty table, false on a score the serial solve disagrees with
+bool compareThreads(std::vector<ThreadRun>& runs, const OthelloBoard& board, const OthelloBoard::Color toMove, const int index,
+                    int& score){
+    const uint64_t me = board.discs(toMove), opp = board.discs(static_cast<OthelloBoard::Color>(!toMove));
+    std::vector<OthelloEndgame::Result> results;
+    std::vector<double> times;
+    for(ThreadRun& run : runs){
+        run.solver->clearTable();
+        const auto t0 = std::chrono::steady_clock::now();
+        results.push_back(run.solver->solve(board, toMove));
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+        run.nodes += results.back().nodes;
+        run.ms += times.back();
+    }
+
+    const OthelloEndgame::Result& serial = results[0];
+    score = serial.score;
+    std::printf("#%-3d %2d empties %+3d  serial %12llu nodes %9.1fms", index, board.emptyCount(), serial.score,
+        static_cast<unsigned long long>(serial.nodes), times[0]);
+    for(size_t t = 1; t < runs.size(); ++t)
+        std::printf("  | %zu: %5.2fx %+4.0f%%", t, times[t] > 0 ? times[0] / times[t] : 0.0,
+            serial.nodes ? 100.0 * results[t].nodes / serial.nodes - 100.0 : 0.0);
+    std::printf("\n");
+
+    for(size_t t = 1; t < runs.size(); ++t){
+        int moveScore = results[t].score;
+        if(results[t].bestMove >= 0){
+            const uint64_t flipped = OthelloBoard::flips(me, opp, results[t].bestMove);
+            moveScore = -runs[0].solver->search(opp & ~flipped, me | flipped | OthelloBoard::squareMask(results[t].bestMove),
+                                                -OthelloEndgame::MAX_SCORE - 1, OthelloEndgame::MAX_SCORE + 1);
+        }
+        if(results[t].score != serial.score || moveScore != serial.score){
+            std::printf("MISMATCH %s %c: %zu threads score %d move %s scores %d, serial %d\n", board.stateString().c_str(),
+                toMove == OthelloBoard::BLACK ? 'b' : 'w', t, results[t].score, squareName(results[t].bestMove).c_str(),
+                moveScore, serial.score);
+            return false;
+        }
+    }
+    return true;
+}
+
+void printThreadSummary(const std::vector<ThreadRun>& runs){
+    const ThreadRun& serial = runs[0];
+    std::printf("threads %14s %12s %8s %9s\n", "nodes", "ms", "speedup", "overhead");
+    std::printf("serial  %14llu %12.1f\n", static_cast<unsigned long long>(serial.nodes), serial.ms);
+    for(size_t t = 1; t < runs.size(); ++t)
+        std::printf("%-7zu %14llu %12.1f %7.2fx %+8.1f%%\n", t, static_cast<unsigned long long>(runs[t].nodes), runs[t].ms,
+            runs[t].ms > 0 ? serial.ms / runs[t].ms : 0.0, serial.nodes ? 100.0 * runs[t].nodes / serial.nodes - 100.0 : 0.0);
+}
+
+int runRandom(const Options& opt){
+    std::mt19937 rng(opt.seed);
+    OthelloEndgame solver;
+    OthelloEngine engine;
+    engine.setEndgameEmpties(0);
+    std::vector<ThreadRun> runs = makeRuns(opt);
+
+    uint64_t nodes = 0;
+    double ms = 0;
+    for(int tested = 0; tested < opt.random;){
+        OthelloBoard board;
+        OthelloBoard::Color toMove;
+        if(!randomPosition(rng, opt.empties, board, toMove)) continue;
+
+        const auto t0 = std::chrono::steady_clock::now();
+        const OthelloEndgame::Result solved = solver.solve(board, toMove);
+        ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        nodes += solved.nodes;
+
+        const uint64_t me = board.discs(toMove), opp = board.discs(static_cast<OthelloBoard::Color>(!toMove));
+        const int expected = engine.negamax(me, opp, -OthelloEngine::INF_SCORE, OthelloEngine::INF_SCORE, OthelloBoard::SQUARES);
+
+        // the best move has to reach the same score
+        int moveScore = solved.score;
+        if(solved.bestMove >= 0){
+            const uint64_t flipped = OthelloBoard::flips(me, opp, solved.bestMove);
+            moveScore = -solver.search(opp & ~flipped, me | flipped | OthelloBoard::squareMask(solved.bestMove),
+                                       -OthelloEndgame::MAX_SCORE - 1, OthelloEndgame::MAX_SCORE + 1);
+        }
+
+        if(OthelloEngine::gameScore(solved.score) != expected || moveScore != solved.score){
+            std::printf("MISMATCH position %d %s %c solver=%d move %s scores %d negamax=%d\n", tested, board.stateString().c_str(),
+                toMove == OthelloBoard::BLACK ? 'b' : 'w', solved.score, squareName(solved.bestMove).c_str(), moveScore, expected);
+            return 1;
+        }
+        int serialScore;
+        if(opt.threads > 0 && !compareThreads(runs, board, toMove, tested + 1, serialScore)) return 1;
+        ++tested;
+    }
+
+    std::printf("%d positions with %d empties, solver matches negamax\n", opt.random, opt.empties);
+    std::printf("nodes %llu time %.1fms %.0f nodes/s\n", static_cast<unsigned long long>(nodes), ms, ms > 0 ? nodes * 1000.0 / ms : 0.0);
+    if(opt.threads > 0){
+        std::printf("parallel solves match the serial solver on 1..%d threads\n", opt.threads);
+        printThreadSummary(runs);
+    }
+    return 0;
+}
+
+int runFile(const Options& opt){
+    std::ifstream in(opt.input);
+    if(!in){
+        std::fprintf(stderr, "cannot open %s\n", opt.input.c_str());
+        return 2;
+    }
+
+    OthelloEndgame solver;
+    std::vector<ThreadRun> runs = makeRuns(opt);
+    uint64_t totalNodes = 0;
+    double totalMs = 0;
+    int count = 0, failed = 0;
+
+    std::string line;
+    while(std::getline(in, line)){
+        const size_t comment = line.find('#');
+        if(comment != std::string::npos) line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string state, side;
+        if(!(fields >> state >> side)) continue;
+        int expected = 0;
+        const bool hasExpected = static_cast<bool>(fields >> expected);
+
+        OthelloBoard board;
+        if(!board.setStateString(state) || (side != "b" && side != "w")){
+            std::fprintf(stderr, "bad position: %s\n", line.c_str());
+            return 2;
+        }
+        const OthelloBoard::Color toMove = side == "b" ? OthelloBoard::BLACK : OthelloBoard::WHITE;
+
+        if(opt.threads > 0){
+            ++count;
+            int score;
+            if(!compareThreads(runs, board, toMove, count, score)) return 1;
+            if(hasExpected && score != expected){
+                std::printf("MISMATCH #%d: expected %+d\n", count, expected);
+                ++failed;
+            }
+            continue;
+        }
+
+        const auto t0 = std::chrono::steady_clock::now();
+        const OthelloEndgame::Result solved = solver.solve(board, toMove);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        totalNodes += solved.nodes;
+        totalMs += ms;
+        ++count;
+
+        const bool ok = !hasExpected || solved.score == expected;
+        failed += !ok;
+        std::printf("#%-3d %2d empties  %-4s %+3d  %12llu nodes %10.1fms %12.0f nodes/s%s\n", count, board.emptyCount(),
+            squareName(solved.bestMove).c_str(), solved.score, static_cast<unsigned long long>(solved.nodes), ms,
+            ms > 0 ? solved.nodes * 1000.0 / ms : 0.0, ok ? "" : "  MISMATCH");
+    }
+
+    if(opt.threads > 0){
+        printThreadSummary(runs);
+        return failed ? 1 : 0;
+    }
+    std::printf("%d positions, %llu nodes, %.1fms, %.0f nodes/s\n", count, static_cast<unsigned long long>(totalNodes), totalMs,
+        totalMs > 0 ? totalNodes * 1000.0 / totalMs : 0.0);
+    return failed ? 1 : 0;
+}
+
+bool parseOptions(int argc, char** argv, Options& opt){
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--random") && hasValue) opt.random = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--empties") && hasValue) opt.empties = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--seed") && hasValue) opt.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if(!std::strcmp(argv[i], "--threads") && hasValue) opt.threads = std::max(0, std::atoi(argv[++i]));
+        else if(!std::strcmp(argv[i], "--split") && hasValue) opt.split = std::atoi(argv[++i]);
+        else if(argv[i][0] != '-' && opt.input.empty()) opt.input = argv[i];
+        else{
+            opt.input.clear();
+            opt.random = 0;
+            break;
+        }
+    }
+    if(opt.input.empty() && opt.random <= 0){
+        std::fprintf(stderr, "usage: %s <positions file> | --random N [--empties E] [--seed S] [--threads N] [--split E]\n", argv[0]);
+        return false;
+    }
+    return true;
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    Options opt;
+    if(!parseOptions(argc, argv, opt)) return 2;
+    return opt.random > 0 ? runRandom(opt) : runFile(opt);
+}
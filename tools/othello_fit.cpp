@@ -0,0 +1,448 @@
+// offline least squares fit of the OthelloPatterns tables
+//
+//   othello_fit [positions files...] [--selfplay N] [--depth D] [--random-plies R] [--solve E] [--seed S]
+//               [--weights file] [--save-samples file] [--iterations K] [--lambda L] [--holdout H] [--threads N]
+//               [--out weights] [--check]
+//
+// positions files use the othello_endgame format, "<state> <b|w> <score>" with the final disc differential for the
+// side to move, so solved positions can be fed straight in. --selfplay N adds N seeded games: R random plies, then
+// both sides search to depth D (with the pattern tables of --weights if given) and solve exactly from E empties.
+// every position after the random plies is labelled with the final result, from E empties on that result is exact.
+// --save-samples writes the collected positions back out in the same format
+//
+// each position enters the fit under all 8 board symmetries. the tables are fitted by damped conjugate gradient
+// least squares (CGLS): minimise |Aw - t|^2 + lambda |w|^2 with A the 0/1 feature matrix, every pass is a gather
+// over the positions and a gather over the weights (through a transposed index) spread over the thread pool.
+// every H-th game and every H-th input line (default 10) is held out and only scored, so no position of a held out
+// game and none of its symmetries is fitted. --check reloads the written file and verifies that the evaluator
+// reproduces the fit and beats a constant prediction
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../classes/OthelloEngine.h"
+#include "../classes/OthelloPatterns.h"
+#include "../classes/ThreadPool.h"
+
+namespace{
+
+// self-play engines are short lived and many run at once, small tables are plenty at these depths
+constexpr size_t SELFPLAY_TABLE_ENTRIES = size_t(1) << 16;
+// chunks of work handed to the pool per pass
+constexpr size_t FIT_BLOCKS = 256;
+
+struct Options{
+    std::vector<std::string> inputs;
+    std::string out;
+    std::string weights;
+    std::string saveSamples;
+    int selfplay = 0;
+    int depth = 4;
+    int randomPlies = 10;
+    int solve = 12;
+    unsigned seed = 1;
+    int iterations = 50;
+    double lambda = 1.0;
+    int holdout = 10;
+    int threads = 0;
+    bool check = false;
+};
+
+struct Sample{
+    uint64_t me;
+    uint64_t opp;
+    float target;       // final disc differential for the side to move
+    uint32_t group;     // input line or selfplay game, held out as a whole
+};
+
+// features of every training row with the phase block already added
+struct Rows{
+    std::vector<uint32_t> features;     // FEATURES per row
+    std::vector<double> targets;
+};
+
+// weight -> rows containing it
+struct Columns{
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> rows;
+};
+
+constexpr size_t TOTAL_WEIGHTS = static_cast<size_t>(OthelloPatterns::PHASES) * OthelloPatterns::PHASE_WEIGHTS;
+constexpr int FEATURES = OthelloPatterns::FEATURES;
+
+using Color = OthelloBoard::Color;
+
+Color other(const Color c){ return static_cast<Color>(!c); }
+
+
+bool readPositions(const std::string& path, std::vector<Sample>& samples){
+    std::ifstream in(path);
+    if(!in){
+        std::fprintf(stderr, "cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    while(std::getline(in, line)){
+        const size_t comment = line.find('#');
+        if(comment != std::string::npos) line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string state, side;
+        float score;
+        if(!(fields >> state)) continue;
+
+        OthelloBoard board;
+        if(!(fields >> side >> score) || !board.setStateString(state) || (side != "b" && side != "w")){
+            std::fprintf(stderr, "%s: bad position, scores are required: %s\n", path.c_str(), line.c_str());
+            return false;
+        }
+        const Color toMove = side == "b" ? OthelloBoard::BLACK : OthelloBoard::WHITE;
+        samples.push_back({board.discs(toMove), board.discs(other(toMove)), score, static_cast<uint32_t>(samples.size())});
+    }
+    return true;
+}
+
+bool writePositions(const std::string& path, const std::vector<Sample>& samples){
+    std::ofstream out(path, std::ios::trunc);
+    out << "# othello_fit samples: <state> <side to move> <final disc differential for it>\n";
+    for(const Sample& s : samples){
+        // stored from black's side, the state string has no side to move of its own
+        out << OthelloBoard(s.me, s.opp).stateString() << " b " << s.target << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+// one seeded game, positions from the mover's side labelled with the final result
+std::vector<Sample> playGame(const Options& opt, const OthelloPatterns& patterns, const int game){
+    std::mt19937 rng(opt.seed * 1000003u + static_cast<unsigned>(game));
+    OthelloEngine engine(SELFPLAY_TABLE_ENTRIES, SELFPLAY_TABLE_ENTRIES);
+    engine.setEndgameEmpties(opt.solve);
+    if(patterns.loaded()) engine.setPatterns(patterns);
+
+    OthelloBoard board;
+    Color toMove = OthelloBoard::BLACK;
+    std::vector<std::pair<Sample, Color>> positions;
+
+    for(int ply = 0; !board.gameOver(); ++ply){
+        uint64_t moves = board.legal(toMove);
+        if(!moves){
+            toMove = other(toMove);
+            continue;
+        }
+
+        int move;
+        if(ply < opt.randomPlies){
+            for(int skip = static_cast<int>(rng() % std::popcount(moves)); skip > 0; --skip) moves &= moves - 1;
+            move = std::countr_zero(moves);
+        }else{
+            positions.push_back({{board.discs(toMove), board.discs(other(toMove)), 0.0f, static_cast<uint32_t>(game)}, toMove});
+            move = engine.search(board, toMove, opt.depth).bestMove;
+        }
+        board.play(toMove, move);
+        toMove = other(toMove);
+    }
+
+    const int blackDiff = OthelloEngine::finalDiscDiff(board.discs(OthelloBoard::BLACK), board.discs(OthelloBoard::WHITE));
+    std::vector<Sample> samples;
+    samples.reserve(positions.size());
+    for(auto& [sample, mover] : positions){
+        sample.target = static_cast<float>(mover == OthelloBoard::BLACK ? blackDiff : -blackDiff);
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+std::vector<Sample> selfplay(const Options& opt, const OthelloPatterns& patterns, ThreadPool& pool){
+    std::vector<std::vector<Sample>> games(opt.selfplay);
+    std::atomic<int> done{0};
+    pool.parallelFor(games.size(), [&](const size_t i){
+        games[i] = playGame(opt, patterns, static_cast<int>(i));
+        const int finished = ++done;
+        if(finished % 10 == 0) std::fprintf(stderr, "\r%d/%d games", finished, opt.selfplay);
+    });
+    std::fprintf(stderr, "\r%d/%d games\n", opt.selfplay, opt.selfplay);
+
+    std::vector<Sample> samples;
+    for(const auto& g : games) samples.insert(samples.end(), g.begin(), g.end());
+    return samples;
+}
+
+
+// fn(begin, end) over [0, n) in FIT_BLOCKS pieces
+template <class F>
+void forRanges(ThreadPool& pool, const size_t n, F&& fn){
+    const size_t blocks = std::min(n, FIT_BLOCKS);
+    pool.parallelFor(blocks, [&](const size_t b){ fn(n * b / blocks, n * (b + 1) / blocks); });
+}
+
+// sum of fn(begin, end) over the ranges, added up in range order so the result does not depend on the threads
+template <class F>
+double sumRanges(ThreadPool& pool, const size_t n, F&& fn){
+    std::vector<double> parts(std::min(n, FIT_BLOCKS), 0.0);
+    pool.parallelFor(parts.size(), [&](const size_t b){ parts[b] = fn(n * b / parts.size(), n * (b + 1) / parts.size()); });
+    double sum = 0;
+    for(double p : parts) sum += p;
+    return sum;
+}
+
+Rows buildRows(const std::vector<Sample>& samples){
+    Rows rows;
+    rows.features.reserve(samples.size() * OthelloBoard::SYMMETRIES * FEATURES);
+    rows.targets.reserve(samples.size() * OthelloBoard::SYMMETRIES);
+
+    std::array<uint32_t, FEATURES> f;
+    for(const Sample& s : samples){
+        for(int sym = 0; sym < OthelloBoard::SYMMETRIES; ++sym){
+            const uint64_t me = OthelloBoard::transform(s.me, sym), opp = OthelloBoard::transform(s.opp, sym);
+            const uint32_t phaseBase = static_cast<uint32_t>(OthelloPatterns::phase(me, opp)) * OthelloPatterns::PHASE_WEIGHTS;
+            OthelloPatterns::features(me, opp, f);
+            for(uint32_t x : f) rows.features.push_back(phaseBase + x);
+            rows.targets.push_back(s.target);
+        }
+    }
+    return rows;
+}
+
+// instances of one pattern often read the same index (two empty diagonals), such a weight is in the row twice and
+// the transposed index lists the row twice, so A^T stays the exact transpose
+Columns transpose(const Rows& rows){
+    Columns cols;
+    cols.offsets.assign(TOTAL_WEIGHTS + 1, 0);
+    for(uint32_t f : rows.features) ++cols.offsets[f + 1];
+    for(size_t w = 0; w < TOTAL_WEIGHTS; ++w) cols.offsets[w + 1] += cols.offsets[w];
+
+    cols.rows.resize(rows.features.size());
+    std::vector<uint32_t> next(cols.offsets.begin(), cols.offsets.end() - 1);
+    for(size_t i = 0; i < rows.features.size(); ++i) cols.rows[next[rows.features[i]]++] = static_cast<uint32_t>(i / FEATURES);
+    return cols;
+}
+
+// out = A x
+void multiply(ThreadPool& pool, const Rows& rows, const std::vector<double>& x, std::vector<double>& out){
+    forRanges(pool, out.size(), [&](const size_t begin, const size_t end){
+        for(size_t r = begin; r < end; ++r){
+            const uint32_t* f = &rows.features[r * FEATURES];
+            double sum = 0;
+            for(int k = 0; k < FEATURES; ++k) sum += x[f[k]];
+            out[r] = sum;
+        }
+    });
+}
+
+// out = A^T y - lambda x
+void multiplyTransposed(ThreadPool& pool, const Columns& cols, const std::vector<double>& y, const std::vector<double>& x,
+                        const double lambda, std::vector<double>& out){
+    forRanges(pool, out.size(), [&](const size_t begin, const size_t end){
+        for(size_t w = begin; w < end; ++w){
+            double sum = 0;
+            for(uint32_t i = cols.offsets[w]; i < cols.offsets[w + 1]; ++i) sum += y[cols.rows[i]];
+            out[w] = sum - lambda * x[w];
+        }
+    });
+}
+
+double squaredNorm(ThreadPool& pool, const std::vector<double>& v){
+    return sumRanges(pool, v.size(), [&](const size_t begin, const size_t end){
+        double sum = 0;
+        for(size_t i = begin; i < end; ++i) sum += v[i] * v[i];
+        return sum;
+    });
+}
+
+std::vector<double> fit(ThreadPool& pool, const Rows& rows, const Options& opt){
+    const auto t0 = std::chrono::steady_clock::now();
+    const Columns cols = transpose(rows);
+    const size_t n = rows.targets.size();
+
+    std::vector<double> x(TOTAL_WEIGHTS, 0.0), s(TOTAL_WEIGHTS), p(TOTAL_WEIGHTS);
+    std::vector<double> r = rows.targets, q(n);
+
+    multiplyTransposed(pool, cols, r, x, opt.lambda, s);
+    p = s;
+    double gamma = squaredNorm(pool, s);
+
+    for(int it = 1; it <= opt.iterations && gamma > 0; ++it){
+        multiply(pool, rows, p, q);
+        const double alpha = gamma / (squaredNorm(pool, q) + opt.lambda * squaredNorm(pool, p));
+
+        forRanges(pool, TOTAL_WEIGHTS, [&](const size_t begin, const size_t end){
+            for(size_t w = begin; w < end; ++w) x[w] += alpha * p[w];
+        });
+        forRanges(pool, n, [&](const size_t begin, const size_t end){
+            for(size_t i = begin; i < end; ++i) r[i] -= alpha * q[i];
+        });
+
+        multiplyTransposed(pool, cols, r, x, opt.lambda, s);
+        const double next = squaredNorm(pool, s);
+        const double beta = next / gamma;
+        gamma = next;
+        forRanges(pool, TOTAL_WEIGHTS, [&](const size_t begin, const size_t end){
+            for(size_t w = begin; w < end; ++w) p[w] = s[w] + beta * p[w];
+        });
+
+        if(it % 10 == 0 || it == opt.iterations)
+            std::printf("iteration %3d  rms error %.3f discs\n", it, std::sqrt(squaredNorm(pool, r) / n));
+    }
+
+    std::printf("fit of %zu rows over %zu weights took %.1fs\n", n, TOTAL_WEIGHTS,
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+    return x;
+}
+
+std::vector<int16_t> quantize(const std::vector<double>& x){
+    std::vector<int16_t> weights(x.size());
+    for(size_t w = 0; w < x.size(); ++w)
+        weights[w] = static_cast<int16_t>(std::clamp(std::lround(x[w] * OthelloPatterns::UNITS_PER_DISC), -32767L, 32767L));
+    return weights;
+}
+
+// root mean square error in discs of the evaluator, and of always predicting 0
+void score(const OthelloPatterns& patterns, const std::vector<Sample>& samples, double& rms, double& zeroRms){
+    double err = 0, zero = 0;
+    for(const Sample& s : samples){
+        const double e = patterns.evaluate(s.me, s.opp) / double(OthelloPatterns::UNITS_PER_DISC) - s.target;
+        err += e * e;
+        zero += double(s.target) * s.target;
+    }
+    rms = samples.empty() ? 0 : std::sqrt(err / samples.size());
+    zeroRms = samples.empty() ? 0 : std::sqrt(zero / samples.size());
+}
+
+// the reloaded file has to give the fitted prediction up to rounding of each looked up weight
+bool checkWeights(const Options& opt, const std::vector<double>& x, const std::vector<Sample>& train){
+    OthelloPatterns reloaded;
+    std::string error;
+    if(!reloaded.loadWeights(opt.out, &error)){
+        std::printf("CHECK FAILED: %s\n", error.c_str());
+        return false;
+    }
+
+    std::array<uint32_t, FEATURES> f;
+    for(const Sample& s : train){
+        OthelloPatterns::features(s.me, s.opp, f);
+        const size_t base = static_cast<size_t>(OthelloPatterns::phase(s.me, s.opp)) * OthelloPatterns::PHASE_WEIGHTS;
+        double fitted = 0;
+        for(uint32_t k : f) fitted += x[base + k];
+        const double diff = std::fabs(reloaded.evaluate(s.me, s.opp) - fitted * OthelloPatterns::UNITS_PER_DISC);
+        if(diff > FEATURES * 0.5 + 1e-6){
+            std::printf("CHECK FAILED: evaluator %d, fit %.1f for %s\n", reloaded.evaluate(s.me, s.opp),
+                fitted * OthelloPatterns::UNITS_PER_DISC, OthelloBoard(s.me, s.opp).stateString().c_str());
+            return false;
+        }
+    }
+
+    double rms, zeroRms;
+    score(reloaded, train, rms, zeroRms);
+    if(!(rms < zeroRms)){
+        std::printf("CHECK FAILED: training error %.3f is not below the constant prediction's %.3f\n", rms, zeroRms);
+        return false;
+    }
+    std::printf("check passed: %zu positions reproduced by the reloaded weights\n", train.size());
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, Options& opt){
+    for(int i = 1; i < argc; ++i){
+        const bool hasValue = i + 1 < argc;
+        if(!std::strcmp(argv[i], "--selfplay") && hasValue) opt.selfplay = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--depth") && hasValue) opt.depth = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--random-plies") && hasValue) opt.randomPlies = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--solve") && hasValue) opt.solve = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--seed") && hasValue) opt.seed = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        else if(!std::strcmp(argv[i], "--weights") && hasValue) opt.weights = argv[++i];
+        else if(!std::strcmp(argv[i], "--save-samples") && hasValue) opt.saveSamples = argv[++i];
+        else if(!std::strcmp(argv[i], "--iterations") && hasValue) opt.iterations = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--lambda") && hasValue) opt.lambda = std::atof(argv[++i]);
+        else if(!std::strcmp(argv[i], "--holdout") && hasValue) opt.holdout = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--threads") && hasValue) opt.threads = std::atoi(argv[++i]);
+        else if(!std::strcmp(argv[i], "--out") && hasValue) opt.out = argv[++i];
+        else if(!std::strcmp(argv[i], "--check")) opt.check = true;
+        else if(argv[i][0] != '-') opt.inputs.push_back(argv[i]);
+        else return false;
+    }
+    return (!opt.inputs.empty() || opt.selfplay > 0) && !(opt.check && opt.out.empty());
+}
+
+}
+
+
+
+int main(int argc, char** argv){
+    Options opt;
+    if(!parseOptions(argc, argv, opt)){
+        std::fprintf(stderr, "usage: %s [positions files...] [--selfplay N] [--depth D] [--random-plies R] [--solve E] [--seed S]\n"
+                             "       [--weights file] [--save-samples file] [--iterations K] [--lambda L] [--holdout H] [--threads N]\n"
+                             "       [--out weights] [--check]\n", argv[0]);
+        return 2;
+    }
+
+    std::unique_ptr<ThreadPool> ownPool;
+    if(opt.threads > 0) ownPool = std::make_unique<ThreadPool>(opt.threads);
+    ThreadPool& pool = ownPool ? *ownPool : ThreadPool::shared();
+
+    OthelloPatterns selfplayPatterns;
+    std::string error;
+    if(!opt.weights.empty() && !selfplayPatterns.loadWeights(opt.weights, &error)){
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+
+    std::vector<Sample> samples;
+    for(const std::string& path : opt.inputs)
+        if(!readPositions(path, samples)) return 2;
+    if(opt.selfplay > 0){
+        // games are numbered on from the input lines
+        const uint32_t lines = static_cast<uint32_t>(samples.size());
+        for(Sample s : selfplay(opt, selfplayPatterns, pool)){
+            s.group += lines;
+            samples.push_back(s);
+        }
+    }
+    if(!opt.saveSamples.empty() && !writePositions(opt.saveSamples, samples)){
+        std::fprintf(stderr, "could not write %s\n", opt.saveSamples.c_str());
+        return 2;
+    }
+
+    std::vector<Sample> train, holdout;
+    for(const Sample& s : samples)
+        (opt.holdout > 0 && s.group % opt.holdout == static_cast<uint32_t>(opt.holdout - 1) ? holdout : train).push_back(s);
+    if(train.empty()){
+        std::fprintf(stderr, "no training positions\n");
+        return 2;
+    }
+    std::printf("%zu training positions, %zu held out, %d threads\n", train.size(), holdout.size(), pool.workers());
+
+    const std::vector<double> x = fit(pool, buildRows(train), opt);
+
+    OthelloPatterns patterns;
+    patterns.setWeights(quantize(x));
+
+    double trainRms, trainZero, holdoutRms, holdoutZero;
+    score(patterns, train, trainRms, trainZero);
+    score(patterns, holdout, holdoutRms, holdoutZero);
+    std::printf("rms error in discs: training %.3f (constant %.3f), held out %.3f (constant %.3f)\n",
+        trainRms, trainZero, holdoutRms, holdoutZero);
+
+    if(!opt.out.empty()){
+        if(!patterns.saveWeights(opt.out, &error)){
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+        std::printf("wrote %s\n", opt.out.c_str());
+    }
+
+    if(opt.check && !checkWeights(opt, x, train)) return 1;
+    return 0;
+}